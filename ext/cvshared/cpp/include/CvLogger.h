@@ -84,6 +84,11 @@ enum enLogLevel_t
 void LogMessage( enLogLevel_t aLogLevel, const char* apFormat, ... );
 void SetLogLevelLimit( enLogLevel_t aLogLevelLimit );
 
+// Whether messages of the level get logged, to skip building costly arguments for them
+bool IsLogLevelEnabled( enLogLevel_t aLogLevel );
+// Waits until the messages logged so far are written
+void FlushLogger();
+
 }
 
 #endif	/* CVLOGGER_H */
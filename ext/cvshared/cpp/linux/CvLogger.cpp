@@ -6,29 +6,697 @@
  */
 
 #include "CvLogger.h"
+#include "CvCommon.h"
 
 #include <string>
 #include <map>
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
 
 using namespace std;
 
+/*
+ * Messages are logged asynchronously. LogMessage() only copies the format and its arguments into a ring buffer of the
+ * calling thread, and a background thread formats them and writes them to syslog. Each ring has one producer - its
+ * thread - and one consumer - the logger thread - so neither side takes a lock. When a ring is full, new messages
+ * are dropped and counted, and the count is logged as soon as the logger thread catches up. The logger thread sleeps
+ * while all rings are empty, and the first message logged after that wakes it.
+ */
+
+#define RING_SIZE			(64*1024)
+#define MAX_RECORD_SIZE		(8*1024)
+#define MAX_MESSAGE_SIZE	(8*1024)
+
 namespace CvShared
 {
-	
+
 static bool				bInitialized = false;
 static string			programName;
 static enLogLevel_t		logLevelLimit = enLogLevel_None;
 
 map<enLogLevel_t, int>	mapLogLevelToSyslogLevel;
 
+enum enRecordKind_t
+{
+	enRecordKind_Args = 0,		// The format followed by its arguments
+	enRecordKind_Text,			// Formatted by the caller, for formats the logger thread cannot replay
+	enRecordKind_Padding		// Skips to the start of the ring
+};
+
+struct RecordHeader
+{
+	uint32_t	size;
+	int16_t		level;
+	uint16_t	kind;
+};
+
+struct Ring
+{
+	char			buffer[RING_SIZE];
+	size_t			head;		// Bytes ever written, only the producer changes it
+	size_t			tail;		// Bytes ever consumed, only the logger thread changes it
+	unsigned long	dropped;
+	bool			bOwned;
+	Ring*			pNext;
+};
+
+enum enArgType_t
+{
+	enArgType_None = 0,
+	enArgType_Int,
+	enArgType_Long,
+	enArgType_LongLong,
+	enArgType_Size,
+	enArgType_Intmax,
+	enArgType_Ptrdiff,
+	enArgType_Double,
+	enArgType_LongDouble,
+	enArgType_Pointer,
+	enArgType_String,
+	enArgType_Unsupported
+};
+
+struct FormatSpec
+{
+	const char*	pEnd;
+	bool		bStarWidth;
+	bool		bStarPrecision;
+	int			precision;		// -1 if there is none, and also for a '*' until EncodeArgs reads its value
+	enArgType_t	argType;
+};
+
+static Ring*			pRings = NULL;
+static pthread_mutex_t	ringsMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t	ringKey;
+static pthread_t		loggerThread;
+static bool				bLoggerRunning = false;
+static bool				bRestartAfterFork = false;
+
+static pthread_mutex_t	wakeMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	wakeCond = PTHREAD_COND_INITIALIZER;
+static bool				bLoggerIdle = false;
+
+static __thread Ring*	pThreadRing = NULL;
+static __thread char	threadRecord[MAX_RECORD_SIZE];
+
+template<typename T>
+inline T AtomicLoad( const T* apValue )
+{
+	return __atomic_load_n( apValue, __ATOMIC_ACQUIRE );
+}
+
+template<typename T>
+inline void AtomicStore( T* apValue, T aValue )
+{
+	__atomic_store_n( apValue, aValue, __ATOMIC_RELEASE );
+}
+
+inline size_t Align( size_t aSize )
+{
+	return ( aSize + 7 ) & ~(size_t)7;
+}
+
+/*
+ * printf format parsing, the same on both sides of the ring
+ */
+
+static const char* ParseFormatSpec( const char* apPercent, OUT FormatSpec& aSpec )
+{
+	const char* p = apPercent + 1;
+
+	aSpec.bStarWidth = false;
+	aSpec.bStarPrecision = false;
+	aSpec.precision = -1;
+	aSpec.argType = enArgType_Unsupported;
+
+	if ( *p == '%' )
+	{
+		aSpec.argType = enArgType_None;
+		aSpec.pEnd = p + 1;
+		return aSpec.pEnd;
+	}
+
+	while ( *p != '\0' && strchr( "-+ #0'", *p ) != NULL )
+		++p;
+
+	if ( *p == '*' )
+	{
+		aSpec.bStarWidth = true;
+		++p;
+	}
+	else
+	{
+		while ( *p >= '0' && *p <= '9' )
+			++p;
+	}
+
+	if ( *p == '.' )
+	{
+		++p;
+		if ( *p == '*' )
+		{
+			aSpec.bStarPrecision = true;
+			++p;
+		}
+		else
+		{
+			aSpec.precision = 0;
+			while ( *p >= '0' && *p <= '9' )
+			{
+				if ( aSpec.precision < MAX_RECORD_SIZE )
+					aSpec.precision = aSpec.precision * 10 + ( *p - '0' );
+				++p;
+			}
+		}
+	}
+
+	char length = '\0';
+	if ( p[0] == 'h' && p[1] == 'h' )
+	{
+		length = 'H';
+		p += 2;
+	}
+	else if ( p[0] == 'l' && p[1] == 'l' )
+	{
+		length = 'q';
+		p += 2;
+	}
+	else if ( *p != '\0' && strchr( "hlLqzjt", *p ) != NULL )
+	{
+		length = *p++;
+	}
+
+	switch ( *p )
+	{
+		case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+			switch ( length )
+			{
+				case '\0': case 'h': case 'H':	aSpec.argType = enArgType_Int; break;
+				case 'l':						aSpec.argType = enArgType_Long; break;
+				case 'q':						aSpec.argType = enArgType_LongLong; break;
+				case 'z':						aSpec.argType = enArgType_Size; break;
+				case 'j':						aSpec.argType = enArgType_Intmax; break;
+				case 't':						aSpec.argType = enArgType_Ptrdiff; break;
+			}
+			break;
+		case 'c':
+			if ( length == '\0' )
+				aSpec.argType = enArgType_Int;
+			break;
+		case 's':
+			if ( length == '\0' )
+				aSpec.argType = enArgType_String;
+			break;
+		case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+			aSpec.argType = ( length == 'L' ) ? enArgType_LongDouble : enArgType_Double;
+			break;
+		case 'p':
+			aSpec.argType = enArgType_Pointer;
+			break;
+		default:
+			// %n, %m, wide characters and the like are formatted by the caller
+			break;
+	}
+
+	aSpec.pEnd = ( *p != '\0' ) ? p + 1 : p;
+	return aSpec.pEnd;
+}
+
+/*
+ * The producer side
+ */
+
+static void ReleaseRing( void* apRing )
+{
+	pthread_mutex_lock( &ringsMutex );
+	((Ring*)apRing)->bOwned = false;
+	pthread_mutex_unlock( &ringsMutex );
+}
+
+static Ring* GetThreadRing()
+{
+	if ( pThreadRing != NULL )
+		return pThreadRing;
+
+	// Rings of finished threads are reused, so there are never more rings than threads alive at once
+	pthread_mutex_lock( &ringsMutex );
+
+	Ring* pRing = AtomicLoad( &pRings );
+	while ( pRing != NULL && pRing->bOwned )
+		pRing = pRing->pNext;
+
+	if ( pRing == NULL )
+	{
+		pRing = new Ring();
+		pRing->pNext = pRings;
+		AtomicStore( &pRings, pRing );
+	}
+	pRing->bOwned = true;
+
+	pthread_mutex_unlock( &ringsMutex );
+
+	pthread_setspecific( ringKey, pRing );
+	pThreadRing = pRing;
+	return pRing;
+}
+
+template<typename T>
+inline bool PutArg( INOUT size_t& aOffset, const T& aValue )
+{
+	if ( aOffset + sizeof(T) > MAX_RECORD_SIZE )
+		return false;
+
+	memcpy( threadRecord + aOffset, &aValue, sizeof(T) );
+	aOffset += sizeof(T);
+	return true;
+}
+
+// A non-negative aPrecision is the most characters to read, as strings with one need not be NUL-terminated
+static bool PutString( INOUT size_t& aOffset, const char* apString, int aPrecision )
+{
+	if ( apString == NULL )
+		apString = "(null)";
+
+	// Long strings are cut short, leaving room for the arguments after them
+	size_t room = MAX_RECORD_SIZE - aOffset;
+	if ( room < sizeof(uint32_t) + 64 )
+		return false;
+
+	size_t maxLen = room - sizeof(uint32_t) - 64;
+	if ( aPrecision >= 0 && (size_t)aPrecision < maxLen )
+		maxLen = aPrecision;
+
+	uint32_t len = (uint32_t)strnlen( apString, maxLen );
+	PutArg( aOffset, len );
+	memcpy( threadRecord + aOffset, apString, len );
+	threadRecord[aOffset + len] = '\0';
+	aOffset += len + 1;
+	return true;
+}
+
+// Copies the format and the arguments after the record header, returns the record size or 0 if it cannot be done
+static size_t EncodeArgs( const char* apFormat, va_list aArgs )
+{
+	size_t offset = sizeof(RecordHeader);
+	size_t formatLen = strlen( apFormat ) + 1;
+	if ( offset + formatLen > MAX_RECORD_SIZE )
+		return 0;
+
+	memcpy( threadRecord + offset, apFormat, formatLen );
+	offset += formatLen;
+
+	for ( const char* p = strchr( apFormat, '%' ); p != NULL; p = strchr( p, '%' ) )
+	{
+		FormatSpec spec;
+		p = ParseFormatSpec( p, spec );
+
+		bool bOk = true;
+		if ( spec.bStarWidth )
+			bOk = bOk && PutArg( offset, va_arg( aArgs, int ) );
+		if ( spec.bStarPrecision )
+		{
+			spec.precision = va_arg( aArgs, int );
+			bOk = bOk && PutArg( offset, spec.precision );
+		}
+
+		switch ( spec.argType )
+		{
+			case enArgType_None:		break;
+			case enArgType_Int:			bOk = bOk && PutArg( offset, va_arg( aArgs, int ) ); break;
+			case enArgType_Long:		bOk = bOk && PutArg( offset, va_arg( aArgs, long ) ); break;
+			case enArgType_LongLong:	bOk = bOk && PutArg( offset, va_arg( aArgs, long long ) ); break;
+			case enArgType_Size:		bOk = bOk && PutArg( offset, va_arg( aArgs, size_t ) ); break;
+			case enArgType_Intmax:		bOk = bOk && PutArg( offset, va_arg( aArgs, intmax_t ) ); break;
+			case enArgType_Ptrdiff:		bOk = bOk && PutArg( offset, va_arg( aArgs, ptrdiff_t ) ); break;
+			case enArgType_Double:		bOk = bOk && PutArg( offset, va_arg( aArgs, double ) ); break;
+			case enArgType_LongDouble:	bOk = bOk && PutArg( offset, va_arg( aArgs, long double ) ); break;
+			case enArgType_Pointer:		bOk = bOk && PutArg( offset, va_arg( aArgs, void* ) ); break;
+			case enArgType_String:		bOk = bOk && PutString( offset, va_arg( aArgs, const char* ), spec.precision ); break;
+			default:					bOk = false; break;
+		}
+
+		if ( !bOk )
+			return 0;
+	}
+
+	return offset;
+}
+
+static bool PushRecord( Ring* apRing, enLogLevel_t aLogLevel, enRecordKind_t aKind, size_t aSize )
+{
+	RecordHeader* pHeader = (RecordHeader*)threadRecord;
+	pHeader->size = (uint32_t)Align( aSize );
+	pHeader->level = (int16_t)aLogLevel;
+	pHeader->kind = (uint16_t)aKind;
+
+	size_t head = apRing->head;
+	size_t freeBytes = RING_SIZE - ( head - AtomicLoad( &apRing->tail ) );
+	size_t pos = head % RING_SIZE;
+	size_t contiguous = RING_SIZE - pos;
+
+	// A record is never split, the rest of the ring is skipped instead
+	size_t padding = ( pHeader->size > contiguous ) ? contiguous : 0;
+	if ( freeBytes < padding + pHeader->size )
+		return false;
+
+	if ( padding > 0 )
+	{
+		RecordHeader* pPadding = (RecordHeader*)( apRing->buffer + pos );
+		pPadding->size = (uint32_t)padding;
+		pPadding->level = 0;
+		pPadding->kind = enRecordKind_Padding;
+		pos = 0;
+	}
+
+	memcpy( apRing->buffer + pos, threadRecord, aSize );
+	AtomicStore( &apRing->head, head + padding + pHeader->size );
+	return true;
+}
+
+static void WakeLogger()
+{
+	// Pairs with the fence in LoggerThread(): either this sees the logger idle, or the logger sees the new record.
+	// The logger is only idle when all rings are empty, so it is woken once per ring that becomes non-empty.
+	__atomic_thread_fence( __ATOMIC_SEQ_CST );
+	if ( !AtomicLoad( &bLoggerIdle ) )
+		return;
+
+	pthread_mutex_lock( &wakeMutex );
+	pthread_cond_signal( &wakeCond );
+	pthread_mutex_unlock( &wakeMutex );
+}
+
+/*
+ * The logger thread
+ */
+
+class CMessage
+{
+public:
+	CMessage() : m_len(0) { m_text[0] = '\0'; }
+
+	void Clear()
+	{
+		m_len = 0;
+		m_text[0] = '\0';
+	}
+
+	void Append( const char* apText, size_t aLen )
+	{
+		if ( aLen > sizeof(m_text) - 1 - m_len )
+			aLen = sizeof(m_text) - 1 - m_len;
+		memcpy( m_text + m_len, apText, aLen );
+		m_len += aLen;
+		m_text[m_len] = '\0';
+	}
+
+	template<typename T>
+	void AppendFormatted( const char* apSpec, const T& aValue )
+	{
+		int len = snprintf( m_text + m_len, sizeof(m_text) - m_len, apSpec, aValue );
+		if ( len > 0 )
+			m_len += ( (size_t)len < sizeof(m_text) - m_len ) ? (size_t)len : sizeof(m_text) - 1 - m_len;
+	}
+
+	const char* Get() const		{ return m_text; }
+
+private:
+	char	m_text[MAX_MESSAGE_SIZE];
+	size_t	m_len;
+};
+
+template<typename T>
+inline T GetArg( INOUT const char*& apArgs )
+{
+	T value;
+	memcpy( &value, apArgs, sizeof(T) );
+	apArgs += sizeof(T);
+	return value;
+}
+
+static void DecodeArgs( const char* apRecord, OUT CMessage& aMessage )
+{
+	const char* pFormat = apRecord;
+	const char* pArgs = pFormat + strlen( pFormat ) + 1;
+
+	const char* p = pFormat;
+	while ( *p != '\0' )
+	{
+		const char* pPercent = strchr( p, '%' );
+		if ( pPercent == NULL )
+		{
+			aMessage.Append( p, strlen( p ) );
+			break;
+		}
+		aMessage.Append( p, pPercent - p );
+
+		FormatSpec spec;
+		p = ParseFormatSpec( pPercent, spec );
+		if ( spec.argType == enArgType_None )
+		{
+			aMessage.Append( "%", 1 );
+			continue;
+		}
+
+		// The spec on its own, with the '*' width and precision replaced by their values
+		char specStr[64];
+		size_t specLen = 0;
+		for ( const char* s = pPercent; s < spec.pEnd && specLen < sizeof(specStr) - 16; ++s )
+		{
+			if ( *s != '*' )
+			{
+				specStr[specLen++] = *s;
+				continue;
+			}
+
+			int value = GetArg<int>( pArgs );
+			bool bPrecision = ( s > pPercent && s[-1] == '.' );
+			if ( bPrecision && value < 0 )
+			{
+				// A negative precision is taken as if it was omitted
+				--specLen;
+				continue;
+			}
+			specLen += snprintf( specStr + specLen, sizeof(specStr) - specLen, "%d", value );
+		}
+		specStr[specLen] = '\0';
+
+		switch ( spec.argType )
+		{
+			case enArgType_Int:			aMessage.AppendFormatted( specStr, GetArg<int>( pArgs ) ); break;
+			case enArgType_Long:		aMessage.AppendFormatted( specStr, GetArg<long>( pArgs ) ); break;
+			case enArgType_LongLong:	aMessage.AppendFormatted( specStr, GetArg<long long>( pArgs ) ); break;
+			case enArgType_Size:		aMessage.AppendFormatted( specStr, GetArg<size_t>( pArgs ) ); break;
+			case enArgType_Intmax:		aMessage.AppendFormatted( specStr, GetArg<intmax_t>( pArgs ) ); break;
+			case enArgType_Ptrdiff:		aMessage.AppendFormatted( specStr, GetArg<ptrdiff_t>( pArgs ) ); break;
+			case enArgType_Double:		aMessage.AppendFormatted( specStr, GetArg<double>( pArgs ) ); break;
+			case enArgType_LongDouble:	aMessage.AppendFormatted( specStr, GetArg<long double>( pArgs ) ); break;
+			case enArgType_Pointer:		aMessage.AppendFormatted( specStr, GetArg<void*>( pArgs ) ); break;
+			case enArgType_String:
+			{
+				uint32_t len = GetArg<uint32_t>( pArgs );
+				aMessage.AppendFormatted( specStr, pArgs );
+				pArgs += len + 1;
+				break;
+			}
+			default:
+				return;
+		}
+	}
+}
+
+// Returns true if there was anything to log
+static bool DrainRings()
+{
+	// Only the logger thread formats messages
+	static CMessage message;
+	bool bWork = false;
+
+	for ( Ring* pRing = AtomicLoad( &pRings ); pRing != NULL; pRing = pRing->pNext )
+	{
+		size_t tail = pRing->tail;
+		size_t head = AtomicLoad( &pRing->head );
+
+		while ( tail != head )
+		{
+			const RecordHeader* pHeader = (const RecordHeader*)( pRing->buffer + tail % RING_SIZE );
+			const char* pData = (const char*)( pHeader + 1 );
+
+			if ( pHeader->kind != enRecordKind_Padding )
+			{
+				message.Clear();
+				if ( pHeader->kind == enRecordKind_Args )
+					DecodeArgs( pData, message );
+				else
+					message.Append( pData, strlen( pData ) );
+
+				syslog( mapLogLevelToSyslogLevel[(enLogLevel_t)pHeader->level], "%s", message.Get() );
+			}
+
+			tail += pHeader->size;
+			AtomicStore( &pRing->tail, tail );
+			bWork = true;
+		}
+
+		unsigned long dropped = __atomic_exchange_n( &pRing->dropped, 0, __ATOMIC_RELAXED );
+		if ( dropped > 0 )
+		{
+			syslog( LOG_WARNING, "%lu log messages were dropped, the logger could not keep up", dropped );
+			bWork = true;
+		}
+	}
+
+	return bWork;
+}
+
+static bool RingsEmpty()
+{
+	for ( Ring* pRing = AtomicLoad( &pRings ); pRing != NULL; pRing = pRing->pNext )
+	{
+		if ( AtomicLoad( &pRing->head ) != pRing->tail || AtomicLoad( &pRing->dropped ) > 0 )
+			return false;
+	}
+
+	return true;
+}
+
+static void* LoggerThread( void* )
+{
+	while ( AtomicLoad( &bLoggerRunning ) )
+	{
+		if ( DrainRings() )
+			continue;
+
+		pthread_mutex_lock( &wakeMutex );
+
+		AtomicStore( &bLoggerIdle, true );
+		__atomic_thread_fence( __ATOMIC_SEQ_CST );
+
+		if ( AtomicLoad( &bLoggerRunning ) && RingsEmpty() )
+			pthread_cond_wait( &wakeCond, &wakeMutex );
+
+		AtomicStore( &bLoggerIdle, false );
+
+		pthread_mutex_unlock( &wakeMutex );
+	}
+
+	DrainRings();
+	return NULL;
+}
+
+static bool RunLoggerThread()
+{
+	AtomicStore( &bLoggerRunning, true );
+	if ( pthread_create( &loggerThread, NULL, LoggerThread, NULL ) != 0 )
+	{
+		AtomicStore( &bLoggerRunning, false );
+		return false;
+	}
+
+	return true;
+}
+
+static void StopLogger()
+{
+	if ( !AtomicLoad( &bLoggerRunning ) )
+		return;
+
+	// Messages logged from here on, e.g. by static destructors, are written synchronously
+	AtomicStore( &bLoggerRunning, false );
+
+	pthread_mutex_lock( &wakeMutex );
+	pthread_cond_signal( &wakeCond );
+	pthread_mutex_unlock( &wakeMutex );
+
+	pthread_join( loggerThread, NULL );
+}
+
+/*
+ * fork() support. Only the forking thread exists in the child, so the child has no logger thread and owns no ring but
+ * its own. The records still in the rings are the parent's to log. The logger thread of the child is started by the
+ * first message it logs, as starting threads in the fork handler is not safe.
+ */
+
+static void LockBeforeFork()
+{
+	pthread_mutex_lock( &ringsMutex );
+	pthread_mutex_lock( &wakeMutex );
+}
+
+static void UnlockAfterFork()
+{
+	pthread_mutex_unlock( &wakeMutex );
+	pthread_mutex_unlock( &ringsMutex );
+}
+
+static void ResetAfterFork()
+{
+	pthread_cond_init( &wakeCond, NULL );
+	bLoggerIdle = false;
+
+	for ( Ring* pRing = pRings; pRing != NULL; pRing = pRing->pNext )
+	{
+		pRing->tail = pRing->head;
+		pRing->dropped = 0;
+		pRing->bOwned = ( pRing == pThreadRing );
+	}
+
+	if ( bLoggerRunning )
+	{
+		bLoggerRunning = false;
+		bRestartAfterFork = true;
+	}
+
+	UnlockAfterFork();
+}
+
+// Returns true if messages can be queued for the logger thread
+static bool RestartAfterFork()
+{
+	if ( !AtomicLoad( &bRestartAfterFork ) )
+		return false;
+
+	pthread_mutex_lock( &ringsMutex );
+
+	if ( AtomicLoad( &bRestartAfterFork ) )
+	{
+		RunLoggerThread();
+		AtomicStore( &bRestartAfterFork, false );
+	}
+
+	pthread_mutex_unlock( &ringsMutex );
+
+	return AtomicLoad( &bLoggerRunning );
+}
+
+static void StartLogger()
+{
+	static bool bStarted = false;
+	if ( bStarted )
+		return;
+	bStarted = true;
+
+	pthread_key_create( &ringKey, ReleaseRing );
+
+	if ( !RunLoggerThread() )
+		return;
+
+	pthread_atfork( LockBeforeFork, UnlockAfterFork, ResetAfterFork );
+	atexit( StopLogger );
+}
+
 bool InitLogger( const char* apProgramName, enLogLevel_t aLogLevelLimit, enLogFacility_t aFacility )
 {
 	programName = apProgramName;
 	logLevelLimit = aLogLevelLimit;
-	
+
 	mapLogLevelToSyslogLevel[enLogLevel_Fatal] = LOG_CRIT;
 	mapLogLevelToSyslogLevel[enLogLevel_Error] = LOG_ERR;
 	mapLogLevelToSyslogLevel[enLogLevel_Warning] = LOG_WARNING;
@@ -36,10 +704,12 @@ bool InitLogger( const char* apProgramName, enLogLevel_t aLogLevelLimit, enLogFa
 	mapLogLevelToSyslogLevel[enLogLevel_Info] = LOG_INFO;
 	mapLogLevelToSyslogLevel[enLogLevel_Debug1] = LOG_DEBUG;
 	mapLogLevelToSyslogLevel[enLogLevel_Debug2] = LOG_DEBUG;
-	mapLogLevelToSyslogLevel[enLogLevel_Debug3] = LOG_DEBUG;	
-	
+	mapLogLevelToSyslogLevel[enLogLevel_Debug3] = LOG_DEBUG;
+
 	openlog( programName.c_str(), LOG_NDELAY|LOG_PID, aFacility );
-	
+
+	StartLogger();
+
 	bInitialized = true;
 
 	return true;
@@ -50,37 +720,88 @@ void LogMessage( enLogLevel_t aLogLevel, const char* apFormat, ... )
 	if ( !bInitialized )
 	{
 		printf( "WARNING: Logger not initialized yet\n" );
-		
+
 		va_list args;
 		va_start( args, apFormat );
-		
+
 		vprintf( apFormat, args );
 		printf( "\n" );
-		
+
 		va_end( args );
 		return;
 	}
-	
+
 	if ( aLogLevel == enLogLevel_None || aLogLevel > logLevelLimit )
 		return;
-	
+
 	if ( mapLogLevelToSyslogLevel.count( aLogLevel ) < 1 )
 	{
 		printf( "ERROR: LogMessage() called with invalid level [%d]\n", aLogLevel );
 		return;
 	}
-	
+
 	va_list args;
 	va_start( args, apFormat );
 
-	vsyslog( mapLogLevelToSyslogLevel[aLogLevel], apFormat, args );
-	
+	if ( !AtomicLoad( &bLoggerRunning ) && !RestartAfterFork() )
+	{
+		vsyslog( mapLogLevelToSyslogLevel[aLogLevel], apFormat, args );
+		va_end( args );
+		return;
+	}
+
+	Ring* pRing = GetThreadRing();
+
+	va_list argsCopy;
+	va_copy( argsCopy, args );
+
+	enRecordKind_t kind = enRecordKind_Args;
+	size_t size = EncodeArgs( apFormat, argsCopy );
+	if ( size == 0 )
+	{
+		kind = enRecordKind_Text;
+		char* pText = threadRecord + sizeof(RecordHeader);
+		size_t room = MAX_RECORD_SIZE - sizeof(RecordHeader);
+		int len = vsnprintf( pText, room, apFormat, args );
+		size = sizeof(RecordHeader) + ( ( len < 0 ) ? 0 : ( (size_t)len < room ) ? (size_t)len : room - 1 ) + 1;
+		if ( len < 0 )
+			pText[0] = '\0';
+	}
+
+	va_end( argsCopy );
 	va_end( args );
+
+	if ( !PushRecord( pRing, aLogLevel, kind, size ) )
+		__atomic_fetch_add( &pRing->dropped, 1, __ATOMIC_RELAXED );
+
+	WakeLogger();
+}
+
+bool IsLogLevelEnabled( enLogLevel_t aLogLevel )
+{
+	if ( !bInitialized )
+		return true;
+
+	return aLogLevel != enLogLevel_None && aLogLevel <= logLevelLimit;
+}
+
+void FlushLogger()
+{
+	if ( !AtomicLoad( &bLoggerRunning ) )
+		return;
+
+	struct timespec wait = { 0, 1000000L };
+
+	for ( Ring* pRing = AtomicLoad( &pRings ); pRing != NULL; pRing = pRing->pNext )
+	{
+		size_t head = AtomicLoad( &pRing->head );
+		while ( (ptrdiff_t)( head - AtomicLoad( &pRing->tail ) ) > 0 && AtomicLoad( &bLoggerRunning ) )
+			nanosleep( &wait, NULL );
+	}
 }
 
 void SetLogLevelLimit( enLogLevel_t aLogLevelLimit )
 {
 	logLevelLimit = aLogLevelLimit;
-}
-	
+}	
 }
\ No newline at end of file
@@ -216,6 +216,26 @@ void SetLogLevelLimit( enLogLevel_t aLogLevelLimit )
 	logLevelLimit = aLogLevelLimit;
 }
 
+bool IsLogLevelEnabled( enLogLevel_t aLogLevel )
+{
+	CvMutexLock lock(mutex);
+
+	// Before initialization everything is printed
+	if ( !bInitialized )
+		return true;
+
+	return ( aLogLevel != enLogLevel_None && aLogLevel <= logLevelLimit );
+}
+
+void FlushLogger()
+{
+	// Messages are written synchronously here
+	CvMutexLock lock(mutex);
+
+	if ( logFile.is_open() )
+		logFile.flush();
+}
+
 string LevelStr( enLogLevel_t aLevel )
 {
 	switch( aLevel )
@@ -21,12 +21,19 @@ under the License.
 /*
  * Implementation of the NIST Advanced Ecryption Standard
  *
+ * On x86 CPUs with the AES instructions the block functions use them instead
+ * of the lookup tables - faster, and free of key dependent memory accesses.
+ *
  * SU=m, SU is Stack Usage 
  */
 
 #include <stdlib.h> 
 #include "clint.h"
 
+#ifdef CLINT_X86
+#include <immintrin.h>
+#endif
+
 /* this is fixed */
 #define NB 4
 #define ROUNDS 10
@@ -324,8 +331,8 @@ void AES_init(aes* a,int mode,char *key,char *iv)
 }
 
 /* SU= 80 */
-/* Encrypt a single block */
-void AES_ecb_encrypt(aes *a,uchar *buff)
+/* Encrypt a single block - table version */
+static void ecb_encrypt_c(aes *a,uchar *buff)
 {
     int i,j,k;
     unsign32 p[4],q[4],*x,*y,*t;
@@ -391,8 +398,8 @@ void AES_ecb_encrypt(aes *a,uchar *buff)
 }
 
 /* SU= 80 */
-/* Decrypt a single block */
-void AES_ecb_decrypt(aes *a,uchar *buff)
+/* Decrypt a single block - table version */
+static void ecb_decrypt_c(aes *a,uchar *buff)
 {
     int i,j,k;
     unsign32 p[4],q[4],*x,*y,*t;
@@ -458,6 +465,106 @@ void AES_ecb_decrypt(aes *a,uchar *buff)
 
 }
 
+#ifdef CLINT_X86
+
+/* The round keys are packed little-endian, so in memory they are already in the byte order the AES instructions expect.
+   rkey is the key schedule of the equivalent inverse cipher, which is just what AESDEC wants */
+
+/* Encrypt nblocks blocks - AES instructions. Four blocks are kept in flight to hide the instruction latency */
+CLINT_TARGET("aes,sse2")
+static void ecb_encrypt_ni(aes *a,uchar *buff,int nblocks)
+{
+    int i;
+    __m128i k,b0,b1,b2,b3;
+    const __m128i *key=(const __m128i *)a->fkey;
+    __m128i *x=(__m128i *)buff;
+
+    for (;nblocks>=4;nblocks-=4,x+=4)
+    {
+        k=_mm_loadu_si128(&key[0]);
+        b0=_mm_xor_si128(_mm_loadu_si128(&x[0]),k);
+        b1=_mm_xor_si128(_mm_loadu_si128(&x[1]),k);
+        b2=_mm_xor_si128(_mm_loadu_si128(&x[2]),k);
+        b3=_mm_xor_si128(_mm_loadu_si128(&x[3]),k);
+        for (i=1;i<ROUNDS;i++)
+        {
+            k=_mm_loadu_si128(&key[i]);
+            b0=_mm_aesenc_si128(b0,k);
+            b1=_mm_aesenc_si128(b1,k);
+            b2=_mm_aesenc_si128(b2,k);
+            b3=_mm_aesenc_si128(b3,k);
+        }
+        k=_mm_loadu_si128(&key[ROUNDS]);
+        _mm_storeu_si128(&x[0],_mm_aesenclast_si128(b0,k));
+        _mm_storeu_si128(&x[1],_mm_aesenclast_si128(b1,k));
+        _mm_storeu_si128(&x[2],_mm_aesenclast_si128(b2,k));
+        _mm_storeu_si128(&x[3],_mm_aesenclast_si128(b3,k));
+    }
+    for (;nblocks>0;nblocks--,x++)
+    {
+        b0=_mm_xor_si128(_mm_loadu_si128(x),_mm_loadu_si128(&key[0]));
+        for (i=1;i<ROUNDS;i++)
+            b0=_mm_aesenc_si128(b0,_mm_loadu_si128(&key[i]));
+        _mm_storeu_si128(x,_mm_aesenclast_si128(b0,_mm_loadu_si128(&key[ROUNDS])));
+    }
+}
+
+/* Decrypt a single block - AES instructions */
+CLINT_TARGET("aes,sse2")
+static void ecb_decrypt_ni(aes *a,uchar *buff)
+{
+    int i;
+    __m128i b;
+    const __m128i *key=(const __m128i *)a->rkey;
+
+    b=_mm_xor_si128(_mm_loadu_si128((__m128i *)buff),_mm_loadu_si128(&key[0]));
+    for (i=1;i<ROUNDS;i++)
+        b=_mm_aesdec_si128(b,_mm_loadu_si128(&key[i]));
+    _mm_storeu_si128((__m128i *)buff,_mm_aesdeclast_si128(b,_mm_loadu_si128(&key[ROUNDS])));
+}
+
+#endif
+
+/* Encrypt a single block */
+void AES_ecb_encrypt(aes *a,uchar *buff)
+{
+#ifdef CLINT_X86
+    if (CPU_features()&CPU_AESNI)
+    {
+        ecb_encrypt_ni(a,buff,1);
+        return;
+    }
+#endif
+    ecb_encrypt_c(a,buff);
+}
+
+/* Encrypt n consecutive blocks in place. Much faster than block by block with the AES instructions */
+void AES_ecb_encrypt_blocks(aes *a,uchar *buff,int n)
+{
+    int i;
+#ifdef CLINT_X86
+    if (CPU_features()&CPU_AESNI)
+    {
+        ecb_encrypt_ni(a,buff,n);
+        return;
+    }
+#endif
+    for (i=0;i<n;i++) ecb_encrypt_c(a,&buff[16*i]);
+}
+
+/* Decrypt a single block */
+void AES_ecb_decrypt(aes *a,uchar *buff)
+{
+#ifdef CLINT_X86
+    if (CPU_features()&CPU_AESNI)
+    {
+        ecb_decrypt_ni(a,buff);
+        return;
+    }
+#endif
+    ecb_decrypt_c(a,buff);
+}
+
 /* SU= 40 */
 /* Encrypt using selected mode of operation */
 unsign32 AES_encrypt(aes* a,char *buff)
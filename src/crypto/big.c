@@ -365,6 +365,18 @@ void BIG_dsub(DBIG c,DBIG a,DBIG b)
 }
 
 
+/* Set c=a+b */
+void BIG_dadd(DBIG c,DBIG a,DBIG b)
+{
+	int i;
+	for (i=0;i<DNLEN;i++)
+		c[i]=a[i]+b[i];
+#ifdef DEBUG_NORM
+	c[DNLEN]=a[DNLEN]+b[DNLEN]+1;
+	if (c[DNLEN]>=NEXCESS) printf("add problem - digit overflow %d\n",c[DNLEN]);
+#endif
+}
+
 /* Set c=c-1 */
 void BIG_dec(BIG c,int d)
 {
@@ -1021,40 +1033,31 @@ int BIG_lastbits(BIG a,int n)
 /* get 8*MODBYTES size random number */
 void BIG_random(BIG m,csprng *rng)
 {
-	int i,b,j=0,r=0;
+	int i;
+	char b[MODBYTES];
 
-	BIG_zero(m);
 /* generate random BIG */ 
-	for (i=0;i<8*MODBYTES;i++) 
-	{
-		if (j==0) r=RAND_byte(rng);
-		else r>>=1;
-		b=r&1;
-		BIG_shl(m,1); m[0]+=b; 
-		j++; j&=7; 
-	}
-
-#ifdef DEBUG_NORM
-	m[NLEN]=0;
-#endif
+	RAND_bytes(rng,b,MODBYTES);
+	BIG_fromBytes(m,b);
+	for (i=0;i<MODBYTES;i++) b[i]=0;
 }
 
-/* get random BIG from rng, modulo q. Done one bit at a time, so its portable */
+/* get random BIG from rng, modulo q. Takes 2*MODBITS random bits, so reduction leaves negligible bias */
 
 void BIG_randomnum(BIG m,BIG q,csprng *rng)
 {
-	int i,b,j=0,r=0;
+	int i,k,n=2*MODBITS;
+	char b[2*MODBYTES];
 	DBIG d;
 	BIG_dzero(d);
 /* generate random DBIG */ 
-	for (i=0;i<2*MODBITS;i++)
+	RAND_bytes(rng,b,(n+7)/8);
+	for (i=0;i<n;i+=8)
 	{
-		if (j==0) r=RAND_byte(rng);
-		else r>>=1;
-		b=r&1;
-		BIG_dshl(d,1); d[0]+=b; 
-		j++; j&=7; 
+		k=n-i; if (k>8) k=8;
+		BIG_dshl(d,k); d[0]+=(int)((unsigned char)b[i/8]>>(8-k));
 	}
+	for (i=0;i<2*MODBYTES;i++) b[i]=0;
 /* reduce modulo a BIG. Removes bias */	
 	BIG_dmod(m,d,q);
 #ifdef DEBUG_NORM
@@ -1141,6 +1144,186 @@ int BIG_jacobi(BIG a,BIG p)
 	else return -1;
 }
 
+#if CHUNK==64 && defined(dchunk)
+
+/* Constant time inversion - see Bernstein & Yang, "Fast constant-time gcd computation and modular inversion", TCHES 2019.
+   Numbers are held in SLEN signed limbs of SBITS bits. Each batch of SBITS divsteps works on the bottom word of f and g
+   only, and gives a 2x2 transition matrix scaled by 2^SBITS, which is then applied to the full numbers */
+
+#define SBITS 62
+#define SLEN ((NLEN*BASEBITS)/SBITS+1)
+#define SMASK (((chunk)1<<SBITS)-1)
+
+/* normalised BIG to signed limbs */
+static void big_to_s(chunk *r,BIG a)
+{
+	int i,j=0,n=0;
+	dchunk w=0;
+	for (i=0;i<NLEN;i++)
+	{
+		w+=(dchunk)a[i]<<n;
+		n+=BASEBITS;
+		if (n>=SBITS)
+		{
+			r[j++]=(chunk)w&SMASK;
+			w>>=SBITS; n-=SBITS;
+		}
+	}
+	while (j<SLEN)
+	{
+		r[j++]=(chunk)w&SMASK;
+		w>>=SBITS;
+	}
+}
+
+/* non-negative signed limbs to BIG */
+static void s_to_big(BIG r,chunk *a)
+{
+	int i,j=0,n=0;
+	dchunk w=0;
+	for (i=0;i<SLEN;i++)
+	{
+		w+=(dchunk)a[i]<<n;
+		n+=SBITS;
+		while (n>=BASEBITS && j<NLEN)
+		{
+			r[j++]=(chunk)w&MASK;
+			w>>=BASEBITS; n-=BASEBITS;
+		}
+	}
+	while (j<NLEN)
+	{
+		r[j++]=(chunk)w&MASK;
+		w>>=BASEBITS;
+	}
+}
+
+/* SBITS divsteps on the bottom bits of f and g. t=[u,v,q,r] such that 2^SBITS.[f,g]'=[[u,v],[q,r]].[f,g]. Returns new delta */
+static chunk divsteps(chunk delta,chunk f0,chunk g0,chunk *t)
+{
+	int i;
+	uint64_t f=f0,g=g0,u=1,v=0,q=0,r=1,c,x;
+
+	for (i=0;i<SBITS;i++)
+	{
+/* if delta>0 and g is odd, (delta,f,g)=(-delta,g,-f) */
+		c=(uint64_t)((-delta)>>(CHUNK-1))&(0-(g&1));
+		x=(f^g)&c; f^=x; g^=x; g=(g^c)-c;
+		x=(u^q)&c; u^=x; q^=x; q=(q^c)-c;
+		x=(v^r)&c; v^=x; r^=x; r=(r^c)-c;
+		delta=(delta^(chunk)c)-(chunk)c;
+		delta++;
+/* if g is odd, g=g+f. Then g=g/2 */
+		c=0-(g&1);
+		g+=f&c; q+=u&c; r+=v&c;
+		g>>=1; u<<=1; v<<=1;
+	}
+	t[0]=(chunk)u; t[1]=(chunk)v; t[2]=(chunk)q; t[3]=(chunk)r;
+	return delta;
+}
+
+/* [f,g]=t.[f,g]/2^SBITS, which is exact */
+static void update_fg(chunk *f,chunk *g,chunk *t)
+{
+	int i;
+	dchunk cf,cg;
+	cf=(dchunk)t[0]*f[0]+(dchunk)t[1]*g[0];
+	cg=(dchunk)t[2]*f[0]+(dchunk)t[3]*g[0];
+	cf>>=SBITS; cg>>=SBITS;
+	for (i=1;i<SLEN;i++)
+	{
+		cf+=(dchunk)t[0]*f[i]+(dchunk)t[1]*g[i];
+		cg+=(dchunk)t[2]*f[i]+(dchunk)t[3]*g[i];
+		f[i-1]=(chunk)cf&SMASK; cf>>=SBITS;
+		g[i-1]=(chunk)cg&SMASK; cg>>=SBITS;
+	}
+	f[SLEN-1]=(chunk)cf;
+	g[SLEN-1]=(chunk)cg;
+}
+
+/* [d,e]=t.[d,e]/2^SBITS mod m. Multiples of m are added to make the division exact, and to keep d and e in (-2m,m) */
+static void update_de(chunk *d,chunk *e,chunk *t,chunk *m,chunk minv)
+{
+	int i;
+	chunk md,me,sd,se;
+	dchunk cd,ce;
+
+	sd=d[SLEN-1]>>(CHUNK-1);
+	se=e[SLEN-1]>>(CHUNK-1);
+	md=(t[0]&sd)+(t[1]&se);
+	me=(t[2]&sd)+(t[3]&se);
+	cd=(dchunk)t[0]*d[0]+(dchunk)t[1]*e[0];
+	ce=(dchunk)t[2]*d[0]+(dchunk)t[3]*e[0];
+	md-=(chunk)(((uint64_t)minv*(uint64_t)cd+(uint64_t)md)&SMASK);
+	me-=(chunk)(((uint64_t)minv*(uint64_t)ce+(uint64_t)me)&SMASK);
+	cd+=(dchunk)m[0]*md;
+	ce+=(dchunk)m[0]*me;
+	cd>>=SBITS; ce>>=SBITS;
+	for (i=1;i<SLEN;i++)
+	{
+		cd+=(dchunk)t[0]*d[i]+(dchunk)t[1]*e[i]+(dchunk)m[i]*md;
+		ce+=(dchunk)t[2]*d[i]+(dchunk)t[3]*e[i]+(dchunk)m[i]*me;
+		d[i-1]=(chunk)cd&SMASK; cd>>=SBITS;
+		e[i-1]=(chunk)ce&SMASK; ce>>=SBITS;
+	}
+	d[SLEN-1]=(chunk)cd;
+	e[SLEN-1]=(chunk)ce;
+}
+
+/* bring d from (-2m,m) to [0,m), negating it if sign<0 */
+static void normalize(chunk *d,chunk sign,chunk *m)
+{
+	int i;
+	chunk c;
+
+	c=d[SLEN-1]>>(CHUNK-1);
+	for (i=0;i<SLEN;i++) d[i]+=m[i]&c;
+	c=sign>>(CHUNK-1);
+	for (i=0;i<SLEN;i++) d[i]=(d[i]^c)-c;
+	for (i=0;i<SLEN-1;i++) {d[i+1]+=d[i]>>SBITS; d[i]&=SMASK;}
+
+	c=d[SLEN-1]>>(CHUNK-1);
+	for (i=0;i<SLEN;i++) d[i]+=m[i]&c;
+	for (i=0;i<SLEN-1;i++) {d[i+1]+=d[i]>>SBITS; d[i]&=SMASK;}
+}
+
+/* Set r=1/a mod p, for odd p. Constant time */
+void BIG_invmodp(BIG r,BIG a,BIG p)
+{
+	int i,n;
+	uint64_t x;
+	chunk delta=1,t[4];
+	chunk f[SLEN],g[SLEN],d[SLEN],e[SLEN],m[SLEN];
+
+	BIG_mod(a,p);
+	big_to_s(m,p);
+	big_to_s(f,p);
+	big_to_s(g,a);
+	for (i=0;i<SLEN;i++) d[i]=e[i]=0;
+	e[0]=1;
+
+/* 1/p mod 2^SBITS, by Newton iteration */
+	x=(uint64_t)m[0];
+	for (i=0;i<5;i++) x*=2-(uint64_t)m[0]*x;
+	x&=SMASK;
+
+/* enough divsteps for any input of the size of p - the number depends only on p */
+	n=BIG_nbits(p);
+	n=(49*n+80)/17;
+	for (i=0;i<n;i+=SBITS)
+	{
+		delta=divsteps(delta,f[0],g[0],t);
+		update_de(d,e,t,m,(chunk)x);
+		update_fg(f,g,t);
+	}
+
+/* now f=+1 or -1, and d.a=f mod p */
+	normalize(d,f[SLEN-1],m);
+	s_to_big(r,d);
+}
+
+#else
+
 /* Set r=1/a mod p. Binary method */
 /* SU= 240 */
 void BIG_invmodp(BIG r,BIG a,BIG p)
@@ -1205,3 +1388,5 @@ void BIG_invmodp(BIG r,BIG a,BIG p)
 	else
 		BIG_copy(r,x2);
 }
+
+#endif
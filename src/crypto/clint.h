@@ -93,7 +93,9 @@ under the License.
 
 #include "platform.h"
 
+#ifndef CHUNK
 #define CHUNK WORD_LENGTH /* size of chunk in bits = wordlength of computer = 16, 32 or 64. Note not all curve options are supported on 16-bit processors - see rom.c */
+#endif /* a smaller CHUNK can be defined to build the arithmetic of 32-bit targets on a 64-bit host */
 #define CHOICE  FIELD_CHOICE   /* Current choice of Field */
 /* For some moduli only WEIERSTRASS curves are supported. For others there is a choice of WEIERSTRASS, EDWARDS or MONTGOMERY curves. See above. */
 #define CURVETYPE CURVE_TYPE /* Note that not all curve types are supported - see above */
@@ -103,6 +105,10 @@ under the License.
 #define USE_GLV		/* Note this method is patented (GLV), so maybe you want to comment this out */
 #define USE_GS_G2	/* Well we didn't patent it :) But may be covered by GLV patent :( */
 #define USE_GS_GT   /* Not patented, so probably always use this */
+/* #define USE_SW_MAP */	/* Hash identities to G1 with the Shallue-van de Woestijne encoding, one square root for any identity, instead of try-and-increment. Changes the mapping, so clients, servers and the D-TA must all agree */
+
+/* Random number generator */
+#define USE_CTR_DRBG	/* AES-128 CTR_DRBG (NIST SP800-90A) with block output. Comment out for the original Marsaglia-Zaman/SHA-256 generator */
 
 /* Finite field support - for RSA, DH etc. */
 #define FF_BITS 2048 /* Finite Field Size in bits - must be 256.2^n */
@@ -227,6 +233,27 @@ extern int tdadd,rdadd,tdneg,rdneg;
 #endif
 
 #define DCHUNK 2*CHUNK
+
+/* Per-thread storage, for generators and values cached by the library */
+#if defined(_MSC_VER)
+#define CLINT_THREAD_LOCAL __declspec(thread)
+#else
+#define CLINT_THREAD_LOCAL __thread
+#endif
+
+/* x86 instruction set extensions, detected at run time - see cpu.c */
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CLINT_X86
+#define CLINT_TARGET(t) __attribute__((target(t)))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define CLINT_X86
+#define CLINT_TARGET(t)
+#endif
+
+#define CPU_SHANI  1
+#define CPU_AVX2   2
+#define CPU_AESNI  4
+#define CPU_PCLMUL 8
 #define DNLEN 2*NLEN  /* double length required for products of BIGs */
 
 #ifdef dchunk
@@ -266,6 +293,10 @@ typedef chunk DBIG[DNLEN];
 /* Field Params - see rom.c */
 extern const BIG Modulus;  /* Actual Modulus set in rom.c */
 extern const chunk MConst; /* Montgomery only - 1/p mod 2^BASEBITS */
+#if CHOICE==BNCX
+#define SQRT_CHAIN
+extern const sign8 Sqrt_Chain[]; /* addition chain for (p+1)/4 */
+#endif
 
 /* Curve Params - see rom.c */
 extern const int CURVE_A;
@@ -320,6 +351,12 @@ FP2 a;
 FP2 b;
 } FP4;
 
+/* unreduced FP2 product, for lazy reduction */
+typedef struct {
+DBIG a;
+DBIG b;
+} DFP2;
+
 typedef struct {
 FP4 a;
 FP4 b;
@@ -374,6 +411,7 @@ char f[16];
 
 typedef struct {
 unsign32 table[128][4]; /* 2k bytes */
+uchar Hpow[4][16];      /* H,H^2,H^3,H^4 for the carry-less multiply GHASH */
 uchar stateX[16];
 uchar Y_0[16];
 unsign32 counter;
@@ -390,6 +428,14 @@ aes a;
 
 /* Cryptographically strong pseudo-random number generator */
 
+#ifdef USE_CTR_DRBG
+typedef struct {
+aes a;             /* keyed with the DRBG key */
+char V[16];        /* DRBG counter */
+int pool_ptr;
+char pool[32];    /* random pool */
+} csprng;
+#else
 typedef struct {
 unsign32 ira[NK];  /* random number...   */
 int      rndptr;   /* ...array & pointer */
@@ -397,6 +443,7 @@ unsign32 borrow;
 int pool_ptr;
 char pool[32];    /* random pool */
 } csprng;
+#endif
 
 
 /* portable representation of a big positive number */
@@ -473,6 +520,7 @@ extern void BIG_add(BIG,BIG,BIG);
 extern void BIG_inc(BIG,int);
 extern void BIG_sub(BIG,BIG,BIG);
 extern void BIG_dsub(DBIG,DBIG,DBIG);
+extern void BIG_dadd(DBIG,DBIG,DBIG);
 extern void BIG_dec(BIG,int);
 extern void BIG_imul(BIG,BIG,int);
 extern chunk BIG_pmul(BIG,BIG,int);
@@ -496,7 +544,7 @@ extern int BIG_nbits(BIG);
 extern int BIG_dnbits(DBIG);
 extern void BIG_mod(BIG,BIG);
 extern void BIG_sdiv(BIG,BIG);
-extern void BIG_dmod(DBIG,DBIG,BIG);
+extern void BIG_dmod(BIG,DBIG,BIG);
 extern void BIG_ddiv(BIG,DBIG,BIG);
 extern int BIG_parity(BIG);
 extern int BIG_bit(BIG,int);
@@ -525,6 +573,7 @@ extern void FP_sub(BIG,BIG,BIG);
 extern void FP_div2(BIG,BIG);
 extern void FP_pow(BIG,BIG,BIG);
 extern void FP_sqrt(BIG,BIG);
+extern int FP_sqrt_qr(BIG,BIG);
 extern void FP_neg(BIG,BIG);
 extern void FP_output(BIG);
 extern void FP_rawoutput(BIG);
@@ -552,6 +601,11 @@ extern void FP2_pmul(FP2 *,FP2 *,BIG);
 extern void FP2_imul(FP2 *,FP2 *,int);
 extern void FP2_sqr(FP2 *,FP2 *);
 extern void FP2_mul(FP2 *,FP2 *,FP2 *);
+extern void FP2_mul_nr(DFP2 *,FP2 *,FP2 *);
+extern void FP2_dadd(DFP2 *,DFP2 *,DFP2 *);
+extern void FP2_dsub(DFP2 *,DFP2 *,DFP2 *);
+extern void FP2_dmul_ip(DFP2 *);
+extern void FP2_dmod(FP2 *,DFP2 *);
 extern void FP2_output(FP2 *);
 extern void FP2_rawoutput(FP2 *);
 extern void FP2_inv(FP2 *,FP2 *);
@@ -580,9 +634,13 @@ extern int ECP_set(ECP *,BIG,BIG);
 extern int ECP_get(BIG,BIG,ECP *);
 #endif
 extern void ECP_affine(ECP *P);
+extern void ECP_batch_affine(int,ECP *,BIG *);
 extern void ECP_outputz(ECP *);
 extern void ECP_output(ECP *);
 extern void ECP_toOctet(octet *,ECP *);
+#if CURVETYPE!=MONTGOMERY
+extern void ECP_toOctetC(octet *,ECP *); /* compressed form 0x02|0x03,x */
+#endif
 extern int ECP_fromOctet(ECP *,octet *);
 extern void ECP_dbl(ECP *);
 
@@ -602,6 +660,7 @@ extern void ECP2_copy(ECP2 *,ECP2 *);
 extern void ECP2_inf(ECP2 *);
 extern int ECP2_equals(ECP2 *,ECP2 *);
 extern void ECP2_affine(ECP2 *);
+extern void ECP2_batch_affine(int,ECP2 *,FP2 *);
 extern void ECP2_get(FP2 *,FP2 *,ECP2 *);
 extern void ECP2_output(ECP2 *);
 extern void ECP2_outputxyz(ECP2 *);
@@ -666,6 +725,7 @@ extern void FP12_smul(FP12 *,FP12 *);
 extern void FP12_mul(FP12 *,FP12*);
 extern void FP12_inv(FP12 *,FP12 *);
 extern void FP12_pow(FP12*,FP12*,BIG);
+extern void FP12_compow(FP12*,FP12*,BIG);
 extern void FP12_pinpow(FP12*,int,int);
 extern void FP12_pow4(FP12*,FP12*,BIG *);
 extern void FP12_frob(FP12*,FP2*);
@@ -765,10 +825,16 @@ extern void OCT_jint(octet *,int,int);
 extern void OCT_rand(octet *,csprng *,int);
 extern void OCT_shl(octet *,int);
 
+/* CPU feature detection */
+extern int CPU_features(void);
+extern int CPU_limit(int);
+
 /* Hash function */
 extern void HASH_init(hash *);
 extern void HASH_process(hash *,int);
+extern void HASH_update(hash *,const char *,int);
 extern void HASH_hash(hash *,char *);
+extern void HASH_multi(int,char **,int *,char **);
 
 
 /* AES functions */
@@ -776,6 +842,7 @@ extern void AES_reset(aes *,int,char *);
 extern void AES_getreg(aes *,char *);
 extern void AES_init(aes* ,int,char *,char *);
 extern void AES_ecb_encrypt(aes *,uchar *);
+extern void AES_ecb_encrypt_blocks(aes *,uchar *,int);
 extern void AES_ecb_decrypt(aes *,uchar *);
 extern unsign32 AES_encrypt(aes* ,char *);
 extern unsign32 AES_decrypt(aes *,char *);
@@ -792,5 +859,11 @@ extern void GCM_finish(gcm *,char *);
 extern void RAND_seed(csprng *,int,char *);
 extern void RAND_clean(csprng *);
 extern int RAND_byte(csprng *);
+extern void RAND_bytes(csprng *,char *,int);
+extern void RAND_fork(csprng *,csprng *);
+
+/* rand_os.c - operating system entropy and per-thread generators */
+extern int RAND_os_entropy(char *,int);
+extern int RAND_thread_fork(csprng *);
 
 #endif
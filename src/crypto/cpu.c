@@ -0,0 +1,98 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+
+/*
+ *   Run time detection of the x86 instruction set extensions used by the
+ *   hash, AES and GCM modules. Other architectures get the portable code.
+ */
+
+#include "clint.h"
+
+#ifdef CLINT_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+static void cpuid(unsigned int leaf,unsigned int sub,unsigned int r[4])
+{
+#if defined(_MSC_VER)
+    int x[4];
+    __cpuidex(x,(int)leaf,(int)sub);
+    r[0]=x[0]; r[1]=x[1]; r[2]=x[2]; r[3]=x[3];
+#else
+    if (!__get_cpuid_count(leaf,sub,&r[0],&r[1],&r[2],&r[3])) r[0]=r[1]=r[2]=r[3]=0;
+#endif
+}
+#endif
+
+static int allowed=-1;
+
+/* Returns a mask of the CPU_* extensions available. The answer is worked out once and cached */
+int CPU_features(void)
+{
+    static int features=-1;
+#ifdef CLINT_X86
+    unsigned int r0[4],r1[4],r7[4],xcr0=0;
+    int f=0;
+    if (features>=0) return features&allowed;
+
+    cpuid(0,0,r0);
+    if (r0[0]>=1)
+    {
+        cpuid(1,0,r1);
+        /* AES and carry-less multiply, with the SSSE3 byte shuffles used around them */
+        if ((r1[2]&(1u<<25)) && (r1[2]&(1u<<9))) f|=CPU_AESNI;
+        if ((r1[2]&(1u<<1)) && (r1[2]&(1u<<9))) f|=CPU_PCLMUL;
+    }
+    if (r0[0]>=7)
+    {
+        cpuid(7,0,r7);
+        /* SHA extensions, with the SSSE3 and SSE4.1 instructions used around them */
+        if ((r7[1]&(1u<<29)) && (r1[2]&(1u<<9)) && (r1[2]&(1u<<19))) f|=CPU_SHANI;
+        /* AVX2, and the OS saves the YMM registers */
+        if (r1[2]&(1u<<27))
+        {
+#if defined(_MSC_VER)
+            xcr0=(unsigned int)_xgetbv(0);
+#else
+            unsigned int hi;
+            __asm__ __volatile__("xgetbv" : "=a"(xcr0), "=d"(hi) : "c"(0));
+#endif
+            if ((r7[1]&(1u<<5)) && (xcr0&6)==6) f|=CPU_AVX2;
+        }
+    }
+    features=f;
+    return f&allowed;
+#else
+    features=0;
+    return features;
+#endif
+}
+
+/* Limits CPU_features() to the extensions in mask and returns the previous limit, so tests can run the portable code on any CPU */
+int CPU_limit(int mask)
+{
+    int previous=allowed;
+    allowed=mask;
+    return previous;
+}
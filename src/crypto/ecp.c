@@ -336,15 +336,12 @@ int ECP_set(ECP *P,BIG x,BIG y)
 /* SU=136 */
 int ECP_setx(ECP *P,BIG x,int s)
 {
-	BIG t,rhs,m;
-	BIG_rcopy(m,Modulus);
+	BIG rhs;
 
 	BIG_copy(rhs,x);
 	FP_nres(rhs);
 	ECP_rhs(rhs,rhs);
-	BIG_copy(t,rhs);
-	FP_redc(t);
-	if (BIG_jacobi(t,m)!=1)
+	if (!FP_sqrt_qr(P->y,rhs))
 	{
 		ECP_inf(P);
 		return 0;
@@ -354,7 +351,6 @@ int ECP_setx(ECP *P,BIG x,int s)
 #endif
 	BIG_copy(P->x,x); FP_nres(P->x);
 
-	FP_sqrt(P->y,rhs);
 	BIG_copy(rhs,P->y);
 	FP_redc(rhs);
 	if (BIG_parity(rhs)!=s)
@@ -420,6 +416,57 @@ void ECP_affine(ECP *P)
 	BIG_copy(P->z,one);
 }
 
+/* Convert n points to Affine with a single inversion - Montgomery's trick. Points at infinity are left alone.
+   Requires work vector of n BIGs */
+void ECP_batch_affine(int n,ECP P[],BIG work[])
+{
+#if CURVETYPE==WEIERSTRASS
+	int i,j;
+	BIG one,iz,izn;
+
+/* work[i] is the product of the z coordinates of the points up to i that need converting, or zero if P[i] does not */
+	FP_one(one);
+	j=-1;
+	for (i=0;i<n;i++)
+	{
+		if (ECP_isinf(&P[i]) || BIG_comp(P[i].z,one)==0)
+		{
+			BIG_zero(work[i]);
+			continue;
+		}
+		if (j<0) BIG_copy(work[i],P[i].z);
+		else FP_mul(work[i],work[j],P[i].z);
+		j=i;
+	}
+	if (j<0) return;
+
+	FP_inv(izn,work[j]);
+
+	for (i=j;i>=0;i--)
+	{
+		if (BIG_iszilch(work[i])) continue;
+		for (j=i-1;j>=0 && BIG_iszilch(work[j]);j--) ;
+		if (j>=0)
+		{ /* 1/z[i] = work[j]/work[i], and then izn=1/work[j] */
+			FP_mul(iz,izn,work[j]);
+			FP_mul(izn,izn,P[i].z);
+		}
+		else BIG_copy(iz,izn);
+
+		FP_sqr(work[i],iz);
+		FP_mul(P[i].x,P[i].x,work[i]);
+		FP_mul(work[i],work[i],iz);
+		FP_mul(P[i].y,P[i].y,work[i]);
+		FP_reduce(P[i].x);
+		FP_reduce(P[i].y);
+		BIG_copy(P[i].z,one);
+	}
+#else
+	int i;
+	for (i=0;i<n;i++) ECP_affine(&P[i]);
+#endif
+}
+
 /* SU=120 */
 void ECP_outputz(ECP *P)
 {
@@ -481,8 +528,19 @@ void ECP_toOctet(octet *W,ECP *P)
 #endif
 }
 
+#if CURVETYPE!=MONTGOMERY
+/* Convert P to compressed octet string 0x02|0x03,x - the low bit of the prefix is the parity of y */
+void ECP_toOctetC(octet *W,ECP *P)
+{
+	BIG x,y;
+	ECP_get(x,y,P);
+	W->len=MODBYTES+1; W->val[0]=2+BIG_parity(y);
+	BIG_toBytes(&(W->val[1]),x);
+}
+#endif
+
 /* SU=88 */
-/* Restore P from octet string */
+/* Restore P from octet string, compressed or not */
 int ECP_fromOctet(ECP *P,octet *W)
 {
 #if CURVETYPE==MONTGOMERY
@@ -492,6 +550,11 @@ int ECP_fromOctet(ECP *P,octet *W)
 	return 0;
 #else
 	BIG x,y;
+	if ((W->val[0]==2 || W->val[0]==3) && W->len==MODBYTES+1)
+	{
+		BIG_fromBytes(x,&(W->val[1]));
+		return ECP_setx(P,x,W->val[0]&1);
+	}
 	BIG_fromBytes(x,&(W->val[1]));
 	BIG_fromBytes(y,&(W->val[MODBYTES+1]));
     if (ECP_set(P,x,y)) return 1;
@@ -1029,7 +1092,7 @@ void ECP_mul2(ECP *P,ECP *Q,BIG e,BIG f)
 		ECP_add(P,&T);
 	}
 	ECP_sub(P,&C); /* apply correction */
-	ECP_affine(P);
+/* P is left in projective coordinates, so that several results can be normalised together */
 }
 
 #endif
@@ -134,6 +134,52 @@ void ECP2_affine(ECP2 *P)
 	FP2_copy(&(P->z),&one);
 }
 
+/* Convert n points to Affine with a single inversion - Montgomery's trick. Points at infinity are left alone.
+   Requires work vector of n FP2s */
+void ECP2_batch_affine(int n,ECP2 P[],FP2 work[])
+{
+	int i,j;
+	FP2 iz,izn;
+
+/* work[i] is the product of the z coordinates of the points up to i that need converting, or zero if P[i] does not */
+	j=-1;
+	for (i=0;i<n;i++)
+	{
+		if (P[i].inf || FP2_isunity(&(P[i].z)))
+		{
+			ECP2_affine(&P[i]);
+			FP2_zero(&work[i]);
+			continue;
+		}
+		if (j<0) FP2_copy(&work[i],&(P[i].z));
+		else FP2_mul(&work[i],&work[j],&(P[i].z));
+		j=i;
+	}
+	if (j<0) return;
+
+	FP2_inv(&izn,&work[j]);
+
+	for (i=j;i>=0;i--)
+	{
+		if (BIG_iszilch(work[i].a) && BIG_iszilch(work[i].b)) continue;
+		for (j=i-1;j>=0 && BIG_iszilch(work[j].a) && BIG_iszilch(work[j].b);j--) ;
+		if (j>=0)
+		{ /* 1/z[i] = work[j]/work[i], and then izn=1/work[j] */
+			FP2_mul(&iz,&izn,&work[j]);
+			FP2_mul(&izn,&izn,&(P[i].z));
+		}
+		else FP2_copy(&iz,&izn);
+
+		FP2_sqr(&work[i],&iz);
+		FP2_mul(&(P[i].x),&(P[i].x),&work[i]);
+		FP2_mul(&work[i],&work[i],&iz);
+		FP2_mul(&(P[i].y),&(P[i].y),&work[i]);
+		FP2_reduce(&(P[i].x));
+		FP2_reduce(&(P[i].y));
+		FP2_one(&(P[i].z));
+	}
+}
+
 /* extract x, y from point P */
 /* SU= 16 */
 void ECP2_get(FP2 *x,FP2 *y,ECP2 *P)
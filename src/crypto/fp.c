@@ -109,9 +109,8 @@ void FP_mod(BIG a,DBIG d)
 
 #if MODTYPE == NOT_SPECIAL
 
-/* convert BIG a to Montgomery n-residue form */
-/* SU= 120 */
-void FP_nres(BIG a)
+/* a=a.R mod p by long division */
+static void nres_dmod(BIG a)
 {
 	DBIG d;
 	BIG m;
@@ -121,6 +120,23 @@ void FP_nres(BIG a)
 	BIG_dmod(a,d,m);
 }
 
+/* convert BIG a to Montgomery n-residue form */
+/* Montgomery multiplication by R^2 mod p, which is worked out once per thread */
+void FP_nres(BIG a)
+{
+	DBIG d;
+	static CLINT_THREAD_LOCAL BIG r2;
+	static CLINT_THREAD_LOCAL int set=0;
+	if (!set)
+	{
+		BIG_one(r2); nres_dmod(r2); nres_dmod(r2);
+		set=1;
+	}
+	BIG_mul(d,a,r2);
+	FP_mod(a,d);
+	FP_reduce(a);
+}
+
 /* SU= 80 */
 /* convert back to regular form */
 void FP_redc(BIG a)
@@ -423,7 +439,15 @@ void FP_inv(BIG w,BIG x)
 /* set n=1 */
 void FP_one(BIG n)
 {
-	BIG_one(n); FP_nres(n);
+/* the point arithmetic asks for this all the time, so it is worked out once per thread */
+	static CLINT_THREAD_LOCAL BIG one;
+	static CLINT_THREAD_LOCAL int set=0;
+	if (!set)
+	{
+		BIG_one(one); FP_nres(one);
+		set=1;
+	}
+	BIG_copy(n,one);
 }
 
 /* Set r=a^b mod Modulus */
@@ -463,6 +487,51 @@ int FP_qr(BIG r)
 
 }
 
+/* r=a^((p+1)/4) */
+static void FP_pow_sqrt(BIG r,BIG a)
+{
+#ifdef SQRT_CHAIN
+	int i;
+	BIG t[16],a2;
+
+	FP_sqr(a2,a);
+	BIG_copy(t[0],a);
+	for (i=1;i<16;i++) FP_mul(t[i],t[i-1],a2);   /* t[i]=a^(2i+1) */
+
+	BIG_copy(r,t[Sqrt_Chain[1]/2]);
+	for (i=2;Sqrt_Chain[i]!=0;i+=2)
+	{
+		int n=Sqrt_Chain[i];
+		while (n--) FP_sqr(r,r);
+		if (Sqrt_Chain[i+1]) FP_mul(r,r,t[Sqrt_Chain[i+1]/2]);
+	}
+	FP_reduce(r);
+#else
+	BIG b;
+	BIG_rcopy(b,Modulus);
+	BIG_inc(b,1); BIG_norm(b); BIG_fshr(b,2); /* (p+1)/4 */
+	FP_pow(r,a,b);
+#endif
+}
+
+/* Set r=sqrt(a) if a is a QR, and return 1. Else return 0. Cheaper than FP_qr followed by FP_sqrt */
+int FP_sqrt_qr(BIG r,BIG a)
+{
+	BIG s,t;
+	if (MOD8==5)
+	{
+		if (!FP_qr(a)) return 0;
+		FP_sqrt(r,a);
+		return 1;
+	}
+	BIG_copy(s,a);
+	FP_pow_sqrt(r,s);
+	FP_sqr(t,r);
+	FP_reduce(t);
+	FP_reduce(s);
+	return (BIG_comp(t,s)==0);
+}
+
 /* Set a=sqrt(b) mod Modulus */
 /* SU= 160 */
 void FP_sqrt(BIG r,BIG a)
@@ -483,10 +552,7 @@ void FP_sqrt(BIG r,BIG a)
 		BIG_mod(r,m);
 	}
 	if (MOD8==3 || MOD8==7)
-	{
-		BIG_inc(b,1); BIG_norm(b); BIG_fshr(b,2); /* (p+1)/4 */
-		FP_pow(r,a,b);
-	}
+		FP_pow_sqrt(r,a);
 }
 
 /*
@@ -335,6 +335,190 @@ void FP12_pinpow(FP12 *r,int e,int bts)
 	FP12_copy(r,&R[0]);
 }
 
+/* Compressed squaring in the cyclotomic subgroup - see Karabina, "Squaring in cyclotomic subgroups", Math. Comp. 82 (2013)
+   Over FP2 an FP12 element is a+b.w+c.w^2 with a=g0+g1.i, b=g2+g3.i, c=g4+g5.i, in Karabina's numbering. In the
+   cyclotomic subgroup it is determined by g2..g5, which can be squared on their own in 6 FP2 products.
+   Before it can be multiplied the element must be decompressed, and that needs an inversion */
+
+#define CPOW_BATCH 8	/* decompressions sharing one inversion */
+
+/* c[0..3]=g2..g5 */
+static void FP12_compress(FP2 *c,FP12 *x)
+{
+	FP2_copy(&c[0],&(x->b).a);
+	FP2_copy(&c[1],&(x->b).b);
+	FP2_copy(&c[2],&(x->c).a);
+	FP2_copy(&c[3],&(x->c).b);
+}
+
+/* square compressed element */
+/* h2=2(g2+3.xi.g4.g5), h3=3(g4^2+xi.g5^2)-2.g3, h4=3(g2^2+xi.g3^2)-2.g4, h5=2(g5+3.g2.g3) */
+static void FP12_csqr(FP2 *c)
+{
+	FP2 s23,s45,b23,b45,t;
+
+	FP2_mul(&b23,&c[0],&c[1]);
+	FP2_mul(&b45,&c[2],&c[3]);
+
+	FP2_sqr(&s23,&c[0]);
+	FP2_sqr(&t,&c[1]);
+	FP2_mul_ip(&t);
+	FP2_add(&s23,&s23,&t); FP2_norm(&s23);
+
+	FP2_sqr(&s45,&c[2]);
+	FP2_sqr(&t,&c[3]);
+	FP2_mul_ip(&t);
+	FP2_add(&s45,&s45,&t); FP2_norm(&s45);
+
+/* multiplications by small constants are done with additions, which are much cheaper here */
+/* Every sum is normalised, as 32-bit chunks have room for only NEXCESS unnormalised additions */
+	FP2_mul_ip(&b45);
+	FP2_add(&t,&b45,&b45); FP2_norm(&t);
+	FP2_add(&t,&t,&b45); FP2_norm(&t);
+	FP2_add(&c[0],&c[0],&t); FP2_norm(&c[0]);
+	FP2_add(&c[0],&c[0],&c[0]); FP2_norm(&c[0]);
+
+	FP2_add(&t,&s45,&s45); FP2_norm(&t);
+	FP2_add(&s45,&t,&s45); FP2_norm(&s45);
+	FP2_add(&t,&c[1],&c[1]); FP2_norm(&t);
+	FP2_sub(&c[1],&s45,&t); FP2_norm(&c[1]);
+
+	FP2_add(&t,&s23,&s23); FP2_norm(&t);
+	FP2_add(&s23,&t,&s23); FP2_norm(&s23);
+	FP2_add(&t,&c[2],&c[2]); FP2_norm(&t);
+	FP2_sub(&c[2],&s23,&t); FP2_norm(&c[2]);
+
+	FP2_add(&t,&b23,&b23); FP2_norm(&t);
+	FP2_add(&t,&t,&b23); FP2_norm(&t);
+	FP2_add(&c[3],&c[3],&t); FP2_norm(&c[3]);
+	FP2_add(&c[3],&c[3],&c[3]); FP2_norm(&c[3]);
+}
+
+/* Decompress n elements c[i] into r[i], with a single inversion */
+/* g1=(xi.g5^2+3.g4^2-2.g3)/(4.g2), or g1=2.g4.g5/g3 if g2=0, and g0=xi.(2.g1^2+g2.g5-3.g3.g4)+1 */
+static void FP12_decompress(FP12 *r,FP2 (*c)[4],int n)
+{
+	int i;
+	FP2 num[CPOW_BATCH],den[CPOW_BATCH],acc[CPOW_BATCH];
+	FP2 t,inv,one;
+
+	FP2_one(&one);
+	for (i=0;i<n;i++)
+	{
+		FP2_reduce(&c[i][0]);
+		if (!FP2_iszilch(&c[i][0]))
+		{
+			FP2_sqr(&num[i],&c[i][3]);
+			FP2_mul_ip(&num[i]);
+			FP2_sqr(&t,&c[i][2]);
+			FP2_imul(&t,&t,3);
+			FP2_add(&num[i],&num[i],&t); FP2_norm(&num[i]);
+			FP2_add(&t,&c[i][1],&c[i][1]); FP2_norm(&t);
+			FP2_sub(&num[i],&num[i],&t);
+			FP2_imul(&den[i],&c[i][0],4);
+		}
+		else
+		{
+			FP2_mul(&num[i],&c[i][2],&c[i][3]);
+			FP2_add(&num[i],&num[i],&num[i]);
+			FP2_copy(&den[i],&c[i][1]);
+		}
+		FP2_norm(&num[i]);
+		FP2_reduce(&den[i]);
+		if (FP2_iszilch(&den[i]))
+		{ /* only for the identity */
+			FP2_zero(&num[i]);
+			FP2_one(&den[i]);
+		}
+	}
+
+/* Montgomery's trick - acc[i]=den[0]...den[i] */
+	FP2_copy(&acc[0],&den[0]);
+	for (i=1;i<n;i++) FP2_mul(&acc[i],&acc[i-1],&den[i]);
+	FP2_inv(&inv,&acc[n-1]);
+	for (i=n-1;i>0;i--)
+	{
+		FP2_mul(&t,&inv,&acc[i-1]);  /* 1/den[i] */
+		FP2_mul(&inv,&inv,&den[i]);
+		FP2_mul(&num[i],&num[i],&t);
+	}
+	FP2_mul(&num[0],&num[0],&inv);
+
+	for (i=0;i<n;i++)
+	{ /* num[i] is now g1 */
+		FP2_sqr(&t,&num[i]);
+		FP2_add(&t,&t,&t);
+		FP2_mul(&inv,&c[i][0],&c[i][3]);
+		FP2_add(&t,&t,&inv); FP2_norm(&t);
+		FP2_mul(&inv,&c[i][1],&c[i][2]);
+		FP2_imul(&inv,&inv,3);
+		FP2_sub(&t,&t,&inv);
+		FP2_mul_ip(&t);
+		FP2_add(&t,&t,&one);
+
+		FP2_copy(&(r[i].a).a,&t);
+		FP2_copy(&(r[i].a).b,&num[i]);
+		FP2_copy(&(r[i].b).a,&c[i][0]);
+		FP2_copy(&(r[i].b).b,&c[i][1]);
+		FP2_copy(&(r[i].c).a,&c[i][2]);
+		FP2_copy(&(r[i].c).b,&c[i][3]);
+		FP12_norm(&r[i]);
+	}
+}
+
+/* set r=a^b for a unitary element a, such as one in the cyclotomic subgroup after the easy part of the final exponentiation */
+/* Squarings are compressed. b is recoded in NAF, since a^-1 is just the conjugate */
+/* Note this is not side-channel safe either */
+void FP12_compow(FP12 *r,FP12 *a,BIG b)
+{
+	int i,n,d,sign[CPOW_BATCH];
+	FP2 c[4],s[CPOW_BATCH][4];
+	FP12 w,t[CPOW_BATCH];
+	BIG z;
+
+	FP12_copy(&w,a);
+	FP12_compress(c,&w);
+	BIG_copy(z,b);
+	BIG_norm(z);
+	FP12_one(r);
+
+	for (i=n=0;!BIG_iszilch(z);i++)
+	{
+		if (BIG_parity(z))
+		{
+			d=2-BIG_lastbits(z,2);  /* 1 or -1 */
+			if (d>0) BIG_dec(z,1);
+			else BIG_inc(z,1);
+			BIG_norm(z);
+			if (i==0)
+			{
+				if (d<0) FP12_conj(&w,&w);
+				FP12_copy(r,&w);
+			}
+			else
+			{
+				FP2_copy(&s[n][0],&c[0]); FP2_copy(&s[n][1],&c[1]);
+				FP2_copy(&s[n][2],&c[2]); FP2_copy(&s[n][3],&c[3]);
+				sign[n++]=d;
+			}
+		}
+		BIG_fshr(z,1);
+		if (n==CPOW_BATCH || (BIG_iszilch(z) && n>0))
+		{
+			FP12_decompress(t,s,n);
+			for (d=0;d<n;d++)
+			{
+				if (sign[d]<0) FP12_conj(&t[d],&t[d]);
+				FP12_mul(r,&t[d]);
+			}
+			n=0;
+		}
+		if (!BIG_iszilch(z)) FP12_csqr(c);
+	}
+
+	FP12_reduce(r);
+}
+
 /* SU= 528 */
 /* set r=a^b */
 /* Note this is simple square and multiply, so not side-channel safe */
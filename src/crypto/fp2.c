@@ -202,29 +202,103 @@ void FP2_sqr(FP2 *w,FP2 *x)
 }
 
 
-/* Set w=x*y */
+/* Lazy reduction - see Aranha et al., "Faster Explicit Formulas for Computing Pairings over Ordinary Curves", Eurocrypt 2011
+   Products of FP2s are kept as unreduced DBIGs, and only the final sums of them are reduced. FP_mod maps a DBIG d to
+   about d/R+p, where R=2^(BASEBITS*NLEN), so these sums are kept below a small multiple of p.R. Differences are kept
+   positive by adding a multiple of p.R, which is 0 mod p */
+
+/* r=a-b+m.p.R, where b<m.p.R */
+/* 32-bit chunks have no room for m.p on top of unnormalised digits, so a-b is normalised first and m.p is added normalised */
+static void dsubm(DBIG r,DBIG a,DBIG b,int m)
+{
+	int i;
+#if CHUNK<64
+	BIG mp;
+	BIG_rcopy(mp,Modulus);
+	BIG_imul(mp,mp,m);
+	BIG_norm(mp);
+	BIG_dsub(r,a,b);
+	BIG_dnorm(r);
+	for (i=0;i<NLEN;i++) r[NLEN+i]+=mp[i];
+#else
+	for (i=0;i<NLEN;i++)
+	{
+		r[i]=a[i]-b[i];
+		r[NLEN+i]=a[NLEN+i]-b[NLEN+i]+m*Modulus[i];
+	}
+#endif
+}
+
+/* Set w=x*y, unreduced. w->a<2p.R and w->b<p.R */
 /* SU= 168 */
-void FP2_mul(FP2 *w,FP2 *x,FP2 *y)
+void FP2_mul_nr(DFP2 *w,FP2 *x,FP2 *y)
 {
-	BIG w1,w2,w5,mw;
+	BIG s,t;
+	DBIG d;
+
+#if CHUNK<64
+	FP2_norm(x); FP2_norm(y);  /* the sums of unnormalised FP2s that FP4_mul makes would overflow s and t */
+#endif
+	BIG_add(s,x->a,x->b); BIG_norm(s);
+	BIG_add(t,y->a,y->b); BIG_norm(t);
+	if ((EXCESS(s)+1)*(EXCESS(t)+1)>=FEXCESS/2)  /* all products must be < p.R */
+	{
+#ifdef DEBUG_REDUCE
+		printf("Product too large - reducing it %d %d\n",EXCESS(s),EXCESS(t));
+#endif
+		FP2_reduce(x); FP2_reduce(y);
+		BIG_add(s,x->a,x->b); BIG_norm(s);
+		BIG_add(t,y->a,y->b); BIG_norm(t);
+	}
 
-	FP_mul(w1,x->a,y->a);  /* norms x  */
-	FP_mul(w2,x->b,y->b);  /* and y */
+	BIG_mul(d,x->b,y->b);
+	BIG_mul(w->b,s,t);
+	BIG_mul(w->a,x->a,y->a);
 
-	FP_add(w5,x->a,x->b);  
+	BIG_dsub(w->b,w->b,w->a);
+	BIG_dsub(w->b,w->b,d);
+	dsubm(w->a,w->a,d,1);
+}
 
-	FP_add(w->b,y->a,y->b); 
+/* Set w=x+y, unreduced */
+void FP2_dadd(DFP2 *w,DFP2 *x,DFP2 *y)
+{
+	BIG_dadd(w->a,x->a,y->a);
+	BIG_dadd(w->b,x->b,y->b);
+}
 
-	FP_mul(w->b,w->b,w5);   
-	FP_add(mw,w1,w2);       
-	FP_neg(mw,mw);          
+/* Set w=x-y, unreduced. y must be < 4p.R, as any FP2_mul_nr result is */
+void FP2_dsub(DFP2 *w,DFP2 *x,DFP2 *y)
+{
+	dsubm(w->a,x->a,y->a,4);
+	dsubm(w->b,x->b,y->b,4);
+}
 
-	FP_add(w->b,w->b,mw);   
-	FP_add(mw,w1,mw);      
-	FP_add(w->a,w1,mw);    
+/* Set w*=(1+sqrt(-1)), unreduced. w->b must be < 4p.R */
+void FP2_dmul_ip(DFP2 *w)
+{
+	DBIG t;
+	BIG_dcopy(t,w->a);
+	dsubm(w->a,w->a,w->b,4);
+	BIG_dadd(w->b,w->b,t);
+}
 
-	FP2_norm(w);
+/* Reduce w to x. w is destroyed */
+void FP2_dmod(FP2 *w,DFP2 *x)
+{
+	BIG_dnorm(x->a);
+	BIG_dnorm(x->b);
+	FP_mod(w->a,x->a);
+	FP_mod(w->b,x->b);
+}
 
+/* Set w=x*y */
+/* SU= 168 */
+void FP2_mul(FP2 *w,FP2 *x,FP2 *y)
+{
+	DFP2 d;
+	FP2_mul_nr(&d,x,y);
+	FP2_dmod(w,&d);
 }
 
 /* output FP2 in hex format [a,b] */
@@ -350,12 +424,11 @@ int FP2_sqrt(FP2 *w,FP2 *u)
 	FP_sqr(w1,w->b);
 	FP_sqr(w2,w->a);
 	FP_add(w1,w1,w2);
-	if (!FP_qr(w1)) 
+	if (!FP_sqrt_qr(w1,w1)) 
 	{
 		FP2_zero(w);
 		return 0;
 	}
-	FP_sqrt(w1,w1);
 	FP_add(w2,w->a,w1); 
 	FP_div2(w2,w2);
 	if (!FP_qr(w2))
@@ -207,24 +207,23 @@ void FP4_sqr(FP4 *w,FP4 *x)
 /* SU= 312 */
 void FP4_mul(FP4 *w,FP4 *x,FP4 *y)
 {
-
-	FP2 t1,t2,t3,t4;
-	FP2_mul(&t1,&(x->a),&(y->a)); /* norms x */
-	FP2_mul(&t2,&(x->b),&(y->b)); /* and y */
-	FP2_add(&t3,&(y->b),&(y->a)); 
-	FP2_add(&t4,&(x->b),&(x->a)); 
-
-
-	FP2_mul(&t4,&t4,&t3); /* (xa+xb)(ya+yb) */
-	FP2_sub(&t4,&t4,&t1);    
-#if CHUNK<64
-	FP2_norm(&t4);
-#endif
-	FP2_sub(&(w->b),&t4,&t2); 
-	FP2_mul_ip(&t2);
-	FP2_add(&(w->a),&t2,&t1);
-
-	FP4_norm(w);
+	FP2 t1,t2;
+	DFP2 d0,d1,d2;
+
+/* products are combined unreduced, so 4 reductions are needed rather than 6 */
+	FP2_mul_nr(&d0,&(x->a),&(y->a));
+	FP2_mul_nr(&d1,&(x->b),&(y->b));
+	FP2_add(&t1,&(x->a),&(x->b));
+	FP2_add(&t2,&(y->a),&(y->b));
+	FP2_mul_nr(&d2,&t1,&t2); /* (xa+xb)(ya+yb) */
+
+	FP2_dsub(&d2,&d2,&d0);
+	FP2_dsub(&d2,&d2,&d1);
+	FP2_dmul_ip(&d1);
+	FP2_dadd(&d0,&d0,&d1);
+
+	FP2_dmod(&(w->a),&d0);
+	FP2_dmod(&(w->b),&d2);
 }
 
 /* output FP4 in format [a,b] */
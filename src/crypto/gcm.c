@@ -36,6 +36,10 @@ under the License.
  * 6. call GCM_finish to extract the tag.
  *
  * See http://www.mindspring.com/~dmcgrew/gcm-nist-6.pdf
+ *
+ * On x86 CPUs with the carry-less multiply instruction GHASH is computed with
+ * PCLMULQDQ, reducing once per 4 blocks against precomputed powers of H.
+ * Whole blocks of plain/ciphertext are encrypted 4 at a time in counter mode.
  */
 /* SU=m, m is Stack Usage */
 
@@ -43,6 +47,10 @@ under the License.
 #include <string.h>
 #include "clint.h"
 
+#ifdef CLINT_X86
+#include <immintrin.h>
+#endif
+
 #define NB 4
 #define MR_TOBYTE(x) ((uchar)((x)))
 
@@ -59,7 +67,7 @@ static void unpack(unsign32 a,uchar *b)
     b[0]=MR_TOBYTE(a>>24);
 }
 
-static void precompute(gcm *g,uchar *H)
+static void precompute_table(gcm *g,uchar *H)
 { /* precompute small 2k bytes gf2m table of x^n.H */
 	int i,j;
 	unsign32 *last,*next,b;
@@ -75,7 +83,7 @@ static void precompute(gcm *g,uchar *H)
 }
 
 /* SU= 32 */
-static void gf2mul(gcm *g)
+static void gf2mul_table(gcm *g)
 { /* gf2m mul - Z=H*X mod 2^128 */
 	int i,j,m,k;
 	unsign32 P[4];
@@ -96,6 +104,184 @@ static void gf2mul(gcm *g)
 	for (i=j=0;i<NB;i++,j+=4) unpack(P[i],(uchar *)&g->stateX[j]);
 }
 
+#ifdef CLINT_X86
+
+/* Field elements are held byte reversed, so that the bit reflected GCM polynomial
+   becomes an ordinary one - see the Intel carry-less multiplication white paper */
+
+#define CLMUL_TARGET CLINT_TARGET("pclmul,ssse3,sse2")
+
+CLMUL_TARGET
+static __m128i reverse(__m128i x)
+{
+    return _mm_shuffle_epi8(x,_mm_set_epi8(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15));
+}
+
+/* Accumulate the unreduced 256-bit product a.b into hi:lo */
+CLMUL_TARGET
+static void clmul(__m128i a,__m128i b,__m128i *lo,__m128i *hi)
+{
+    __m128i t0,t1,t2,t3;
+    t0=_mm_clmulepi64_si128(a,b,0x00);
+    t1=_mm_clmulepi64_si128(a,b,0x10);
+    t2=_mm_clmulepi64_si128(a,b,0x01);
+    t3=_mm_clmulepi64_si128(a,b,0x11);
+    t1=_mm_xor_si128(t1,t2);
+    *lo=_mm_xor_si128(*lo,_mm_xor_si128(t0,_mm_slli_si128(t1,8)));
+    *hi=_mm_xor_si128(*hi,_mm_xor_si128(t3,_mm_srli_si128(t1,8)));
+}
+
+/* Reduce hi:lo modulo x^128+x^7+x^2+x+1. Being linear, this can be done once for a sum of products */
+CLMUL_TARGET
+static __m128i reduce(__m128i lo,__m128i hi)
+{
+    __m128i t0,t1,t2;
+
+/* shift left by one bit, to account for the reflected representation */
+    t0=_mm_srli_epi32(lo,31);
+    t1=_mm_srli_epi32(hi,31);
+    lo=_mm_slli_epi32(lo,1);
+    hi=_mm_slli_epi32(hi,1);
+    t2=_mm_srli_si128(t0,12);
+    t1=_mm_slli_si128(t1,4);
+    t0=_mm_slli_si128(t0,4);
+    lo=_mm_or_si128(lo,t0);
+    hi=_mm_or_si128(hi,t1);
+    hi=_mm_or_si128(hi,t2);
+
+/* reduction */
+    t0=_mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(lo,31),_mm_slli_epi32(lo,30)),_mm_slli_epi32(lo,25));
+    t1=_mm_srli_si128(t0,4);
+    t0=_mm_slli_si128(t0,12);
+    lo=_mm_xor_si128(lo,t0);
+    t2=_mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(lo,1),_mm_srli_epi32(lo,2)),_mm_srli_epi32(lo,7));
+    t2=_mm_xor_si128(t2,t1);
+    lo=_mm_xor_si128(lo,t2);
+    return _mm_xor_si128(hi,lo);
+}
+
+CLMUL_TARGET
+static __m128i mul(__m128i a,__m128i b)
+{
+    __m128i lo=_mm_setzero_si128(),hi=_mm_setzero_si128();
+    clmul(a,b,&lo,&hi);
+    return reduce(lo,hi);
+}
+
+/* Hpow[i] = H^(i+1) */
+CLMUL_TARGET
+static void precompute_clmul(gcm *g,uchar *H)
+{
+    int i;
+    __m128i h,p;
+    h=p=reverse(_mm_loadu_si128((__m128i *)H));
+    _mm_storeu_si128((__m128i *)g->Hpow[0],h);
+    for (i=1;i<4;i++)
+    {
+        p=mul(p,h);
+        _mm_storeu_si128((__m128i *)g->Hpow[i],p);
+    }
+}
+
+/* X=(..((X+B_1).H+B_2).H..+B_n).H, using X.H^4+B_1.H^4+B_2.H^3+B_3.H^2+B_4.H for each 4 blocks */
+CLMUL_TARGET
+static void ghash_clmul(gcm *g,const uchar *data,int nblocks)
+{
+    __m128i x,lo,hi,h1,h2,h3,h4;
+    const __m128i *b=(const __m128i *)data;
+
+    h1=_mm_loadu_si128((__m128i *)g->Hpow[0]);
+    x=reverse(_mm_loadu_si128((__m128i *)g->stateX));
+
+    if (nblocks>=4)
+    {
+        h2=_mm_loadu_si128((__m128i *)g->Hpow[1]);
+        h3=_mm_loadu_si128((__m128i *)g->Hpow[2]);
+        h4=_mm_loadu_si128((__m128i *)g->Hpow[3]);
+        for (;nblocks>=4;nblocks-=4,b+=4)
+        {
+            lo=hi=_mm_setzero_si128();
+            clmul(_mm_xor_si128(x,reverse(_mm_loadu_si128(&b[0]))),h4,&lo,&hi);
+            clmul(reverse(_mm_loadu_si128(&b[1])),h3,&lo,&hi);
+            clmul(reverse(_mm_loadu_si128(&b[2])),h2,&lo,&hi);
+            clmul(reverse(_mm_loadu_si128(&b[3])),h1,&lo,&hi);
+            x=reduce(lo,hi);
+        }
+    }
+    for (;nblocks>0;nblocks--,b++)
+        x=mul(_mm_xor_si128(x,reverse(_mm_loadu_si128(b))),h1);
+
+    _mm_storeu_si128((__m128i *)g->stateX,reverse(x));
+}
+
+#endif
+
+static void precompute(gcm *g,uchar *H)
+{
+#ifdef CLINT_X86
+    if (CPU_features()&CPU_PCLMUL)
+    {
+        precompute_clmul(g,H);
+        return;
+    }
+#endif
+    precompute_table(g,H);
+}
+
+/* Z=H*X mod 2^128 */
+static void gf2mul(gcm *g)
+{
+#ifdef CLINT_X86
+    if (CPU_features()&CPU_PCLMUL)
+    {
+        uchar zero[16];
+        memset(zero,0,16);
+        ghash_clmul(g,zero,1);
+        return;
+    }
+#endif
+    gf2mul_table(g);
+}
+
+/* Absorb nblocks whole 16-byte blocks into the GHASH state */
+static void ghash_blocks(gcm *g,const uchar *data,int nblocks)
+{
+	int i;
+#ifdef CLINT_X86
+	if (CPU_features()&CPU_PCLMUL)
+	{
+		ghash_clmul(g,data,nblocks);
+		return;
+	}
+#endif
+	for (;nblocks>0;nblocks--,data+=16)
+	{
+		for (i=0;i<16;i++) g->stateX[i]^=data[i];
+		gf2mul_table(g);
+	}
+}
+
+/* Add n to a 64-bit byte count */
+static void add_length(unsign32 *len,unsign32 n)
+{
+	len[1]+=n; if (len[1]<n) len[0]++;
+}
+
+/* Encrypt the next 4 counter blocks into B */
+static void counter_blocks(gcm *g,uchar *B)
+{
+	int i,k;
+	unsign32 counter;
+	for (k=0;k<64;k+=16)
+	{
+		counter=pack((uchar *)&(g->a.f[12]));
+		counter++;
+		unpack(counter,(uchar *)&(g->a.f[12]));  /* increment counter */
+		for (i=0;i<16;i++) B[k+i]=g->a.f[i];
+	}
+	AES_ecb_encrypt_blocks(&(g->a),B,4);
+}
+
 /* SU= 32 */
 static void GCM_wrap(gcm *g)
 { /* Finish off GHASH */
@@ -122,6 +308,9 @@ static int GCM_ghash(gcm *g,char *plain,int len)
 	if (g->status==GCM_ACCEPTING_HEADER) g->status=GCM_ACCEPTING_CIPHER;
 	if (g->status!=GCM_ACCEPTING_CIPHER) return 0;
 
+	j=16*(len/16);
+	ghash_blocks(g,(uchar *)plain,len/16);
+	add_length(g->lenC,(unsign32)j);
 	while (j<len)
 	{
 		for (i=0;i<16 && j<len;i++)
@@ -172,6 +361,9 @@ int GCM_add_header(gcm* g,char *header,int len)
 	int i,j=0;
 	if (g->status!=GCM_ACCEPTING_HEADER) return 0;
 
+	j=16*(len/16);
+	ghash_blocks(g,(uchar *)header,len/16);
+	add_length(g->lenA,(unsign32)j);
 	while (j<len)
 	{
 		for (i=0;i<16 && j<len;i++)
@@ -191,10 +383,17 @@ int GCM_add_plain(gcm *g,char *cipher,char *plain,int len)
 { /* Add plaintext to extract ciphertext, len is length of plaintext.  */
 	int i,j=0;
 	unsign32 counter;
-	uchar B[16];
+	uchar B[64];
 	if (g->status==GCM_ACCEPTING_HEADER) g->status=GCM_ACCEPTING_CIPHER;
 	if (g->status!=GCM_ACCEPTING_CIPHER) return 0;
 
+	for (;len-j>=64;j+=64)
+	{
+		counter_blocks(g,B);
+		for (i=0;i<64;i++) cipher[j+i]=plain[j+i]^B[i];
+		ghash_blocks(g,(uchar *)&cipher[j],4);
+		add_length(g->lenC,64);
+	}
 	while (j<len)
 	{
 		counter=pack((uchar *)&(g->a.f[12]));
@@ -221,10 +420,17 @@ int GCM_add_cipher(gcm *g,char *plain,char *cipher,int len)
 { /* Add ciphertext to extract plaintext, len is length of ciphertext. */
 	int i,j=0;
 	unsign32 counter;
-	uchar B[16];
+	uchar B[64];
 	if (g->status==GCM_ACCEPTING_HEADER) g->status=GCM_ACCEPTING_CIPHER;
 	if (g->status!=GCM_ACCEPTING_CIPHER) return 0;
 
+	for (;len-j>=64;j+=64)
+	{
+		counter_blocks(g,B);
+		ghash_blocks(g,(uchar *)&cipher[j],4);  /* before plain, which may overwrite it */
+		for (i=0;i<64;i++) plain[j+i]=cipher[j+i]^B[i];
+		add_length(g->lenC,64);
+	}
 	while (j<len)
 	{
 		counter=pack((uchar *)&(g->a.f[12]));
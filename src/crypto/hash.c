@@ -23,13 +23,20 @@ under the License.
  * Generates a 256 bit message digest. It should be impossible to come
  * come up with two messages that hash to the same value ("collision free").
  *
- * For use with byte-oriented messages only. Could/Should be speeded
- * up by unwinding loops in HASH_transform(), and assembly patches.
+ * Messages can be fed a byte at a time with HASH_process(), or in bulk with
+ * HASH_update(), which compresses whole blocks straight from the input.
+ * On x86 the block compression uses the SHA extensions when the CPU has them,
+ * and HASH_multi() hashes up to 8 independent messages in parallel AVX2 lanes.
  */
 /* SU=m, m is Stack Usage */
 
+#include <string.h>
 #include "clint.h"
 
+#ifdef CLINT_X86
+#include <immintrin.h>
+#endif
+
 #define H0 0x6A09E667L
 #define H1 0xBB67AE85L
 #define H2 0x3C6EF372L
@@ -69,10 +76,10 @@ static void HASH_transform(hash *sh)
 { /* basic transformation step */
     unsign32 a,b,c,d,e,f,g,h,t1,t2;
     int j;
-    for (j=16;j<64;j++) 
+    for (j=16;j<64;j++)
         sh->w[j]=theta1(sh->w[j-2])+sh->w[j-7]+theta0(sh->w[j-15])+sh->w[j-16];
 
-    a=sh->h[0]; b=sh->h[1]; c=sh->h[2]; d=sh->h[3]; 
+    a=sh->h[0]; b=sh->h[1]; c=sh->h[2]; d=sh->h[3];
     e=sh->h[4]; f=sh->h[5]; g=sh->h[6]; h=sh->h[7];
 
     for (j=0;j<64;j++)
@@ -84,12 +91,188 @@ static void HASH_transform(hash *sh)
         d=c;
         c=b;
         b=a;
-        a=t1+t2;        
+        a=t1+t2;
     }
 
-    sh->h[0]+=a; sh->h[1]+=b; sh->h[2]+=c; sh->h[3]+=d; 
-    sh->h[4]+=e; sh->h[5]+=f; sh->h[6]+=g; sh->h[7]+=h; 
-} 
+    sh->h[0]+=a; sh->h[1]+=b; sh->h[2]+=c; sh->h[3]+=d;
+    sh->h[4]+=e; sh->h[5]+=f; sh->h[6]+=g; sh->h[7]+=h;
+}
+
+static unsign32 load_be32(const uchar *b)
+{
+    return ((unsign32)b[0]<<24)|((unsign32)b[1]<<16)|((unsign32)b[2]<<8)|(unsign32)b[3];
+}
+
+/* Compress nblocks 64-byte blocks into the state - portable version */
+static void blocks_c(hash *sh,const uchar *data,int nblocks)
+{
+    int j;
+    while (nblocks--)
+    {
+        for (j=0;j<16;j++) sh->w[j]=load_be32(&data[4*j]);
+        HASH_transform(sh);
+        data+=64;
+    }
+}
+
+#ifdef CLINT_X86
+
+/* Compress nblocks 64-byte blocks into the state - SHA extensions */
+CLINT_TARGET("sha,sse4.1,ssse3")
+static void blocks_shani(hash *sh,const uchar *data,int nblocks)
+{
+    __m128i STATE0,STATE1,MSG,TMP,ABEF_SAVE,CDGH_SAVE;
+    __m128i M[4];
+    const __m128i BSWAP=_mm_set_epi64x(0x0c0d0e0f08090a0bLL,0x0405060700010203LL);
+    int g;
+
+    TMP=_mm_loadu_si128((const __m128i *)&sh->h[0]);
+    STATE1=_mm_loadu_si128((const __m128i *)&sh->h[4]);
+    TMP=_mm_shuffle_epi32(TMP,0xB1);            /* CDAB */
+    STATE1=_mm_shuffle_epi32(STATE1,0x1B);      /* EFGH */
+    STATE0=_mm_alignr_epi8(TMP,STATE1,8);       /* ABEF */
+    STATE1=_mm_blend_epi16(STATE1,TMP,0xF0);    /* CDGH */
+
+    while (nblocks--)
+    {
+        ABEF_SAVE=STATE0;
+        CDGH_SAVE=STATE1;
+
+        /* 16 groups of 4 rounds, message schedule kept in M[] */
+        for (g=0;g<16;g++)
+        {
+            if (g<4) M[g]=_mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&data[16*g]),BSWAP);
+
+            MSG=_mm_add_epi32(M[g&3],_mm_loadu_si128((const __m128i *)&K[4*g]));
+            STATE1=_mm_sha256rnds2_epu32(STATE1,STATE0,MSG);
+            if (g>=3 && g<15)
+            {
+                TMP=_mm_alignr_epi8(M[g&3],M[(g+3)&3],4);
+                M[(g+1)&3]=_mm_add_epi32(M[(g+1)&3],TMP);
+                M[(g+1)&3]=_mm_sha256msg2_epu32(M[(g+1)&3],M[g&3]);
+            }
+            MSG=_mm_shuffle_epi32(MSG,0x0E);
+            STATE0=_mm_sha256rnds2_epu32(STATE0,STATE1,MSG);
+            if (g>=1 && g<13)
+                M[(g+3)&3]=_mm_sha256msg1_epu32(M[(g+3)&3],M[g&3]);
+        }
+
+        STATE0=_mm_add_epi32(STATE0,ABEF_SAVE);
+        STATE1=_mm_add_epi32(STATE1,CDGH_SAVE);
+        data+=64;
+    }
+
+    TMP=_mm_shuffle_epi32(STATE0,0x1B);         /* FEBA */
+    STATE1=_mm_shuffle_epi32(STATE1,0xB1);      /* DCHG */
+    STATE0=_mm_blend_epi16(TMP,STATE1,0xF0);    /* DCBA */
+    STATE1=_mm_alignr_epi8(STATE1,TMP,8);       /* HGFE */
+
+    _mm_storeu_si128((__m128i *)&sh->h[0],STATE0);
+    _mm_storeu_si128((__m128i *)&sh->h[4],STATE1);
+}
+
+#define V_ROTR(x,n) _mm256_or_si256(_mm256_srli_epi32(x,n),_mm256_slli_epi32(x,32-(n)))
+#define V_SIG0(x)   _mm256_xor_si256(_mm256_xor_si256(V_ROTR(x,2),V_ROTR(x,13)),V_ROTR(x,22))
+#define V_SIG1(x)   _mm256_xor_si256(_mm256_xor_si256(V_ROTR(x,6),V_ROTR(x,11)),V_ROTR(x,25))
+#define V_THETA0(x) _mm256_xor_si256(_mm256_xor_si256(V_ROTR(x,7),V_ROTR(x,18)),_mm256_srli_epi32(x,3))
+#define V_THETA1(x) _mm256_xor_si256(_mm256_xor_si256(V_ROTR(x,17),V_ROTR(x,19)),_mm256_srli_epi32(x,10))
+#define V_CH(x,y,z)  _mm256_xor_si256(_mm256_and_si256(x,y),_mm256_andnot_si256(x,z))
+#define V_MAJ(x,y,z) _mm256_xor_si256(_mm256_xor_si256(_mm256_and_si256(x,y),_mm256_and_si256(x,z)),_mm256_and_si256(y,z))
+
+/* Hash n<=8 messages, one per AVX2 lane. Lanes that run out of blocks are masked off */
+CLINT_TARGET("avx2")
+static void multi8_avx2(int n,char *msg[],int len[],char *digest[])
+{
+    uchar tail[8][128];
+    const uchar *p[8];
+    int full[8],nb[8],maxnb=0;
+    int i,j,t,r,lane;
+    unsign32 out[8];
+    __m256i s[8],v[8],W[16],t1,t2,mask;
+
+    memset(tail,0,sizeof(tail));
+    for (lane=0;lane<8;lane++)
+    {
+        nb[lane]=full[lane]=0;
+        if (lane>=n) continue;
+        /* the padded last one or two blocks are built separately */
+        full[lane]=len[lane]/64;
+        r=len[lane]%64;
+        memcpy(tail[lane],&msg[lane][64*full[lane]],r);
+        tail[lane][r]=PAD;
+        t=(r+9>64)?128:64;
+        tail[lane][t-5]=(uchar)(((unsign32)len[lane])>>29);
+        tail[lane][t-4]=(uchar)(((unsign32)len[lane])>>21);
+        tail[lane][t-3]=(uchar)(((unsign32)len[lane])>>13);
+        tail[lane][t-2]=(uchar)(((unsign32)len[lane])>>5);
+        tail[lane][t-1]=(uchar)(((unsign32)len[lane])<<3);
+        nb[lane]=full[lane]+t/64;
+        if (nb[lane]>maxnb) maxnb=nb[lane];
+    }
+
+    s[0]=_mm256_set1_epi32((int)H0); s[1]=_mm256_set1_epi32((int)H1);
+    s[2]=_mm256_set1_epi32((int)H2); s[3]=_mm256_set1_epi32((int)H3);
+    s[4]=_mm256_set1_epi32((int)H4); s[5]=_mm256_set1_epi32((int)H5);
+    s[6]=_mm256_set1_epi32((int)H6); s[7]=_mm256_set1_epi32((int)H7);
+
+    for (j=0;j<maxnb;j++)
+    {
+        for (lane=0;lane<8;lane++)
+        {
+            if (j<full[lane]) p[lane]=(const uchar *)&msg[lane][64*j];
+            else if (j<nb[lane]) p[lane]=&tail[lane][64*(j-full[lane])];
+            else p[lane]=tail[lane];
+        }
+        mask=_mm256_set_epi32(-(j<nb[7]),-(j<nb[6]),-(j<nb[5]),-(j<nb[4]),-(j<nb[3]),-(j<nb[2]),-(j<nb[1]),-(j<nb[0]));
+
+        for (t=0;t<16;t++)
+            W[t]=_mm256_set_epi32((int)load_be32(p[7]+4*t),(int)load_be32(p[6]+4*t),(int)load_be32(p[5]+4*t),(int)load_be32(p[4]+4*t),
+                                  (int)load_be32(p[3]+4*t),(int)load_be32(p[2]+4*t),(int)load_be32(p[1]+4*t),(int)load_be32(p[0]+4*t));
+
+        for (i=0;i<8;i++) v[i]=s[i];
+
+        for (t=0;t<64;t++)
+        {
+            if (t>=16)
+                W[t&15]=_mm256_add_epi32(_mm256_add_epi32(V_THETA1(W[(t-2)&15]),W[(t-7)&15]),_mm256_add_epi32(V_THETA0(W[(t-15)&15]),W[t&15]));
+            t1=_mm256_add_epi32(_mm256_add_epi32(v[7],V_SIG1(v[4])),_mm256_add_epi32(V_CH(v[4],v[5],v[6]),_mm256_add_epi32(_mm256_set1_epi32((int)K[t]),W[t&15])));
+            t2=_mm256_add_epi32(V_SIG0(v[0]),V_MAJ(v[0],v[1],v[2]));
+            v[7]=v[6]; v[6]=v[5]; v[5]=v[4];
+            v[4]=_mm256_add_epi32(v[3],t1);
+            v[3]=v[2]; v[2]=v[1]; v[1]=v[0];
+            v[0]=_mm256_add_epi32(t1,t2);
+        }
+
+        for (i=0;i<8;i++) s[i]=_mm256_blendv_epi8(s[i],_mm256_add_epi32(s[i],v[i]),mask);
+    }
+
+    for (i=0;i<8;i++)
+    {
+        _mm256_storeu_si256((__m256i *)out,s[i]);
+        for (lane=0;lane<n;lane++)
+        {
+            digest[lane][4*i]=(char)(out[lane]>>24);
+            digest[lane][4*i+1]=(char)(out[lane]>>16);
+            digest[lane][4*i+2]=(char)(out[lane]>>8);
+            digest[lane][4*i+3]=(char)out[lane];
+        }
+    }
+    memset(tail,0,sizeof(tail));
+}
+
+#endif
+
+static void blocks(hash *sh,const uchar *data,int nblocks)
+{
+#ifdef CLINT_X86
+    if (CPU_features()&CPU_SHANI)
+    {
+        blocks_shani(sh,data,nblocks);
+        return;
+    }
+#endif
+    blocks_c(sh,data,nblocks);
+}
 
 /* Initialise Hash function */
 void HASH_init(hash *sh)
@@ -113,7 +296,7 @@ void HASH_process(hash *sh,int byte)
     int cnt;
 //printf("byt= %x\n",byte);
     cnt=(int)((sh->length[0]/32)%16);
-    
+
     sh->w[cnt]<<=8;
     sh->w[cnt]|=(unsign32)(byte&0xFF);
 
@@ -122,6 +305,36 @@ void HASH_process(hash *sh,int byte)
     if ((sh->length[0]%512)==0) HASH_transform(sh);
 }
 
+/* process len bytes */
+void HASH_update(hash *sh,const char *data,int len)
+{
+    int i,n;
+    /* top up a partly filled block */
+    while (len>0 && (sh->length[0]%512)!=0)
+    {
+        HASH_process(sh,*data++);
+        len--;
+    }
+    /* whole blocks go straight to the compression function */
+    n=len/64;
+    if (n>0)
+    {
+        blocks(sh,(const uchar *)data,n);
+        for (i=0;i<n;i++)
+        {
+            sh->length[0]+=512;
+            if (sh->length[0]==0L) sh->length[1]++;
+        }
+        data+=64*n;
+        len-=64*n;
+    }
+    while (len>0)
+    {
+        HASH_process(sh,*data++);
+        len--;
+    }
+}
+
 /* SU= 24 */
 /* Generate 32-byte Hash */
 void HASH_hash(hash *sh,char digest[32])
@@ -133,7 +346,7 @@ void HASH_hash(hash *sh,char digest[32])
     HASH_process(sh,PAD);
     while ((sh->length[0]%512)!=448) HASH_process(sh,ZERO);
     sh->w[14]=len1;
-    sh->w[15]=len0;    
+    sh->w[15]=len0;
     HASH_transform(sh);
     for (i=0;i<32;i++)
     { /* convert to bytes */
@@ -142,6 +355,28 @@ void HASH_hash(hash *sh,char digest[32])
     HASH_init(sh);
 }
 
+/* Hash n independent messages msg[i] of len[i] bytes into the 32-byte digest[i] */
+/* With AVX2, messages are hashed 8 at a time in parallel lanes. Best when the messages are of similar length */
+void HASH_multi(int n,char *msg[],int len[],char *digest[])
+{
+    int i;
+    hash sh;
+#ifdef CLINT_X86
+    if (CPU_features()&CPU_AVX2)
+    {
+        for (i=0;i<n;i+=8)
+            multi8_avx2((n-i<8)?n-i:8,&msg[i],&len[i],&digest[i]);
+        return;
+    }
+#endif
+    HASH_init(&sh);
+    for (i=0;i<n;i++)
+    {
+        HASH_update(&sh,msg[i],len[i]);
+        HASH_hash(&sh,digest[i]);
+    }
+}
+
 /* test program: should produce digest  */
 
 //248d6a61 d20638b8 e5c02693 0c3e6039 a33ce459 64ff2167 f6ecedd4 19db06c1
@@ -35,8 +35,7 @@ static void start_hash(hash *sha)
 
 static void add_to_hash(hash *sha,octet *x)
 {
-	int i;
-	for (i=0;i<x->len;i++) {/*printf("%d,",(unsigned char)x->val[i]);*/ HASH_process(sha,x->val[i]);  }
+	HASH_update(sha,x->val,x->len);
 }
 
 static void finish_hash(hash *sha,octet *w)
@@ -85,6 +84,81 @@ static int unmap(BIG u,int *cb,ECP *P)
 	return r;
 }
 
+#ifdef USE_SW_MAP
+
+/* is x^3+b a square? x is in n-residue form */
+static int onrhs(BIG x)
+{
+	BIG v;
+	ECP_rhs(v,x);
+	return FP_qr(v);
+}
+
+/* map octet string to point on curve */
+/* Shallue-van de Woestijne encoding for BN curves, as given by Fouque and Tibouchi - http://www.di.ens.fr/~fouque/pub/latincrypt12.pdf
+   Of the three candidate x coordinates the first with x^3+b square is taken. Every input costs one inversion (safegcd),
+   two Jacobi symbols for the QR bits of x1 and x2 (binary, no exponentiation) and the one square root exponentiation
+   in ECP_setx, where try-and-increment takes a square root attempt per candidate. Only the Jacobi symbols take time
+   that depends on their inputs */
+static void mapit(octet *h,ECP *P)
+{
+	BIG q,t,t2,s,one,d,iv,w,x1,x2,x3;
+	int c1,c2,sign;
+	BIG_fromBytes(t,h->val);
+	BIG_rcopy(q,Modulus);
+	BIG_mod(t,q);
+
+	if (BIG_iszilch(t))
+	{ /* t=0 has no encoding. Only here for completeness */
+		while (!ECP_setx(P,t,0))
+			BIG_inc(t,1);
+		return;
+	}
+
+	sign=BIG_parity(t);
+	FP_nres(t);
+	FP_one(one);
+
+/* s=sqrt(-3)=2c+1, c the cube root of unity */
+	BIG_rcopy(s,CURVE_Cru); FP_nres(s);
+	FP_add(s,s,s); FP_add(s,s,one);
+
+/* d=1+b+t^2 */
+	FP_sqr(t2,t);
+	BIG_rcopy(d,CURVE_B); FP_nres(d);
+	FP_add(d,d,one); FP_add(d,d,t2);
+	FP_reduce(d);
+
+/* both denominators from one inversion, iv=1/(3.d.t^2) */
+	FP_mul(iv,d,t2); FP_imul(iv,iv,3); FP_inv(iv,iv);
+
+/* w=s.t/d=3.s.t^3.iv */
+	FP_mul(w,t2,iv); FP_imul(w,w,3); FP_mul(w,w,t); FP_mul(w,w,s);
+
+/* x1=(s-1)/2-t.w */
+	FP_sub(x1,s,one); FP_reduce(x1); FP_div2(x1,x1);
+	FP_mul(w,w,t);
+	FP_sub(x1,x1,w); FP_reduce(x1);
+
+/* x2=-1-x1 */
+	FP_neg(x2,x1); FP_sub(x2,x2,one); FP_reduce(x2);
+
+/* x3=1+1/w^2=1-d^3/(3.t^2)=1-d^3.iv */
+	FP_sqr(x3,d); FP_mul(x3,x3,d); FP_mul(x3,x3,iv);
+	FP_sub(x3,one,x3); FP_reduce(x3);
+
+	c1=onrhs(x1);
+	c2=onrhs(x2);
+	BIG_cmove(x3,x2,c2);
+	BIG_cmove(x3,x1,c1);
+
+	FP_redc(x3);
+	BIG_mod(x3,q);
+	ECP_setx(P,x3,sign);
+}
+
+#else
+
 /* map octet string to point on curve */
 static void mapit(octet *h,ECP *P)
 {
@@ -97,6 +171,8 @@ static void mapit(octet *h,ECP *P)
 		BIG_inc(px,1);
 }
 
+#endif
+
 /* needed for SOK */
 static void mapit2(octet *h,ECP2 *Q)
 {
@@ -141,27 +217,58 @@ static void mapit2(octet *h,ECP2 *Q)
 /* Hash number (optional) and octet to octet */
 static void hashit(int n,octet *x,octet *h)
 {
-    int i,c[4];
+    int i;
+    char c[4];
     hash sha;
     char hh[HASH_BYTES];
-	BIG px;
 
     HASH_init(&sha);
 	if (n>0)
     {
-        c[0]=(n>>24)&0xff;
-        c[1]=(n>>16)&0xff;
-        c[2]=(n>>8)&0xff;
-        c[3]=(n)&0xff;
-		for (i=0;i<4;i++) HASH_process(&sha,c[i]);
+        c[0]=(char)((n>>24)&0xff);
+        c[1]=(char)((n>>16)&0xff);
+        c[2]=(char)((n>>8)&0xff);
+        c[3]=(char)((n)&0xff);
+		HASH_update(&sha,c,4);
     }
-    for (i=0;i<x->len;i++) HASH_process(&sha,x->val[i]);    
+    HASH_update(&sha,x->val,x->len);
     HASH_hash(&sha,hh);
     OCT_empty(h);
     OCT_jbytes(h,hh,HASH_BYTES);
     for (i=0;i<32;i++) hh[i]=0;
 }
 
+/* Hash number (optional) and octet to h[i] for n<=MPIN_BATCH_SIZE octets at once - see HASH_multi */
+static void hashit_batch(int n,int num,octet *x[],char h[][HASH_BYTES])
+{
+    int i,k=(num>0)?4:0;
+    char m[MPIN_BATCH_SIZE][4+HASH_BYTES];
+    char *msg[MPIN_BATCH_SIZE],*dig[MPIN_BATCH_SIZE];
+    int len[MPIN_BATCH_SIZE];
+    octet H;
+
+    for (i=0;i<n;i++)
+    {
+        if (x[i]->len>HASH_BYTES)
+        { /* longer than the hashed ids the batch is meant for */
+            for (i=0;i<n;i++)
+            {
+                H.len=0; H.max=HASH_BYTES; H.val=h[i];
+                hashit(num,x[i],&H);
+            }
+            return;
+        }
+        m[i][0]=(char)((num>>24)&0xff);
+        m[i][1]=(char)((num>>16)&0xff);
+        m[i][2]=(char)((num>>8)&0xff);
+        m[i][3]=(char)((num)&0xff);
+        memcpy(&m[i][k],x[i]->val,x[i]->len);
+        msg[i]=m[i]; len[i]=k+x[i]->len; dig[i]=h[i];
+    }
+    HASH_multi(n,msg,len,dig);
+    memset(m,0,sizeof(m));
+}
+
 unsign32 today(void)
 { /* return time in slots since epoch */
 	unsign32 ti=(unsign32)time(NULL);
@@ -176,6 +283,12 @@ void CREATE_CSPRNG(csprng *RNG,octet *RAW)
     RAND_seed(RNG,RAW->len,RAW->val);
 }
 
+/* Initialise a generator forked from the calling thread's OS seeded generator - cheap enough to use one per session. Returns 0 if no entropy is available */
+int CREATE_SESSION_CSPRNG(csprng *RNG)
+{
+    return RAND_thread_fork(RNG);
+}
+
 void KILL_CSPRNG(csprng *RNG)
 {
     RAND_clean(RNG);
@@ -263,6 +376,15 @@ int MPIN_RECOMBINE_G1(octet *R1,octet *R2,octet *R)
     return res;
 }
 
+/* Convert the G1 point in W to compressed form, in place. W may be in either form */
+int MPIN_COMPRESS_G1(octet *W)
+{
+	ECP P;
+	if (!ECP_fromOctet(&P,W)) return MPIN_INVALID_POINT;
+	ECP_toOctetC(W,&P);
+	return 0;
+}
+
 /* W=W1+W2 in group G2 */
 int MPIN_RECOMBINE_G2(octet *W1,octet *W2,octet *W)
 {
@@ -378,14 +500,12 @@ int MPIN_GET_CLIENT_SECRET(octet *S,octet *CID,octet *CST)
 	return MPIN_GET_G1_MULTIPLE(NULL,1,S,CID,CST);
 }
 
-/* Implement step 1 on client side of MPin protocol */
-int MPIN_CLIENT_1(int date,octet *CLIENT_ID,csprng *RNG,octet *X,int pin,octet *TOKEN,octet *SEC,octet *xID,octet *xCID,octet *PERMIT)
+/* Client step 1 from the mapped points P=H(ID) and, if date is non-zero, W=H(T|H(ID)) */
+static int client_1(int date,ECP *P,ECP *W,csprng *RNG,octet *X,int pin,octet *TOKEN,octet *SEC,octet *xID,octet *xCID,octet *PERMIT)
 {
     BIG r,x;
-    ECP P,T,W;
-    int plen,res=0;
-	char h[HASH_BYTES];
-	octet H={0,sizeof(h),h};
+    ECP T,A;
+    int res=0;
 
 	BIG_rcopy(r,CURVE_Order);
 	if (RNG!=NULL)
@@ -397,45 +517,40 @@ int MPIN_CLIENT_1(int date,octet *CLIENT_ID,csprng *RNG,octet *X,int pin,octet *
 	else
 		BIG_fromBytes(x,X->val);
 
-	hashit(-1,CLIENT_ID,&H);
-	mapit(&H,&P);
-
 	if (!ECP_fromOctet(&T,TOKEN)) res=MPIN_INVALID_POINT; 
 	
 	if (res==0)
 	{
 		pin%=MAXPIN;
 
-		ECP_copy(&W,&P);				// W=H(ID)
-		ECP_pinmul(&W,pin,PBLEN);			// W=alpha.H(ID)
-		ECP_add(&T,&W);					// T=Token+alpha.H(ID) = s.H(ID)
+		ECP_copy(&A,P);				// A=H(ID)
+		ECP_pinmul(&A,pin,PBLEN);			// A=alpha.H(ID)
+		ECP_add(&T,&A);					// T=Token+alpha.H(ID) = s.H(ID)
 
 		if (date)
 		{
-			if (!ECP_fromOctet(&W,PERMIT)) res=MPIN_INVALID_POINT;
-			ECP_add(&T,&W);					// SEC=s.H(ID)+s.H(T|ID)
-			hashit(date,&H,&H);          
-			mapit(&H,&W);
+			if (!ECP_fromOctet(&A,PERMIT)) res=MPIN_INVALID_POINT;
+			ECP_add(&T,&A);					// SEC=s.H(ID)+s.H(T|ID)
 			if (xID!=NULL)
 			{
-				PAIR_G1mul(&P,x);				// P=x.H(ID)
-				ECP_toOctet(xID,&P);  // xID
-				PAIR_G1mul(&W,x);               // W=x.H(T|ID)
-				ECP_add(&P,&W);
+				PAIR_G1mul(P,x);				// P=x.H(ID)
+				ECP_toOctet(xID,P);  // xID
+				PAIR_G1mul(W,x);               // W=x.H(T|ID)
+				ECP_add(P,W);
 			}
 			else
 			{
-				ECP_add(&P,&W);
-				PAIR_G1mul(&P,x);
+				ECP_add(P,W);
+				PAIR_G1mul(P,x);
 			}
-			if (xCID!=NULL) ECP_toOctet(xCID,&P);  // U
+			if (xCID!=NULL) ECP_toOctet(xCID,P);  // U
 		}
 		else
 		{
 			if (xID!=NULL)
 			{
-				PAIR_G1mul(&P,x);				// P=x.H(ID)
-				ECP_toOctet(xID,&P);  // xID
+				PAIR_G1mul(P,x);				// P=x.H(ID)
+				ECP_toOctet(xID,P);  // xID
 			}
 		}
 	}
@@ -446,6 +561,57 @@ int MPIN_CLIENT_1(int date,octet *CLIENT_ID,csprng *RNG,octet *X,int pin,octet *
     return res;
 }
 
+/* Implement step 1 on client side of MPin protocol */
+int MPIN_CLIENT_1(int date,octet *CLIENT_ID,csprng *RNG,octet *X,int pin,octet *TOKEN,octet *SEC,octet *xID,octet *xCID,octet *PERMIT)
+{
+    ECP P,W;
+	char h[HASH_BYTES];
+	octet H={0,sizeof(h),h};
+
+	hashit(-1,CLIENT_ID,&H);
+	mapit(&H,&P);
+	if (date)
+	{
+		hashit(date,&H,&H);          
+		mapit(&H,&W);
+	}
+
+	return client_1(date,&P,&W,RNG,X,pin,TOKEN,SEC,xID,xCID,PERMIT);
+}
+
+/* Map CLIENT_ID to the points used by MPIN_CLIENT_1_PRECOMP - HCID=H(ID) and, if date is non-zero, HTCID=H(T|H(ID)) */
+/* Either output can be NULL, so that a cached H(ID) need not be recomputed when the date changes */
+void MPIN_MAP_CLIENT_ID(int date,octet *CLIENT_ID,octet *HCID,octet *HTCID)
+{
+    ECP P;
+	char h[HASH_BYTES];
+	octet H={0,sizeof(h),h};
+
+	hashit(-1,CLIENT_ID,&H);
+	if (HCID!=NULL)
+	{
+		mapit(&H,&P);
+		ECP_toOctet(HCID,&P);
+	}
+	if (date && HTCID!=NULL)
+	{
+		hashit(date,&H,&H);
+		mapit(&H,&P);
+		ECP_toOctet(HTCID,&P);
+	}
+}
+
+/* As MPIN_CLIENT_1, but with the identity already mapped by MPIN_MAP_CLIENT_ID, so no hashing to the curve is done */
+int MPIN_CLIENT_1_PRECOMP(int date,octet *HCID,octet *HTCID,csprng *RNG,octet *X,int pin,octet *TOKEN,octet *SEC,octet *xID,octet *xCID,octet *PERMIT)
+{
+    ECP P,W;
+
+	if (!ECP_fromOctet(&P,HCID)) return MPIN_INVALID_POINT;
+	if (date && !ECP_fromOctet(&W,HTCID)) return MPIN_INVALID_POINT;
+
+	return client_1(date,&P,&W,RNG,X,pin,TOKEN,SEC,xID,xCID,PERMIT);
+}
+
 /* Extract Server Secret SST=S*Q where Q is fixed generator in G2 and S is master secret */
 int MPIN_GET_SERVER_SECRET(octet *S,octet *SST)
 {
@@ -490,84 +656,169 @@ int MPIN_GET_CLIENT_PERMIT(int date,octet *S,octet *CID,octet *CTT)
     return 0;
 }
 
+/* Time Permits for n clients at once, CTT[i]=s*H(date|H(CID[i])) */
+int MPIN_GET_CLIENT_PERMITS(int date,octet *S,int n,octet *CID[],octet *CTT[])
+{
+	int i,j,m;
+    BIG s;
+    ECP P[MPIN_BATCH_SIZE];
+	BIG work[MPIN_BATCH_SIZE];
+	char h[MPIN_BATCH_SIZE][HASH_BYTES];
+	octet H={HASH_BYTES,HASH_BYTES,NULL};
+
+	BIG_fromBytes(s,S->val);
+	for (i=0;i<n;i+=MPIN_BATCH_SIZE)
+	{
+		m=n-i;
+		if (m>MPIN_BATCH_SIZE) m=MPIN_BATCH_SIZE;
+
+		hashit_batch(m,date,&CID[i],h);
+		for (j=0;j<m;j++)
+		{
+			H.val=h[j];
+			mapit(&H,&P[j]);
+			PAIR_G1mul(&P[j],s);
+		}
+		ECP_batch_affine(m,P,work);
+		for (j=0;j<m;j++)
+			ECP_toOctet(CTT[i+j],&P[j]);
+	}
+    return 0;
+}
+
 // if date=0 only use HID, set HCID=NULL
 // if date and !PE, use set HID=NULL and use HCID only
 // if date and PE, use HID and HCID
 
+/* P=H(CID) and, if date is non-zero, PT=H(CID)+H(T|H(CID)), where H is the hash of CID */
+static void server_1(int date,octet *H,ECP *P,ECP *PT)
+{
+	char t[HASH_BYTES];
+	octet T={0,sizeof(t),t};
+	ECP R;
+
+	mapit(H,P);
+	if (date)
+	{
+		hashit(date,H,&T);
+		mapit(&T,&R);
+		ECP_copy(PT,P);
+		ECP_add(PT,&R);
+	}
+}
+
 /* Outputs H(CID) and H(CID)+H(T|H(CID)) for time permits. If no time permits set HTID=NULL */
 void MPIN_SERVER_1(int date,octet *CID,octet *HID,octet *HTID)
 {
 	char h[HASH_BYTES];
 	octet H={0,sizeof(h),h};
-	ECP P,R;
+	ECP P,PT;
 
 	hashit(-1,CID,&H);
-	mapit(&H,&P);
+	server_1(date,&H,&P,&PT);
 
-	if (date) 
+	if (HID!=NULL) ECP_toOctet(HID,&P);
+	if (date) ECP_toOctet(HTID,&PT);
+}
+
+void MPIN_INIT_POINT_CACHE(mpin_point_cache *C)
+{
+	int i;
+	for (i=0;i<MPIN_POINT_CACHE_SIZE;i++) C->entry[i].stamp=0;
+	C->clock=0;
+}
+
+/* As MPIN_SERVER_1, but looks the points up in C first. A miss replaces the least recently used entry */
+void MPIN_SERVER_1_CACHED(mpin_point_cache *C,int date,octet *CID,octet *HID,octet *HTID)
+{
+	int i,lru=0;
+	mpin_point_entry *e;
+	char h[HASH_BYTES];
+	octet H={0,sizeof(h),h};
+	octet W;
+	ECP P,PT;
+
+	if (C->clock==0xFFFFFFFF) MPIN_INIT_POINT_CACHE(C);  /* start again rather than let the stamps wrap */
+	hashit(-1,CID,&H);
+
+	for (i=0;i<MPIN_POINT_CACHE_SIZE;i++)
 	{
-		if (HID!=NULL) ECP_toOctet(HID,&P);
-		hashit(date,&H,&H);
-		mapit(&H,&R);
-		ECP_add(&P,&R);
-		ECP_toOctet(HTID,&P);
+		e=&C->entry[i];
+		if (e->stamp!=0 && e->date==date && memcmp(e->hash,h,HASH_BYTES)==0) break;
+		if (e->stamp<C->entry[lru].stamp) lru=i;
 	}
-	else ECP_toOctet(HID,&P);
 
+	if (i==MPIN_POINT_CACHE_SIZE)
+	{
+		e=&C->entry[lru];
+		server_1(date,&H,&P,&PT);
+		memcpy(e->hash,h,HASH_BYTES);
+		e->date=date;
+		W.len=0; W.max=sizeof(e->hid); W.val=e->hid;
+		ECP_toOctet(&W,&P);
+		if (date)
+		{
+			W.len=0; W.max=sizeof(e->htid); W.val=e->htid;
+			ECP_toOctet(&W,&PT);
+		}
+	}
+	e->stamp=++C->clock;
+
+	if (HID!=NULL) {OCT_empty(HID); OCT_jbytes(HID,e->hid,2*PFS+1);}
+	if (date) {OCT_empty(HTID); OCT_jbytes(HTID,e->htid,2*PFS+1);}
 }
 
-/* Implement M-Pin on server side */
-int MPIN_SERVER_2(int date,octet *HID,octet *HTID,octet *Y,octet *SST,octet *xID,octet *xCID,octet *mSEC,octet *E,octet *F)
+/* Q is the fixed generator of G2, and sQ the server secret */
+static int server_2_secret(octet *SST,ECP2 *Q,ECP2 *sQ)
 {
-    BIG a,px,py,y;
-	FP2 qx,qy; 
-	FP12 g;
-    ECP2 Q,sQ;
-	ECP P,R;
-    int res=0;
+	FP2 qx,qy;
 
     BIG_rcopy(qx.a,CURVE_Pxa); FP_nres(qx.a);
     BIG_rcopy(qx.b,CURVE_Pxb); FP_nres(qx.b);
     BIG_rcopy(qy.a,CURVE_Pya); FP_nres(qy.a);
     BIG_rcopy(qy.b,CURVE_Pyb); FP_nres(qy.b);
-      
-	if (!ECP2_set(&Q,&qx,&qy)) res=MPIN_INVALID_POINT;
 
-	if (res==0)
-	{
-		if (!ECP2_fromOctet(&sQ,SST)) res=MPIN_INVALID_POINT;
-	}
+	if (!ECP2_set(Q,&qx,&qy)) return MPIN_INVALID_POINT;
+	if (!ECP2_fromOctet(sQ,SST)) return MPIN_INVALID_POINT;
+	return 0;
+}
 
-	if (res==0)
+/* P=x(A+AT)+y(A+AT), left in projective coordinates */
+static int server_2_point(int date,octet *HID,octet *HTID,octet *Y,octet *xID,octet *xCID,ECP *P)
+{
+    BIG y;
+	ECP R;
+
+	if (!ECP_fromOctet(&R,date?xCID:xID)) return MPIN_INVALID_POINT; // x(A+AT)
+
+	BIG_fromBytes(y,Y->val);
+	if (date) 
 	{
-		if (date)
-		{
-			BIG_fromBytes(px,&(xCID->val[1]));
-			BIG_fromBytes(py,&(xCID->val[PFS+1]));
-		}
-		else
-		{
-			BIG_fromBytes(px,&(xID->val[1]));
-			BIG_fromBytes(py,&(xID->val[PFS+1]));
-		}
-		if (!ECP_set(&R,px,py)) res=MPIN_INVALID_POINT; // x(A+AT)
+		if (!ECP_fromOctet(P,HTID)) return MPIN_INVALID_POINT;
 	}
-	if (res==0)
+	else
 	{
-		BIG_fromBytes(y,Y->val);
-		if (date) 
-		{
-			if (!ECP_fromOctet(&P,HTID))  res=MPIN_INVALID_POINT;
-		}
-		else
-		{
-			if (!ECP_fromOctet(&P,HID))  res=MPIN_INVALID_POINT;
-		}
+		if (!ECP_fromOctet(P,HID)) return MPIN_INVALID_POINT;
 	}
+
+	PAIR_G1mul(P,y);  // y(A+AT)
+	ECP_add(P,&R); // x(A+AT)+y(A+T)
+	return 0;
+}
+
+/* Implement M-Pin on server side */
+int MPIN_SERVER_2(int date,octet *HID,octet *HTID,octet *Y,octet *SST,octet *xID,octet *xCID,octet *mSEC,octet *E,octet *F)
+{
+    BIG y;
+	FP12 g;
+    ECP2 Q,sQ;
+	ECP P,R;
+    int res=0;
+
+	res=server_2_secret(SST,&Q,&sQ);
+	if (res==0) res=server_2_point(date,HID,HTID,Y,xID,xCID,&P);
 	if (res==0)
 	{
-		PAIR_G1mul(&P,y);  // y(A+AT)
-		ECP_add(&P,&R); // x(A+AT)+y(A+T)
 		if (!ECP_fromOctet(&R,mSEC))  res=MPIN_INVALID_POINT; // V
 	}
 	if (res==0)
@@ -590,6 +841,7 @@ int MPIN_SERVER_2(int date,octet *HID,octet *HTID,octet *Y,octet *SST,octet *xID
 
 					if (res==0)
 					{
+						BIG_fromBytes(y,Y->val);
 						PAIR_G1mul(&P,y);  // yA
 						ECP_add(&P,&R); // yA+xA
 					}
@@ -608,6 +860,111 @@ int MPIN_SERVER_2(int date,octet *HID,octet *HTID,octet *Y,octet *SST,octet *xID
     return res;
 }
 
+/* Check e(R,Q).e(P,sQ)=1 for clients lo..hi-1 of a batch whose res[] is still 0, setting res[] for those that fail.
+   With RNG, the clients are checked together as e(sum r[i]R[i],Q).e(sum r[i]P[i],sQ)=1 for random 64-bit r[i], which
+   always holds if every client is valid and otherwise holds with probability about 2^-64 - all pairings are with the
+   same two G2 points, so one pairing serves the whole range. If that check fails, the range is split in two until the
+   failures are found. P[] and R[] must be affine */
+static void server_2_check(csprng *RNG,int lo,int hi,ECP2 *Q,ECP2 *sQ,ECP P[],ECP R[],int res[])
+{
+	int i,b,m,mid;
+	unsign32 r[MPIN_BATCH_SIZE][2];
+	FP12 g;
+	ECP A,B;
+
+	for (m=0,i=lo;i<hi;i++)
+		if (res[i]==0) m++;
+	if (m==0) return;
+
+	if (m==1 || RNG==NULL)
+	{
+		for (i=lo;i<hi;i++)
+		{
+			if (res[i]!=0) continue;
+			PAIR_double_ate(&g,Q,&R[i],sQ,&P[i]);
+			PAIR_fexp(&g);
+			if (!FP12_isunity(&g)) res[i]=MPIN_BAD_PIN;
+		}
+		return;
+	}
+
+	for (i=lo;i<hi;i++)
+	{
+		if (res[i]!=0) continue;
+		r[i][0]=r[i][1]=0;
+		for (b=0;b<4;b++)
+		{
+			r[i][0]=(r[i][0]<<8)|(unsign32)(RAND_byte(RNG)&0xff);
+			r[i][1]=(r[i][1]<<8)|(unsign32)(RAND_byte(RNG)&0xff);
+		}
+		r[i][1]|=0x80000000; /* r[i] is never 0 mod q */
+	}
+
+/* both sums share the same bits, so they are accumulated together, most significant bit first */
+	ECP_inf(&A); ECP_inf(&B);
+	for (b=63;b>=0;b--)
+	{
+		ECP_dbl(&A); ECP_dbl(&B);
+		for (i=lo;i<hi;i++)
+		{
+			if (res[i]!=0 || ((r[i][b>>5]>>(b&31))&1)==0) continue;
+			ECP_add(&A,&R[i]);
+			ECP_add(&B,&P[i]);
+		}
+	}
+
+	if (!ECP_isinf(&A) && !ECP_isinf(&B))
+	{
+		PAIR_double_ate(&g,Q,&A,sQ,&B);
+		PAIR_fexp(&g);
+		if (FP12_isunity(&g)) return;
+	}
+
+	mid=(lo+hi)/2;
+	server_2_check(RNG,lo,mid,Q,sQ,P,R,res);
+	server_2_check(RNG,mid,hi,Q,sQ,P,R,res);
+}
+
+/* Server step 2 for n clients at once, with the arguments of MPIN_SERVER_2 as arrays. HID, HTID, xID and xCID may be
+   NULL where MPIN_SERVER_2 would take NULL for them all. res[i] is set to the outcome for client i, and the first
+   failure is returned. No PIN error is calculated - MPIN_SERVER_2 can be repeated for a client that failed.
+   With an RNG, each group of MPIN_BATCH_SIZE clients costs one pairing when all of them are valid (see
+   server_2_check). With RNG=NULL every client is checked with its own pairing */
+int MPIN_SERVER_2_BATCH(int date,int n,csprng *RNG,octet *HID[],octet *HTID[],octet *Y[],octet *SST,octet *xID[],octet *xCID[],octet *mSEC[],int res[])
+{
+	int i,j,k,m,err;
+    ECP2 Q,sQ;
+	ECP P[MPIN_BATCH_SIZE],R[MPIN_BATCH_SIZE];
+	BIG work[MPIN_BATCH_SIZE];
+
+	err=server_2_secret(SST,&Q,&sQ);
+	for (i=0;i<n;i+=MPIN_BATCH_SIZE)
+	{
+		m=n-i;
+		if (m>MPIN_BATCH_SIZE) m=MPIN_BATCH_SIZE;
+
+		for (j=0;j<m;j++)
+		{
+			k=i+j;
+			res[k]=err;
+			if (res[k]==0)
+				res[k]=server_2_point(date,HID!=NULL?HID[k]:NULL,HTID!=NULL?HTID[k]:NULL,Y[k],
+					xID!=NULL?xID[k]:NULL,xCID!=NULL?xCID[k]:NULL,&P[j]);
+			if (res[k]==0 && !ECP_fromOctet(&R[j],mSEC[k])) res[k]=MPIN_INVALID_POINT; // V
+			if (res[k]!=0) ECP_inf(&P[j]);
+		}
+
+/* one inversion for the whole batch, instead of one in each PAIR_double_ate */
+		ECP_batch_affine(m,P,work);
+
+		server_2_check(RNG,0,m,&Q,&sQ,P,R,&res[i]);
+	}
+
+	for (i=0;i<n;i++)
+		if (res[i]!=0) return res[i];
+	return 0;
+}
+
 #if MAXPIN==10000
 #define MR_TS 10  /* 2^10/10 approx = sqrt(MAXPIN) */
 #define TRAP 200  /* 2*sqrt(MAXPIN) */
@@ -53,6 +53,27 @@ under the License.
 #define TIME_SLOT_MINUTES 1440 /* Time Slot = 1 day */
 #define HASH_BYTES 32
 
+/* Server side cache of mapped identities, for MPIN_SERVER_1_CACHED */
+
+#define MPIN_POINT_CACHE_SIZE 64
+
+typedef struct {
+char hash[HASH_BYTES];   /* H(CID) */
+int date;
+unsign32 stamp;          /* last use, 0 if the entry is empty */
+char hid[2*PFS+1];       /* H(CID) mapped to G1 */
+char htid[2*PFS+1];      /* H(CID)+H(T|H(CID)) if date is non-zero */
+} mpin_point_entry;
+
+typedef struct {
+mpin_point_entry entry[MPIN_POINT_CACHE_SIZE];
+unsign32 clock;
+} mpin_point_cache;
+
+/* Number of points normalised together by the batch functions */
+
+#define MPIN_BATCH_SIZE 16
+
 /* MPIN support functions */
 
 /* MPIN primitives */
@@ -60,13 +81,19 @@ under the License.
 DLL_EXPORT void MPIN_HASH_ID(octet *,octet *);
 DLL_EXPORT int MPIN_EXTRACT_PIN(octet *,int,octet *); 
 DLL_EXPORT int MPIN_CLIENT_1(int,octet *,csprng *,octet *,int,octet *,octet *,octet *,octet *,octet *);
+DLL_EXPORT void MPIN_MAP_CLIENT_ID(int,octet *,octet *,octet *);
+DLL_EXPORT int MPIN_CLIENT_1_PRECOMP(int,octet *,octet *,csprng *,octet *,int,octet *,octet *,octet *,octet *,octet *);
 DLL_EXPORT int MPIN_RANDOM_GENERATE(csprng *,octet *);
 DLL_EXPORT int MPIN_CLIENT_2(octet *,octet *,octet *);
 DLL_EXPORT void	MPIN_SERVER_1(int,octet *,octet *,octet *);
+DLL_EXPORT void MPIN_INIT_POINT_CACHE(mpin_point_cache *);
+DLL_EXPORT void MPIN_SERVER_1_CACHED(mpin_point_cache *,int,octet *,octet *,octet *);
 DLL_EXPORT int MPIN_SERVER_2(int,octet *,octet *,octet *,octet *,octet *,octet *,octet *,octet *,octet *);
+DLL_EXPORT int MPIN_SERVER_2_BATCH(int,int,csprng *,octet **,octet **,octet **,octet *,octet **,octet **,octet **,int *);
 DLL_EXPORT int MPIN_SERVER(int,int,octet *,octet *,octet *,octet *,octet *,octet *,octet *,octet *);
 DLL_EXPORT int MPIN_RECOMBINE_G1(octet *,octet *,octet *);
 DLL_EXPORT int MPIN_RECOMBINE_G2(octet *,octet *,octet *);
+DLL_EXPORT int MPIN_COMPRESS_G1(octet *);
 DLL_EXPORT int MPIN_KANGAROO(octet *,octet *);
 
 DLL_EXPORT int MPIN_ENCODING(csprng *,octet *);
@@ -74,11 +101,13 @@ DLL_EXPORT int MPIN_DECODING(octet *);
 
 DLL_EXPORT unsign32 today(void);
 DLL_EXPORT void CREATE_CSPRNG(csprng *,octet *);
+DLL_EXPORT int CREATE_SESSION_CSPRNG(csprng *);
 DLL_EXPORT void KILL_CSPRNG(csprng *);
 
 DLL_EXPORT int MPIN_GET_G1_MULTIPLE(csprng *,int,octet *,octet *,octet *);
 DLL_EXPORT int MPIN_GET_CLIENT_SECRET(octet *,octet *,octet *); 
 DLL_EXPORT int MPIN_GET_CLIENT_PERMIT(int,octet *,octet *,octet *); 
+DLL_EXPORT int MPIN_GET_CLIENT_PERMITS(int,octet *,int,octet **,octet **);
 DLL_EXPORT int MPIN_GET_SERVER_SECRET(octet *,octet *); 
 DLL_EXPORT int MPIN_TEST_PAIRING(octet *,octet *);
 
@@ -331,11 +331,10 @@ void OCT_chop(octet *x,octet *y,int n)
 /* set x to len random bytes */
 void OCT_rand(octet *x,csprng *RNG,int len)
 {
-    int i;
     if (len>x->max) len=x->max;
     x->len=len;
 
-    for (i=0;i<len;i++) x->val[i]=RAND_byte(RNG);
+    RAND_bytes(RNG,x->val,len);
 }
 
 /* Test program 
@@ -259,7 +259,7 @@ void PAIR_fexp(FP12 *r)
 
 /* Hard part of final exp - see Duquesne & Ghamman eprint 2015/192.pdf */
 
-	FP12_pow(&t0,r,x); // t0=f^-u
+	FP12_compow(&t0,r,x); // t0=f^-u
 	FP12_usqr(&y3,&t0); // y3=t0^2
 	FP12_copy(&y0,&t0); FP12_mul(&y0,&y3); // y0=t0*y3
 	FP12_copy(&y2,&y3); FP12_frob(&y2,&X); // y2=y3^p
@@ -267,7 +267,7 @@ void PAIR_fexp(FP12 *r)
 	FP12_usqr(&y2,&y2); //y2=y2^2
 	FP12_mul(&y2,&y3); // y2=y2*y3
 
-	FP12_pow(&t0,&y0,x);  //t0=y0^-u
+	FP12_compow(&t0,&y0,x);  //t0=y0^-u
 	FP12_conj(&y0,r);     //y0=~r
 	FP12_copy(&y1,&t0); FP12_frob(&y1,&X); FP12_frob(&y1,&X); //y1=t0^p^2
 	FP12_mul(&y1,&y0); // y1=y0*y1
@@ -277,7 +277,7 @@ void PAIR_fexp(FP12 *r)
 	FP12_usqr(&t0,&t0); // t0=t0^2
 	FP12_mul(&y1,&t0); // y1=t0*y1
 
-	FP12_pow(&t0,&y3,x); // t0=y3^-u
+	FP12_compow(&t0,&y3,x); // t0=y3^-u
 	FP12_usqr(&t0,&t0); //t0=t0^2
 	FP12_conj(&t0,&t0); //t0=~t0
 	FP12_mul(&y3,&t0); // y3=t0*y3
@@ -398,7 +398,7 @@ static void gs(BIG u[4],BIG e)
 	return;
 }
 
-/* Multiply P by e in group G1 */
+/* Multiply P by e in group G1. With USE_GLV P is not normalised - see ECP_batch_affine */
 void PAIR_G1mul(ECP *P,BIG e)
 {
 #ifdef USE_GLV   /* Note this method is patented */
@@ -528,7 +528,7 @@ void PAIR_GTpow(FP12 *f,BIG e)
 	FP12_pow4(f,g,u);
 
 #else
-	FP12_pow(f,f,e);
+	FP12_compow(f,f,e);
 #endif
 }
 
@@ -24,11 +24,152 @@ under the License.
  *   Slow - but secure
  *
  *   See ftp://ftp.rsasecurity.com/pub/pdfs/bull-1.pdf for a justification
+ *
+ *   With USE_CTR_DRBG defined the generator is instead an AES-128 CTR_DRBG as in
+ *   NIST SP800-90A, which produces a block of output per AES call.
  */
 /* SU=m, m is Stack Usage */
 
+#include <string.h>
 #include "clint.h"
 
+#ifdef USE_CTR_DRBG
+
+/* CTR_DRBG without derivation function. The seed material is conditioned with SHA-256 instead */
+
+#define DRBG_BLOCK 16
+#define DRBG_SEEDLEN 32             /* key length + block length */
+#define DRBG_MAX_REQUEST 65536      /* max bytes per generate request */
+
+static void drbg_increment(char *V)
+{ /* V=V+1 mod 2^128, big-endian */
+    int i;
+    for (i=DRBG_BLOCK-1;i>=0;i--)
+        if (++((uchar *)V)[i]!=0) break;
+}
+
+/* Update the DRBG state with DRBG_SEEDLEN bytes of data, or with zeros if data is NULL */
+static void drbg_update(csprng *rng,const char *data)
+{
+    int i;
+    char temp[DRBG_SEEDLEN];
+    for (i=0;i<DRBG_SEEDLEN;i+=DRBG_BLOCK)
+    {
+        drbg_increment(rng->V);
+        memcpy(&temp[i],rng->V,DRBG_BLOCK);
+        AES_ecb_encrypt(&rng->a,(uchar *)&temp[i]);
+    }
+    if (data!=NULL)
+        for (i=0;i<DRBG_SEEDLEN;i++) temp[i]^=data[i];
+
+    AES_init(&rng->a,ECB,temp,NULL);
+    memcpy(rng->V,&temp[DRBG_BLOCK],DRBG_BLOCK);
+    for (i=0;i<DRBG_SEEDLEN;i++) temp[i]=0;
+}
+
+static void drbg_generate(csprng *rng,char *out,int len)
+{
+    int i,n;
+    char block[DRBG_BLOCK];
+    while (len>0)
+    {
+        drbg_increment(rng->V);
+        if (len>=DRBG_BLOCK)
+        {
+            memcpy(out,rng->V,DRBG_BLOCK);
+            AES_ecb_encrypt(&rng->a,(uchar *)out);
+            n=DRBG_BLOCK;
+        }
+        else
+        {
+            memcpy(block,rng->V,DRBG_BLOCK);
+            AES_ecb_encrypt(&rng->a,(uchar *)block);
+            memcpy(out,block,len);
+            n=len;
+        }
+        out+=n; len-=n;
+    }
+    for (i=0;i<DRBG_BLOCK;i++) block[i]=0;
+    drbg_update(rng,NULL); /* backtracking resistance */
+}
+
+static void fill_pool(csprng *rng)
+{
+    drbg_generate(rng,rng->pool,32);
+    rng->pool_ptr=0;
+}
+
+/* Initialize RNG with some real entropy from some external source */
+void RAND_seed(csprng *rng,int rawlen,char *raw)
+{
+    int i;
+    char key[DRBG_BLOCK];
+    char digest[32];
+    hash sh;
+
+    HASH_init(&sh);
+    if (rawlen>0) HASH_update(&sh,raw,rawlen);
+    HASH_hash(&sh,digest);
+
+    for (i=0;i<DRBG_BLOCK;i++) key[i]=rng->V[i]=0;
+    AES_init(&rng->a,ECB,key,NULL);
+    drbg_update(rng,digest);
+    for (i=0;i<32;i++) digest[i]=0;
+
+    fill_pool(rng);
+}
+
+/* Terminate and clean up */
+void RAND_clean(csprng *rng)
+{ /* kill internal state */
+    int i;
+    AES_end(&rng->a);
+    for (i=0;i<DRBG_BLOCK;i++) rng->V[i]=0;
+    rng->pool_ptr=0;
+    for (i=0;i<32;i++) rng->pool[i]=0;
+}
+
+/* get random byte */
+int RAND_byte(csprng *rng)
+{ 
+    int r;
+    r=rng->pool[rng->pool_ptr++];
+    if (rng->pool_ptr>=32) fill_pool(rng);
+    return (r&0xff);
+}
+
+/* get len random bytes. Whatever is left in the pool goes first, the rest is generated directly into buf */
+void RAND_bytes(csprng *rng,char *buf,int len)
+{
+    int n=32-rng->pool_ptr;
+    if (n>len) n=len;
+    memcpy(buf,&rng->pool[rng->pool_ptr],n);
+    memset(&rng->pool[rng->pool_ptr],0,n);
+    rng->pool_ptr+=n;
+    buf+=n; len-=n;
+    if (rng->pool_ptr>=32) fill_pool(rng);
+
+    while (len>0)
+    {
+        n=len;
+        if (n>DRBG_MAX_REQUEST) n=DRBG_MAX_REQUEST;
+        drbg_generate(rng,buf,n);
+        buf+=n; len-=n;
+    }
+}
+
+/* Fork an independent generator from an initialised one */
+void RAND_fork(csprng *rng,csprng *child)
+{
+    int i;
+    char raw[DRBG_SEEDLEN];
+    RAND_bytes(rng,raw,DRBG_SEEDLEN);
+    RAND_seed(child,DRBG_SEEDLEN,raw);
+    for (i=0;i<DRBG_SEEDLEN;i++) raw[i]=0;
+}
+
+#else
+
 /* SU= 20 */
 static unsign32 sbrand(csprng *rng)
 { /* Marsaglia & Zaman random number generator */
@@ -75,10 +216,13 @@ static void sirand(csprng* rng,unsign32 seed)
 static void fill_pool(csprng *rng)
 { /* hash down output of RNG to re-fill the pool */
     int i;
+    char b[128];
     hash sh;
     HASH_init(&sh);
-    for (i=0;i<128;i++) HASH_process(&sh,sbrand(rng));
+    for (i=0;i<128;i++) b[i]=(char)sbrand(rng);
+    HASH_update(&sh,b,128);
     HASH_hash(&sh,rng->pool);
+    for (i=0;i<128;i++) b[i]=0;
     rng->pool_ptr=0;
 }
 
@@ -101,8 +245,7 @@ void RAND_seed(csprng *rng,int rawlen,char *raw)
     if (rawlen>0)
     {
         HASH_init(&sh);
-        for (i=0;i<rawlen;i++)
-            HASH_process(&sh,raw[i]);
+        HASH_update(&sh,raw,rawlen);
         HASH_hash(&sh,digest);
 
 /* initialise PRNG from distilled randomness */
@@ -137,6 +280,42 @@ int RAND_byte(csprng *rng)
     return (r&0xff);
 }
 
+/* get len random bytes - the same stream as len calls to RAND_byte() */
+void RAND_bytes(csprng *rng,char *buf,int len)
+{
+    int n;
+    while (len>0)
+    {
+        n=32-rng->pool_ptr;
+        if (n>len) n=len;
+        memcpy(buf,&rng->pool[rng->pool_ptr],n);
+        rng->pool_ptr+=n;
+        if (rng->pool_ptr>=32) fill_pool(rng);
+        buf+=n; len-=n;
+    }
+}
+
+/* Fork an independent generator from an initialised one */
+/* The child state is filled from the (hashed) output of the parent, so it reveals nothing about the parent state *
+ * and costs a few pool refills instead of the full RAND_seed() warm-up */
+void RAND_fork(csprng *rng,csprng *child)
+{
+    int i,j;
+    char b[4];
+    for (i=0;i<NK;i++)
+    {
+        for (j=0;j<4;j++) b[j]=(char)RAND_byte(rng);
+        child->ira[i]=pack((uchar *)b);
+    }
+    child->rndptr=0;
+    child->borrow=0;
+    for (i=0;i<4*NK;i++) sbrand(child); /* stir */
+    fill_pool(child);
+    for (j=0;j<4;j++) b[j]=0;
+}
+
+#endif
+
 /* test main program */
 /*
 #include <stdio.h>
@@ -0,0 +1,145 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+/*
+ *   Operating system entropy and per-thread generators
+ *
+ *   Each thread keeps one generator, seeded from the OS on first use and reseeded
+ *   every RAND_RESEED_INTERVAL forks (and after a fork() of the process).
+ *   Sessions get their own generator forked from it with RAND_fork(), so the
+ *   expensive RAND_seed() and the entropy syscall are not paid per session.
+ */
+
+#if defined(_WIN32)
+#define _CRT_RAND_S
+#include <stdlib.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+#endif
+
+#include "clint.h"
+
+#define RAND_SEED_BYTES 128         /* RAND_seed() wants at least 128 bytes of raw entropy */
+#define RAND_RESEED_INTERVAL 1024   /* forks between reseeds of the thread generator */
+
+typedef struct {
+csprng rng;
+int seeded;
+int forks;
+#if !defined(_WIN32)
+pid_t pid;
+#endif
+} thread_rng;
+
+static CLINT_THREAD_LOCAL thread_rng trng;
+
+#if !defined(_WIN32)
+static int read_urandom(char *buf,int len)
+{
+    int fd,n=0;
+    ssize_t r;
+    fd=open("/dev/urandom",O_RDONLY);
+    if (fd<0) return 0;
+    while (n<len)
+    {
+        r=read(fd,buf+n,len-n);
+        if (r<0 && errno==EINTR) continue;
+        if (r<=0) break;
+        n+=(int)r;
+    }
+    close(fd);
+    return (n==len);
+}
+#endif
+
+/* Fill buf with len bytes from the operating system. Returns 1 on success, 0 on failure */
+int RAND_os_entropy(char *buf,int len)
+{
+#if defined(_WIN32)
+    int i,j;
+    unsigned int r;
+    for (i=0;i<len;i+=4)
+    {
+        if (rand_s(&r)!=0) return 0;
+        for (j=0;j<4 && i+j<len;j++) {buf[i+j]=(char)(r&0xff); r>>=8;}
+    }
+    return 1;
+#else
+#if defined(__linux__) && defined(SYS_getrandom)
+    int n=0;
+    long r=0;
+    if (len<=0) return 1;
+    while (n<len)
+    {
+        r=syscall(SYS_getrandom,buf+n,(size_t)(len-n),0);
+        if (r<0 && errno==EINTR) continue;
+        if (r<=0) break;
+        n+=(int)r;
+    }
+    if (n==len) return 1;
+    if (r<0 && errno!=ENOSYS) return 0;
+    /* kernel without getrandom() */
+#endif
+    return read_urandom(buf,len);
+#endif
+}
+
+static int reseed(thread_rng *t)
+{
+    int i,ok;
+    char raw[RAND_SEED_BYTES+32];
+
+    ok=RAND_os_entropy(raw,RAND_SEED_BYTES);
+    if (ok)
+    {
+        /* Keep what is left of the old state in the mix, in case the OS entropy is weak */
+        if (t->seeded)
+            RAND_bytes(&t->rng,&raw[RAND_SEED_BYTES],32);
+        RAND_seed(&t->rng,t->seeded?RAND_SEED_BYTES+32:RAND_SEED_BYTES,raw);
+        t->seeded=1;
+        t->forks=0;
+#if !defined(_WIN32)
+        t->pid=getpid();
+#endif
+    }
+
+    for (i=0;i<RAND_SEED_BYTES+32;i++) raw[i]=0;
+    return ok;
+}
+
+/* Initialise child as a new generator forked from the calling thread's generator. Returns 1 on success, 0 if no entropy is available */
+int RAND_thread_fork(csprng *child)
+{
+    thread_rng *t=&trng;
+    int stale=(!t->seeded || t->forks>=RAND_RESEED_INTERVAL);
+#if !defined(_WIN32)
+    /* A forked process must not replay the parent's stream */
+    if (t->seeded && t->pid!=getpid()) stale=1;
+#endif
+    if (stale && !reseed(t)) return 0;
+
+    RAND_fork(&t->rng,child);
+    t->forks++;
+    return 1;
+}
@@ -312,6 +312,9 @@ const BIG CURVE_WB[4]={{0x1C2118567A84B0,0x3C012B040,0x2000},{0xCDF995BE220475,0
 const BIG CURVE_BB[4][4]={{{0x11C0A6332B0CBD,0xD6EE0CC906CE7E,0x647A6366D2C43F,0x8702A0DB0BDDF,0x24000000},{0x11C0A6332B0CBC,0xD6EE0CC906CE7E,0x647A6366D2C43F,0x8702A0DB0BDDF,0x24000000},{0x11C0A6332B0CBC,0xD6EE0CC906CE7E,0x647A6366D2C43F,0x8702A0DB0BDDF,0x24000000},{0x7802562,0x80}},{{0x7802561,0x80},{0x11C0A6332B0CBC,0xD6EE0CC906CE7E,0x647A6366D2C43F,0x8702A0DB0BDDF,0x24000000},{0x11C0A6332B0CBD,0xD6EE0CC906CE7E,0x647A6366D2C43F,0x8702A0DB0BDDF,0x24000000},{0x11C0A6332B0CBC,0xD6EE0CC906CE7E,0x647A6366D2C43F,0x8702A0DB0BDDF,0x24000000}},{{0x7802562,0x80},{0x7802561,0x80},{0x7802561,0x80},{0x7802561,0x80}},{{0x3C012B2,0x40},{0xF004AC2,0x100},{0x11C0A62F6AFA0A,0xD6EE0CC906CE3E,0x647A6366D2C43F,0x8702A0DB0BDDF,0x24000000},{0x3C012B2,0x40}}};
 #endif
 
+/* Sliding window addition chain for (p+1)/4, as pairs (n,d) - square n times, then multiply by d-th power if d>0 */
+const sign8 Sqrt_Chain[]={0,9,31,1,7,7,11,21,10,27,3,3,9,23,5,23,6,31,6,25,7,15,6,19,8,27,7,27,6,19,6,9,9,31,5,29,6,27,5,23,6,3,11,9,7,31,4,7,9,27,3,7,7,25,5,17,8,31,5,15,6,23,10,27,6,21,6,27,2,1,0,0};
+
 #endif
 
 #if CHOICE==NIST
@@ -36,12 +36,13 @@ public:
     typedef MPinSDK::String String;
     typedef MPinSDK::Status Status;
     typedef MPinSDK::UserPtr UserPtr;
+    typedef util::SecureBuffer SecureBuffer;
 
     virtual ~IMPinCrypto() {}
 
     virtual Status OpenSession() = 0;
     virtual void CloseSession() = 0;
-    virtual Status Register(IN UserPtr user, const String& pin, IN std::vector<String>& clientSecretShares) = 0;
+    virtual Status Register(IN UserPtr user, const String& pin, IN std::vector<SecureBuffer>& clientSecretShares) = 0;
     virtual Status AuthenticatePass1(IN UserPtr user, const String& pin, int date, IN std::vector<String>& timePermitShares, OUT String& commitmentU, OUT String& commitmentUT) = 0;
     virtual Status AuthenticatePass2(IN UserPtr user, const String& challenge, OUT String& validator) = 0;
     virtual void DeleteToken(const String& mpinId) = 0;
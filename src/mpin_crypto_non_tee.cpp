@@ -27,56 +27,119 @@ under the License.
 typedef MPinSDK::String String;
 typedef MPinSDK::Status Status;
 
-class Octet : public octet
+typedef util::SecureBuffer SecureBuffer;
+
+/*
+ * Octet with a fixed capacity, stored inline (on the stack for locals). The content is zeroized on destruction.
+ */
+template<int N>
+class FixedOctet : public octet
 {
 public:
-    Octet(size_t maxSize);
-    Octet(const String& str);
-    ~Octet();
-    String ToString();
+    FixedOctet()
+    {
+        Init();
+    }
 
-public:
-    static const int TOKEN_SIZE = 2 * PFS + 1;
-    static const int GROUP_SIZE = PGS;
+    FixedOctet(const char *data, size_t size)
+    {
+        Init();
+        Assign(data, size);
+    }
+
+    ~FixedOctet()
+    {
+        util::SecureZero(m_data, N);
+    }
+
+    bool Assign(const char *data, size_t size)
+    {
+        if(size > (size_t) N)
+        {
+            this->len = 0;
+            return false;
+        }
+        memcpy(m_data, data, size);
+        this->len = (int) size;
+        return true;
+    }
+
+    String ToString() const
+    {
+        return String(this->val, this->len);
+    }
+
+private:
+    FixedOctet(const FixedOctet&);
+    FixedOctet& operator = (const FixedOctet&);
+
+    void Init()
+    {
+        // Some crypto functions read whole group elements regardless of len, so never expose stale stack data
+        memset(m_data, 0, N);
+        this->val = m_data;
+        this->max = N;
+        this->len = 0;
+    }
+
+private:
+    char m_data[N];
 };
 
-Octet::Octet(size_t maxSize)
+/*
+ * Non-owning octet over existing data, for read-only crypto inputs
+ */
+class OctetView : public octet
 {
-    this->max = 0;
-    this->len = 0;
-    this->val = (char *) calloc(maxSize, 1);
-	if(this->val != NULL)
-	{
-		this->max = maxSize;		
-	}		
-}
+public:
+    OctetView(const char *data, size_t size)
+    {
+        this->val = (char *) data;
+        this->max = (int) size;
+        this->len = (int) size;
+    }
 
-Octet::Octet(const String& str)
-{
-    this->max = 0;
-    this->len = 0;
-    size_t maxSize = str.size();
-    this->val = (char *) malloc(maxSize);
-	if(this->val != NULL)
-	{
-		this->max = maxSize;
-		this->len = maxSize;
-		memcpy(this->val, str.c_str(), maxSize);		
-	}
-}
+    OctetView(const std::string& str)
+    {
+        this->val = (char *) str.data();
+        this->max = (int) str.size();
+        this->len = (int) str.size();
+    }
 
-Octet::~Octet()
-{
-    if(this->val != NULL)
+    OctetView(const SecureBuffer& buf)
     {
-        memset(this->val, 0, this->max);
-        free(this->val);
+        this->val = (char *) buf.Data();
+        this->max = (int) buf.Size();
+        this->len = (int) buf.Size();
     }
-}
+};
+
+static const int TOKEN_SIZE = 2 * PFS + 1;
+static const int GROUP_SIZE = PGS;
 
-String Octet::ToString()
+typedef FixedOctet<TOKEN_SIZE> TokenOctet;
+typedef FixedOctet<GROUP_SIZE> GroupOctet;
+
+// Checks if hex is the hex encoding of data, without allocating the encoded string
+static bool IsHexEncodingOf(const std::string& hex, const std::string& data)
 {
-    return String(this->val, this->len);
+    static const char *hexChars = "0123456789abcdef";
+
+    if(hex.length() != 2 * data.length())
+    {
+        return false;
+    }
+
+    for(size_t i = 0; i < data.length(); ++i)
+    {
+        unsigned char c = (unsigned char) data[i];
+        if(tolower(hex[2 * i]) != hexChars[c >> 4] || tolower(hex[2 * i + 1]) != hexChars[c & 0x0F])
+        {
+            return false;
+        }
+    }
+
+    return true;
 }
 
 
@@ -109,7 +172,9 @@ Status MPinCryptoNonTee::Init(IStorage *storage)
     tokensJson.Trim();
     if(tokensJson.length() > 0)
     {
-        if(!m_tokens.Parse(tokensJson.c_str()))
+        bool parsed = m_tokens.Parse(tokensJson.c_str());
+        tokensJson.Overwrite();
+        if(!parsed)
         {
             return Status(Status::STORAGE_ERROR, String("Failed to parse tokens json"));
         }
@@ -125,6 +190,9 @@ void MPinCryptoNonTee::Destroy()
     if(m_initialized)
     {
         CloseSession();
+        util::OverwriteJsonValues(m_tokens);
+        m_tokens.Clear();
+        m_mappedIds.clear();
         m_initialized = false;
     }
 }
@@ -154,7 +222,7 @@ void MPinCryptoNonTee::CloseSession()
     }
 }
 
-Status MPinCryptoNonTee::Register(UserPtr user, const String& pin, std::vector<String>& clientSecretShares)
+Status MPinCryptoNonTee::Register(UserPtr user, const String& pin, std::vector<SecureBuffer>& clientSecretShares)
 {
     const String& mpinId = user->GetMPinId();
     
@@ -169,9 +237,9 @@ Status MPinCryptoNonTee::Register(UserPtr user, const String& pin, std::vector<S
         return Status(Status::CRYPTO_ERROR, String().Format("Expecting 2 client secret shares (provided=%d)", (int) clientSecretShares.size()));
     }
 
-    Octet cs1(clientSecretShares[0]);
-    Octet cs2(clientSecretShares[1]);
-    Octet token(Octet::TOKEN_SIZE);
+    OctetView cs1(clientSecretShares[0]);
+    OctetView cs2(clientSecretShares[1]);
+    TokenOctet token;
 
     int res = MPIN_RECOMBINE_G1(&cs1, &cs2, &token);
     if(res)
@@ -185,7 +253,7 @@ Status MPinCryptoNonTee::Register(UserPtr user, const String& pin, std::vector<S
     }
 
     // Extract the pin from the secret
-    Octet cid(mpinId);
+    OctetView cid(mpinId);
     res = MPIN_EXTRACT_PIN(&cid, pin.GetHash(), &token);
     if(res)
     {
@@ -193,7 +261,7 @@ Status MPinCryptoNonTee::Register(UserPtr user, const String& pin, std::vector<S
     }
 
     // Save the token securely
-    if(!StoreToken(mpinId, token.ToString()))
+    if(!StoreToken(mpinId, token))
     {
         return Status(Status::STORAGE_ERROR, String("Failed to store token"));
     }
@@ -210,7 +278,7 @@ Status MPinCryptoNonTee::AuthenticatePass1(UserPtr user, const String& pin, int
         return Status(Status::CRYPTO_ERROR, String("Session is not opened or not initialized"));
     }
 
-    Octet timePermit(Octet::TOKEN_SIZE);
+    TokenOctet timePermit;
 
     // Valid date (date != 0) means authentication *with* time permit and 2 time permit shares are expected
     // Invalid date (date == 0) means authentication with *no* time permit and time permit shares are ignored
@@ -222,8 +290,8 @@ Status MPinCryptoNonTee::AuthenticatePass1(UserPtr user, const String& pin, int
             return Status(Status::CRYPTO_ERROR, String().Format("Expecting 2 time permit shares (provided=%d)", (int) timePermitShares.size()));
         }
 
-        Octet tp1(timePermitShares[0]);
-        Octet tp2(timePermitShares[1]);
+        OctetView tp1(timePermitShares[0]);
+        OctetView tp2(timePermitShares[1]);
 
         int res = MPIN_RECOMBINE_G1(&tp1, &tp2, &timePermit);
         if(res)
@@ -233,8 +301,8 @@ Status MPinCryptoNonTee::AuthenticatePass1(UserPtr user, const String& pin, int
     }
 
     // Get the stored token
-    String tokenStr = GetToken(mpinId);
-    if(tokenStr.length() == 0)
+    TokenOctet token;
+    if(!GetToken(mpinId, token))
     {
         return Status(Status::CRYPTO_ERROR, String().Format("Failed to find stored token for mpinId='%s'", mpinId.c_str()));
     }
@@ -246,33 +314,36 @@ Status MPinCryptoNonTee::AuthenticatePass1(UserPtr user, const String& pin, int
 
     // Gather the parameters for Authentication pass 1
 
-    Octet cid(mpinId);
+    TokenOctet hcid;
+    TokenOctet htcid;
+    MapClientId(mpinId, date, hcid, htcid);
 
-    Octet seed(100);
-    seed.len = seed.max;
-    GenerateRandomSeed(seed.val, seed.len);
+    // TODO: seedValue from client settings must be included here
     csprng rng;
-    CREATE_CSPRNG(&rng,&seed);
+    if(!CREATE_SESSION_CSPRNG(&rng))
+    {
+        return Status(Status::CRYPTO_ERROR, String("Failed to get entropy for the random number generator"));
+    }
 
-    Octet x(Octet::GROUP_SIZE);
-    Octet token(tokenStr);
-    Octet clientSecret(Octet::TOKEN_SIZE);
-    Octet u(Octet::TOKEN_SIZE);
-    Octet ut(Octet::TOKEN_SIZE);
+    GroupOctet x;
+    TokenOctet clientSecret;
+    TokenOctet u;
+    TokenOctet ut;
 
     // Authentication pass 1
-    int res = MPIN_CLIENT_1(date, &cid, &rng, &x, pin.GetHash(), &token, &clientSecret, &u, &ut, &timePermit);
+    int res = MPIN_CLIENT_1_PRECOMP(date, &hcid, &htcid, &rng, &x, pin.GetHash(), &token, &clientSecret, &u, &ut, &timePermit);
+
+    KILL_CSPRNG(&rng);
+
     if(res)
     {
-        return Status(Status::CRYPTO_ERROR, String().Format("MPIN_CLIENT_1() failed with code %d", res));
+        return Status(Status::CRYPTO_ERROR, String().Format("MPIN_CLIENT_1_PRECOMP() failed with code %d", res));
     }
 
-    KILL_CSPRNG(&rng);
-
     commitmentU = u.ToString();
     commitmentUT = ut.ToString();
 
-    SaveDataForPass2(mpinId, clientSecret.ToString(), x.ToString());
+    SaveDataForPass2(mpinId, clientSecret, x);
 
     return Status(Status::OK);
 }
@@ -291,9 +362,15 @@ Status MPinCryptoNonTee::AuthenticatePass2(UserPtr user, const String& challenge
         return Status(Status::CRYPTO_ERROR, String("Wrong mpinId passed for authentication pass 2"));
     }
 
-    Octet x(m_x);
-    Octet y(challenge);
-    Octet v(m_clientSecret);
+    // MPIN_CLIENT_2 reads full group elements from x and y and writes the result over v
+    GroupOctet x(m_x.Data(), m_x.Size());
+    TokenOctet v(m_clientSecret.Data(), m_clientSecret.Size());
+    GroupOctet y;
+    if(!y.Assign(challenge.data(), challenge.size()))
+    {
+        ForgetPass2Data();
+        return Status(Status::CRYPTO_ERROR, String().Format("Invalid challenge size %d for authentication pass 2", (int) challenge.size()));
+    }
 
     int res = MPIN_CLIENT_2(&x, &y, &v);
 
@@ -331,7 +408,7 @@ Status MPinCryptoNonTee::SaveRegOTT(const String& mpinId, const String& regOTT)
 			i->element["regOTT"] = json::String(regOTT);
 		}
 		
-		m_storage->SetData(m_tokens.ToString());
+		WriteTokens();
 		
 		return Status(Status::OK);
 		
@@ -401,7 +478,7 @@ Status MPinCryptoNonTee::DeleteRegOTT(const String& mpinId)
 			}
 		}
 
-		if(!m_storage->SetData(m_tokens.ToString()))
+		if(!WriteTokens())
         {
             return Status(Status::STORAGE_ERROR, m_storage->GetErrorMessage());
         }
@@ -414,37 +491,51 @@ Status MPinCryptoNonTee::DeleteRegOTT(const String& mpinId)
     }
 }
 
-bool MPinCryptoNonTee::StoreToken(const String& mpinId, const String& token)
+bool MPinCryptoNonTee::StoreToken(const String& mpinId, const octet& token)
 {
-    if(token.length() == 0)
+    if(token.len == 0)
     {
         return false;
     }
 
     String mpinIdHex = util::HexEncode(mpinId);
+    String tokenHex = util::HexEncode(token.val, token.len);
     try
     {
         json::Object element;
-        element["token"] = json::String(util::HexEncode(token));
+        element["token"] = json::String(tokenHex);
+        json::Object::iterator i = m_tokens.Find(mpinIdHex);
+        if(i != m_tokens.End())
+        {
+            util::OverwriteJsonValues(i->element);
+        }
         m_tokens[mpinIdHex] = element;
+        util::OverwriteJsonValues(element);
     }
     catch(json::Exception e)
     {
+        tokenHex.Overwrite();
         return false;
     }
 
+    tokenHex.Overwrite();
+
+    return WriteTokens();
+}
+
+bool MPinCryptoNonTee::WriteTokens()
+{
+    // The serialized tokens are the only plain copy of the secrets outside of m_tokens, so wipe them right away
     String tokensJson = m_tokens.ToString();
     if(tokensJson.length() == 0)
     {
         return false;
     }
 
-    if(!m_storage->SetData(tokensJson))
-    {
-        return false;
-    }
+    bool res = m_storage->SetData(tokensJson);
+    tokensJson.Overwrite();
 
-    return true;
+    return res;
 }
 
 void MPinCryptoNonTee::DeleteToken(const String& mpinId)
@@ -457,65 +548,92 @@ void MPinCryptoNonTee::DeleteToken(const String& mpinId)
             return;
         }
 
+        util::OverwriteJsonValues(i->element);
         m_tokens.Erase(i);
-        m_storage->SetData(m_tokens.ToString());
+        m_mappedIds.erase(mpinId);
+        WriteTokens();
     }
     catch(json::Exception)
     {
     }
 }
 
-String MPinCryptoNonTee::GetToken(const String& mpinId)
+bool MPinCryptoNonTee::GetToken(const String& mpinId, octet& token)
 {
-    try
+    token.len = 0;
+
+    // Look the token up by comparing against the hex encoded ids in place, to keep authentication allocation free
+    for(json::Object::const_iterator i = m_tokens.Begin(); i != m_tokens.End(); ++i)
     {
-        json::Object::iterator i = m_tokens.Find(util::HexEncode(mpinId));
-        if(i == m_tokens.End())
+        if(!IsHexEncodingOf(i->name, mpinId))
         {
-            return "";
+            continue;
         }
 
-        return util::HexDecode((std::string) ((json::String) i->element["token"]));
+        try
+        {
+            const json::String& tokenHex = (const json::String&) ((const json::Object&) i->element)["token"];
+            token.len = (int) util::HexDecode(tokenHex.Value(), token.val, token.max);
+        }
+        catch(const json::Exception&)
+        {
+            return false;
+        }
+
+        return token.len > 0;
     }
-    catch(json::Exception e)
+
+    return false;
+}
+
+void MPinCryptoNonTee::MapClientId(const String& mpinId, int date, octet& hcid, octet& htcid)
+{
+    // Hashing to the curve is the costliest part of pass 1 after the point multiplications. H(ID) never changes
+    // and H(T|H(ID)) changes once per time permit period, so map them only when needed and keep the points.
+    MappedId& mapped = m_mappedIds[mpinId];
+    OctetView cid(mpinId);
+
+    if(mapped.hcid.empty())
+    {
+        MPIN_MAP_CLIENT_ID(0, &cid, &hcid, NULL);
+        mapped.hcid.assign(hcid.val, hcid.len);
+    }
+    else
+    {
+        memcpy(hcid.val, mapped.hcid.data(), mapped.hcid.size());
+        hcid.len = (int) mapped.hcid.size();
+    }
+
+    if(date == 0)
     {
-        return "";
+        return;
+    }
+
+    if(mapped.date != date)
+    {
+        MPIN_MAP_CLIENT_ID(date, &cid, NULL, &htcid);
+        mapped.htcid.assign(htcid.val, htcid.len);
+        mapped.date = date;
+    }
+    else
+    {
+        memcpy(htcid.val, mapped.htcid.data(), mapped.htcid.size());
+        htcid.len = (int) mapped.htcid.size();
     }
 }
 
-void MPinCryptoNonTee::SaveDataForPass2(const String& mpinId, const String& clientSecret, const String& x)
+void MPinCryptoNonTee::SaveDataForPass2(const String& mpinId, const octet& clientSecret, const octet& x)
 {
     ForgetPass2Data();
 
     m_mpinId = mpinId;
-    m_clientSecret = clientSecret;
-    m_x = x;
+    m_clientSecret.Assign(clientSecret.val, clientSecret.len);
+    m_x.Assign(x.val, x.len);
 }
 
 void MPinCryptoNonTee::ForgetPass2Data()
 {
-    m_mpinId.Overwrite();
-    m_clientSecret.Overwrite();
-    m_x.Overwrite();
-}
-
-void MPinCryptoNonTee::GenerateRandomSeed(char *buf, size_t len)
-{
-    // TODO: This should be changed/improved to generate some real entropy
-    // TODO: seedValue from client settings must be included here
-#ifndef _WIN32
-    FILE *fp = fopen("/dev/urandom", "rb");
-    if(fp != NULL)
-    {
-        size_t rc = fread(buf, 1, len, fp);
-        fclose(fp);
-    }
-#else
-    srand((unsigned int) time(NULL));
-    for(size_t i = 0; i < len; ++i)
-    {
-        int r = (rand() * 256) / RAND_MAX;
-        buf[i] = r;
-    }
-#endif
+    m_mpinId.clear();
+    m_clientSecret.Clear();
+    m_x.Clear();
 }
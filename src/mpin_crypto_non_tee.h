@@ -25,6 +25,7 @@ under the License.
 #define _MPIN_CRYPTO_NON_TEE_H_
 
 #include "mpin_crypto.h"
+#include <map>
 extern "C"
 {
 #include "crypto/mpin.h"
@@ -45,7 +46,7 @@ public:
 
     virtual Status OpenSession();
     virtual void CloseSession();
-    virtual Status Register(IN UserPtr user, const String& pin, IN std::vector<String>& clientSecretShares);
+    virtual Status Register(IN UserPtr user, const String& pin, IN std::vector<SecureBuffer>& clientSecretShares);
     virtual Status AuthenticatePass1(IN UserPtr user, const String& pin, int date, IN std::vector<String>& timePermitShares, OUT String& commitmentU, OUT String& commitmentUT);
     virtual Status AuthenticatePass2(IN UserPtr user, const String& challenge, OUT String& validator);
     virtual void DeleteToken(const String& mpinId);
@@ -55,20 +56,33 @@ public:
     virtual Status DeleteRegOTT(const String& mpinId);
 
 private:
-    bool StoreToken(const String& mpinId, const String& token);
-    String GetToken(const String& mpinId);
-    void SaveDataForPass2(const String& mpinId, const String& clientSecret, const String& x);
+    bool StoreToken(const String& mpinId, const octet& token);
+    bool GetToken(const String& mpinId, OUT octet& token);
+    void MapClientId(const String& mpinId, int date, OUT octet& hcid, OUT octet& htcid);
+    bool WriteTokens();
+    void SaveDataForPass2(const String& mpinId, const octet& clientSecret, const octet& x);
     void ForgetPass2Data();
-    static void GenerateRandomSeed(OUT char *buf, size_t len);
+
+private:
+    // The user's identity mapped to the curve - H(ID), and H(T|H(ID)) for the last time permit date
+    struct MappedId
+    {
+        MappedId() : date(0) {}
+        String hcid;
+        int date;
+        String htcid;
+    };
+    typedef std::map<String, MappedId> MappedIdMap;
 
 private:
     IStorage *m_storage;
     bool m_initialized;
     bool m_sessionOpened;
     String m_mpinId;
-    String m_clientSecret;
-    String m_x;
+    SecureBuffer m_clientSecret;
+    SecureBuffer m_x;
     JsonObject m_tokens;
+    MappedIdMap m_mappedIds;
 };
 
 
@@ -0,0 +1,264 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+/*
+ * M-Pin SDK metrics listeners
+ */
+
+#include "mpin_metrics.h"
+#include <fstream>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+typedef MPinSDK::IMetricsListener IMetricsListener;
+
+namespace
+{
+
+int64_t NowNs()
+{
+#if defined(_WIN32)
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (int64_t) (counter.QuadPart * (1e9 / frequency.QuadPart));
+#elif defined(__APPLE__)
+    static mach_timebase_info_data_t timebase;
+    if(timebase.denom == 0)
+    {
+        mach_timebase_info(&timebase);
+    }
+    return (int64_t) (mach_absolute_time() * timebase.numer / timebase.denom);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+const char * SpanTypeToString(IMetricsListener::SpanType type)
+{
+    switch(type)
+    {
+    case IMetricsListener::HTTP_REQUEST: return "http";
+    case IMetricsListener::CRYPTO_CALL: return "crypto";
+    case IMetricsListener::STORAGE_ACCESS: return "storage";
+    }
+
+    return "unknown";
+}
+
+bool IsFailure(IMetricsListener::SpanType type, int status)
+{
+    if(type == IMetricsListener::HTTP_REQUEST)
+    {
+        return status != 200;
+    }
+
+    return status != MPinSDK::Status::OK;
+}
+
+}
+
+
+/*
+ * MetricsAggregator class
+ */
+
+MetricsAggregator::Stats::Stats() : type(HTTP_REQUEST), name(""), count(0), failures(0), totalNs(0), minNs(0), maxNs(0),
+    bytesSent(0), bytesReceived(0)
+{
+}
+
+void MetricsAggregator::OnSpanBegin(const Span& span)
+{
+    m_beginNs.push_back(NowNs());
+}
+
+void MetricsAggregator::OnSpanEnd(const Span& span)
+{
+    int64_t durationNs = NowNs() - m_beginNs.back();
+    m_beginNs.pop_back();
+
+    // Span names are string literals and only a few distinct spans exist, so a linear search by pointer is the
+    // cheapest lookup
+    Stats *stats = NULL;
+    for(StatsList::iterator i = m_stats.begin(); i != m_stats.end(); ++i)
+    {
+        if(i->name == span.name && i->type == span.type)
+        {
+            stats = &(*i);
+            break;
+        }
+    }
+
+    if(stats == NULL)
+    {
+        m_stats.push_back(Stats());
+        stats = &m_stats.back();
+        stats->type = span.type;
+        stats->name = span.name;
+        stats->minNs = durationNs;
+    }
+
+    ++stats->count;
+    if(IsFailure(span.type, span.status))
+    {
+        ++stats->failures;
+    }
+    stats->totalNs += durationNs;
+    if(durationNs < stats->minNs)
+    {
+        stats->minNs = durationNs;
+    }
+    if(durationNs > stats->maxNs)
+    {
+        stats->maxNs = durationNs;
+    }
+    stats->bytesSent += span.bytesSent;
+    stats->bytesReceived += span.bytesReceived;
+}
+
+const MetricsAggregator::StatsList& MetricsAggregator::GetStats() const
+{
+    return m_stats;
+}
+
+util::JsonObject MetricsAggregator::ToJson() const
+{
+    util::JsonObject json;
+    for(StatsList::const_iterator i = m_stats.begin(); i != m_stats.end(); ++i)
+    {
+        json::Object stats;
+        stats["count"] = json::Number((double) i->count);
+        stats["failures"] = json::Number((double) i->failures);
+        stats["total_ms"] = json::Number(i->totalNs / 1e6);
+        stats["avg_ms"] = json::Number(i->count > 0 ? i->totalNs / 1e6 / i->count : 0);
+        stats["min_ms"] = json::Number(i->minNs / 1e6);
+        stats["max_ms"] = json::Number(i->maxNs / 1e6);
+        stats["bytes_sent"] = json::Number((double) i->bytesSent);
+        stats["bytes_received"] = json::Number((double) i->bytesReceived);
+        json[MPinSDK::String().Format("%s/%s", SpanTypeToString(i->type), i->name)] = stats;
+    }
+
+    return json;
+}
+
+void MetricsAggregator::Reset()
+{
+    m_stats.clear();
+    m_beginNs.clear();
+}
+
+
+/*
+ * ChromeTraceRecorder class
+ */
+
+ChromeTraceRecorder::ChromeTraceRecorder() : m_startNs(-1)
+{
+}
+
+void ChromeTraceRecorder::OnSpanBegin(const Span& span)
+{
+    Event event;
+    event.begin = true;
+    event.type = span.type;
+    event.name = span.name;
+    event.timeNs = NowNs();
+    event.bytesSent = 0;
+    event.bytesReceived = 0;
+    event.status = 0;
+
+    if(m_startNs < 0)
+    {
+        m_startNs = event.timeNs;
+    }
+
+    m_events.push_back(event);
+}
+
+void ChromeTraceRecorder::OnSpanEnd(const Span& span)
+{
+    Event event;
+    event.begin = false;
+    event.type = span.type;
+    event.name = span.name;
+    event.timeNs = NowNs();
+    event.bytesSent = span.bytesSent;
+    event.bytesReceived = span.bytesReceived;
+    event.status = span.status;
+
+    m_events.push_back(event);
+}
+
+util::JsonObject ChromeTraceRecorder::ToJson() const
+{
+    json::Array events;
+    for(std::vector<Event>::const_iterator i = m_events.begin(); i != m_events.end(); ++i)
+    {
+        json::Object event;
+        event["name"] = json::String(i->name);
+        event["cat"] = json::String(SpanTypeToString(i->type));
+        event["ph"] = json::String(i->begin ? "B" : "E");
+        event["ts"] = json::Number((i->timeNs - m_startNs) / 1e3);
+        event["pid"] = json::Number(1);
+        event["tid"] = json::Number(1);
+
+        if(!i->begin)
+        {
+            json::Object args;
+            args["status"] = json::Number(i->status);
+            args["bytes_sent"] = json::Number((double) i->bytesSent);
+            args["bytes_received"] = json::Number((double) i->bytesReceived);
+            event["args"] = args;
+        }
+
+        events.Insert(event);
+    }
+
+    util::JsonObject json;
+    json["traceEvents"] = events;
+    json["displayTimeUnit"] = json::String("ms");
+    return json;
+}
+
+bool ChromeTraceRecorder::WriteToFile(const MPinSDK::String& fileName) const
+{
+    std::ofstream file(fileName.c_str());
+    if(!file.is_open())
+    {
+        return false;
+    }
+
+    file << ToJson().ToString();
+    return file.good();
+}
+
+void ChromeTraceRecorder::Clear()
+{
+    m_events.clear();
+    m_startNs = -1;
+}
@@ -0,0 +1,100 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+/*
+ * Ready-made MPinSDK::IMetricsListener implementations
+ *
+ * MetricsAggregator keeps a count, total/min/max time, byte counts and failures per span, which is cheap enough to
+ * leave on in production. ChromeTraceRecorder keeps every span and exports them in the Chrome trace event format,
+ * to be opened with chrome://tracing or Perfetto. Neither is thread safe - use one listener per MPinSDK instance.
+ */
+
+#ifndef _MPIN_SDK_METRICS_H_
+#define _MPIN_SDK_METRICS_H_
+
+#include "mpin_sdk.h"
+
+
+class MetricsAggregator : public MPinSDK::IMetricsListener
+{
+public:
+    class Stats
+    {
+    public:
+        Stats();
+
+        SpanType type;
+        const char *name;
+        unsigned long count;
+        // Spans that ended with a non-200 HTTP status or a non-OK status
+        unsigned long failures;
+        int64_t totalNs;
+        int64_t minNs;
+        int64_t maxNs;
+        unsigned long long bytesSent;
+        unsigned long long bytesReceived;
+    };
+
+    typedef std::vector<Stats> StatsList;
+
+    virtual void OnSpanBegin(const Span& span);
+    virtual void OnSpanEnd(const Span& span);
+
+    // Stats in the order the spans were first seen
+    const StatsList& GetStats() const;
+    // {"<type>/<name>": {"count": ..., "failures": ..., "total_ms": ..., ...}, ...}
+    util::JsonObject ToJson() const;
+    void Reset();
+
+private:
+    StatsList m_stats;
+    std::vector<int64_t> m_beginNs;
+};
+
+class ChromeTraceRecorder : public MPinSDK::IMetricsListener
+{
+public:
+    ChromeTraceRecorder();
+
+    virtual void OnSpanBegin(const Span& span);
+    virtual void OnSpanEnd(const Span& span);
+
+    // {"traceEvents": [...]} with a begin and an end event per span, timestamps in microseconds from the first span
+    util::JsonObject ToJson() const;
+    bool WriteToFile(const MPinSDK::String& fileName) const;
+    void Clear();
+
+private:
+    class Event
+    {
+    public:
+        bool begin;
+        SpanType type;
+        const char *name;
+        int64_t timeNs;
+        size_t bytesSent;
+        size_t bytesReceived;
+        int status;
+    };
+
+    std::vector<Event> m_events;
+    int64_t m_startNs;
+};
+
+#endif // _MPIN_SDK_METRICS_H_
@@ -27,6 +27,7 @@ under the License.
 #include "version.h"
 #include "json/visitor.h"
 #include <sstream>
+#include <string.h>
 
 typedef MPinSDK::Status Status;
 typedef MPinSDK::User User;
@@ -340,13 +341,15 @@ bool MPinSDK::HttpResponse::SetData(const String& rawData, const StringMap& head
 
     String data = rawData;
     data.Trim();
-    if(data.length() > 0 && !m_jsonData.Parse(data.c_str()))
+    bool parsed = data.length() == 0 || m_jsonData.Parse(data.c_str());
+    if(!parsed)
     {
         SetResponseJsonParseError(data, m_jsonData.GetParseError());
-        return false;
     }
 
-    return true;
+    // The trimmed copy goes back to the heap with the rest of the body in it
+    data.Overwrite();
+    return parsed;
 }
 
 const util::JsonObject& MPinSDK::HttpResponse::GetJsonData() const
@@ -364,6 +367,12 @@ const StringMap& MPinSDK::HttpResponse::GetHeaders() const
     return m_headers;
 }
 
+void MPinSDK::HttpResponse::Overwrite()
+{
+    util::OverwriteJsonValues(m_jsonData);
+    m_rawData.Overwrite();
+}
+
 void MPinSDK::HttpResponse::SetNetworkError(const String& error)
 {
     m_httpStatus = NON_HTTP_ERROR;
@@ -435,6 +444,9 @@ Status MPinSDK::HttpResponse::TranslateToMPinStatus(Context context)
     case AUTHENTICATE_PASS1:
     case AUTHENTICATE_PASS2:
     case GET_SESSION_DETAILS:
+    case GET_STORED_TIME_PERMIT:
+    case SEND_CODE_STATUS:
+    case LOGOUT:
         break;
     case REGISTER:
         if(m_httpStatus == HTTP_FORBIDDEN)
@@ -502,18 +514,207 @@ Status MPinSDK::HttpResponse::TranslateToMPinStatus(Context context)
     return m_mpinStatus;
 }
 
+const char * MPinSDK::HttpResponse::ContextToString(Context context)
+{
+    switch(context)
+    {
+    case GET_SERVICE_DETAILS: return "GET_SERVICE_DETAILS";
+    case GET_CLIENT_SETTINGS: return "GET_CLIENT_SETTINGS";
+    case REGISTER: return "REGISTER";
+    case GET_CLIENT_SECRET1: return "GET_CLIENT_SECRET1";
+    case GET_CLIENT_SECRET2: return "GET_CLIENT_SECRET2";
+    case GET_TIME_PERMIT1: return "GET_TIME_PERMIT1";
+    case GET_TIME_PERMIT2: return "GET_TIME_PERMIT2";
+    case AUTHENTICATE_PASS1: return "AUTHENTICATE_PASS1";
+    case AUTHENTICATE_PASS2: return "AUTHENTICATE_PASS2";
+    case AUTHENTICATE_RPA: return "AUTHENTICATE_RPA";
+    case GET_SESSION_DETAILS: return "GET_SESSION_DETAILS";
+    case GET_STORED_TIME_PERMIT: return "GET_STORED_TIME_PERMIT";
+    case SEND_CODE_STATUS: return "SEND_CODE_STATUS";
+    case LOGOUT: return "LOGOUT";
+    }
+
+    return "UNKNOWN";
+}
+
+
+
+/*
+ * Metrics instrumentation. The crypto and the storage are wrapped only when the context provides a metrics listener,
+ * so the SDK calls them directly otherwise.
+ */
+
+typedef MPinSDK::IMetricsListener IMetricsListener;
+typedef MPinSDK::IStorage IStorage;
+
+namespace
+{
+
+class MetricsSpan
+{
+public:
+    MetricsSpan(IMetricsListener *listener, IMetricsListener::SpanType type, const char *name) : m_listener(listener), m_span(type, name)
+    {
+        if(m_listener != NULL)
+        {
+            m_listener->OnSpanBegin(m_span);
+        }
+    }
+
+    ~MetricsSpan()
+    {
+        if(m_listener != NULL)
+        {
+            m_listener->OnSpanEnd(m_span);
+        }
+    }
+
+    IMetricsListener::Span& Get()
+    {
+        return m_span;
+    }
+
+    const Status& SetStatus(const Status& status)
+    {
+        m_span.status = status.GetStatusCode();
+        return status;
+    }
+
+private:
+    MetricsSpan(const MetricsSpan&);
+    MetricsSpan& operator=(const MetricsSpan&);
+
+    IMetricsListener *m_listener;
+    IMetricsListener::Span m_span;
+};
+
+class MetricsCrypto : public IMPinCrypto
+{
+public:
+    MetricsCrypto(IMetricsListener *listener, IMPinCrypto *crypto) : m_listener(listener), m_crypto(crypto) {}
+    virtual ~MetricsCrypto() { delete m_crypto; }
+
+    virtual Status OpenSession()
+    {
+        MetricsSpan span(m_listener, IMetricsListener::CRYPTO_CALL, "OpenSession");
+        return span.SetStatus(m_crypto->OpenSession());
+    }
+
+    virtual void CloseSession()
+    {
+        MetricsSpan span(m_listener, IMetricsListener::CRYPTO_CALL, "CloseSession");
+        m_crypto->CloseSession();
+    }
+
+    virtual Status Register(UserPtr user, const String& pin, std::vector<SecureBuffer>& clientSecretShares)
+    {
+        MetricsSpan span(m_listener, IMetricsListener::CRYPTO_CALL, "Register");
+        return span.SetStatus(m_crypto->Register(user, pin, clientSecretShares));
+    }
+
+    virtual Status AuthenticatePass1(UserPtr user, const String& pin, int date, std::vector<String>& timePermitShares, String& commitmentU, String& commitmentUT)
+    {
+        MetricsSpan span(m_listener, IMetricsListener::CRYPTO_CALL, "AuthenticatePass1");
+        return span.SetStatus(m_crypto->AuthenticatePass1(user, pin, date, timePermitShares, commitmentU, commitmentUT));
+    }
+
+    virtual Status AuthenticatePass2(UserPtr user, const String& challenge, String& validator)
+    {
+        MetricsSpan span(m_listener, IMetricsListener::CRYPTO_CALL, "AuthenticatePass2");
+        return span.SetStatus(m_crypto->AuthenticatePass2(user, challenge, validator));
+    }
+
+    virtual void DeleteToken(const String& mpinId)
+    {
+        MetricsSpan span(m_listener, IMetricsListener::CRYPTO_CALL, "DeleteToken");
+        m_crypto->DeleteToken(mpinId);
+    }
+
+    virtual Status SaveRegOTT(const String& mpinId, const String& regOTT)
+    {
+        MetricsSpan span(m_listener, IMetricsListener::CRYPTO_CALL, "SaveRegOTT");
+        return span.SetStatus(m_crypto->SaveRegOTT(mpinId, regOTT));
+    }
+
+    virtual Status LoadRegOTT(const String& mpinId, String& regOTT)
+    {
+        MetricsSpan span(m_listener, IMetricsListener::CRYPTO_CALL, "LoadRegOTT");
+        return span.SetStatus(m_crypto->LoadRegOTT(mpinId, regOTT));
+    }
+
+    virtual Status DeleteRegOTT(const String& mpinId)
+    {
+        MetricsSpan span(m_listener, IMetricsListener::CRYPTO_CALL, "DeleteRegOTT");
+        return span.SetStatus(m_crypto->DeleteRegOTT(mpinId));
+    }
+
+private:
+    MetricsCrypto(const MetricsCrypto&);
+    MetricsCrypto& operator=(const MetricsCrypto&);
+
+    IMetricsListener *m_listener;
+    IMPinCrypto *m_crypto;
+};
+
+class MetricsStorage : public IStorage
+{
+public:
+    MetricsStorage(IMetricsListener *listener, IStorage::Type type, IStorage *storage) :
+        m_listener(listener), m_storage(storage),
+        m_readName(type == IStorage::SECURE ? "secure/read" : "nonsecure/read"),
+        m_writeName(type == IStorage::SECURE ? "secure/write" : "nonsecure/write")
+    {
+    }
+
+    virtual bool SetData(const String& data)
+    {
+        MetricsSpan span(m_listener, IMetricsListener::STORAGE_ACCESS, m_writeName);
+        bool res = m_storage->SetData(data);
+        span.Get().bytesSent = data.size();
+        span.Get().status = res ? Status::OK : Status::STORAGE_ERROR;
+        return res;
+    }
+
+    virtual bool GetData(String& data)
+    {
+        MetricsSpan span(m_listener, IMetricsListener::STORAGE_ACCESS, m_readName);
+        bool res = m_storage->GetData(data);
+        span.Get().bytesReceived = data.size();
+        span.Get().status = res ? Status::OK : Status::STORAGE_ERROR;
+        return res;
+    }
+
+    virtual const String& GetErrorMessage() const
+    {
+        return m_storage->GetErrorMessage();
+    }
+
+private:
+    MetricsStorage(const MetricsStorage&);
+    MetricsStorage& operator=(const MetricsStorage&);
+
+    IMetricsListener *m_listener;
+    IStorage *m_storage;
+    const char *m_readName;
+    const char *m_writeName;
+};
+
+} // namespace
+
 
 /*
  * MPinSDK class
  */
 
 const char *MPinSDK::DEFAULT_RPS_PREFIX = "rps";
+const char *MPinSDK::WIRE_ENCODING_HEX = "hex";
+const char *MPinSDK::WIRE_ENCODING_BASE64 = "base64";
 const char *MPinSDK::CONFIG_BACKEND = "backend";
 // TODO: Remove this
 static const char *CONFIG_BACKEND_OLD = "RPA_server";
 const char *MPinSDK::CONFIG_RPS_PREFIX = "rps_prefix";
 
-MPinSDK::MPinSDK() : m_state(NOT_INITIALIZED), m_context(NULL), m_crypto(NULL)
+MPinSDK::MPinSDK() : m_state(NOT_INITIALIZED), m_context(NULL), m_metrics(NULL), m_crypto(NULL), m_secureStorage(NULL), m_nonSecureStorage(NULL)
 {
 }
 
@@ -552,8 +753,10 @@ Status MPinSDK::CheckIfBackendIsSet() const
     return Status(Status::FLOW_ERROR, "MPinSDK backend was not set");
 }
 
-MPinSDK::HttpResponse MPinSDK::MakeRequest(const String& url, HttpMethod method, const util::JsonObject& bodyJson, HttpResponse::DataType expectedResponseType) const
+MPinSDK::HttpResponse MPinSDK::MakeRequest(HttpResponse::Context context, const String& url, HttpMethod method, const util::JsonObject& bodyJson, HttpResponse::DataType expectedResponseType) const
 {
+    MetricsSpan span(m_metrics, IMetricsListener::HTTP_REQUEST, HttpResponse::ContextToString(context));
+
     IHttpRequest *r = m_context->CreateHttpRequest();
     String requestBody = bodyJson.ToString();
     HttpResponse response(url, requestBody);
@@ -573,16 +776,20 @@ MPinSDK::HttpResponse MPinSDK::MakeRequest(const String& url, HttpMethod method,
     if(method != IHttpRequest::GET)
     {
         r->SetContent(requestBody);
+        span.Get().bytesSent = requestBody.size();
     }
 
     if(!r->Execute(method, url))
     {
         response.SetNetworkError(r->GetExecuteErrorMessage());
+        span.Get().status = HttpResponse::NON_HTTP_ERROR;
         m_context->ReleaseHttpRequest(r);
         return response;
     }
 
     int httpStatus = r->GetHttpStatusCode();
+    span.Get().status = httpStatus;
+    span.Get().bytesReceived = r->GetResponseData().size();
     if(httpStatus != HttpResponse::HTTP_OK)
     {
         response.SetHttpError(httpStatus);
@@ -599,9 +806,74 @@ MPinSDK::HttpResponse MPinSDK::MakeRequest(const String& url, HttpMethod method,
     return response;
 }
 
-MPinSDK::HttpResponse MPinSDK::MakeGetRequest(const String& url, HttpResponse::DataType expectedResponseType) const
+MPinSDK::HttpResponse MPinSDK::MakeGetRequest(HttpResponse::Context context, const String& url, HttpResponse::DataType expectedResponseType) const
+{
+    return MakeRequest(context, url, IHttpRequest::GET, util::JsonObject(), expectedResponseType);
+}
+
+/*
+ * Binary data on the wire is hex encoded, unless the client settings offer "wireEncoding": "base64", and G1 points are
+ * sent uncompressed, unless they offer "compressedPoints": true. Requests that use base64 say so in their "encoding"
+ * field, and responses are decoded according to theirs, so either side may still be on hex.
+ */
+
+bool MPinSDK::UseBase64Encoding() const
+{
+    return String(m_clientSettings.GetStringParam("wireEncoding", WIRE_ENCODING_HEX)) == WIRE_ENCODING_BASE64;
+}
+
+String MPinSDK::EncodeWireData(const String& data) const
 {
-    return MakeRequest(url, IHttpRequest::GET, util::JsonObject(), expectedResponseType);
+    return UseBase64Encoding() ? util::Base64Encode(data) : util::HexEncode(data);
+}
+
+String MPinSDK::EncodeWirePoint(const String& point) const
+{
+    if(!m_clientSettings.GetBoolParam("compressedPoints", false) || point.empty())
+    {
+        return EncodeWireData(point);
+    }
+
+    char buf[2 * PFS + 1];
+    if(point.size() > sizeof(buf))
+    {
+        return EncodeWireData(point);
+    }
+
+    memcpy(buf, point.data(), point.size());
+    octet oct = { (int) point.size(), (int) sizeof(buf), buf };
+    if(MPIN_COMPRESS_G1(&oct) != 0)
+    {
+        return EncodeWireData(point);
+    }
+
+    return EncodeWireData(String(oct.val, oct.len));
+}
+
+void MPinSDK::SetWireEncoding(INOUT util::JsonObject& requestData) const
+{
+    if(UseBase64Encoding())
+    {
+        requestData["encoding"] = json::String(WIRE_ENCODING_BASE64);
+    }
+}
+
+String MPinSDK::DecodeWireData(const util::JsonObject& json, const char *name)
+{
+    if(String(json.GetStringParam("encoding", WIRE_ENCODING_HEX)) == WIRE_ENCODING_BASE64)
+    {
+        return util::Base64Decode(json.GetStringParam(name));
+    }
+    return util::HexDecode(json.GetStringParam(name));
+}
+
+bool MPinSDK::DecodeWireData(const util::JsonObject& json, const char *name, OUT util::SecureBuffer& decoded)
+{
+    if(String(json.GetStringParam("encoding", WIRE_ENCODING_HEX)) == WIRE_ENCODING_BASE64)
+    {
+        return util::Base64Decode(json.GetStringParam(name), decoded);
+    }
+    return util::HexDecode(json.GetStringParam(name), decoded);
 }
 
 class RewriteUrlVisitor : public json::Visitor
@@ -656,7 +928,7 @@ Status MPinSDK::RewriteRelativeUrls()
 
 Status MPinSDK::GetServiceDetails(const String& url, OUT ServiceDetails& serviceDetails)
 {
-    HttpResponse response = MakeGetRequest(String().Format("%s/service", String(url).TrimRight("/").c_str()));
+    HttpResponse response = MakeGetRequest(HttpResponse::GET_SERVICE_DETAILS, String().Format("%s/service", String(url).TrimRight("/").c_str()));
     if (response.GetStatus() != HttpResponse::HTTP_OK)
     {
         return response.TranslateToMPinStatus(HttpResponse::GET_SERVICE_DETAILS);
@@ -699,25 +971,49 @@ Status MPinSDK::Init(const StringMap& config, IContext* ctx, const StringMap& cu
     m_context = ctx;
     m_customHeaders.PutAll(customHeaders);
 
+    m_metrics = ctx->GetMetricsListener();
+    if(m_metrics != NULL)
+    {
+        m_secureStorage = new MetricsStorage(m_metrics, IStorage::SECURE, ctx->GetStorage(IStorage::SECURE));
+        m_nonSecureStorage = new MetricsStorage(m_metrics, IStorage::NONSECURE, ctx->GetStorage(IStorage::NONSECURE));
+    }
+    else
+    {
+        m_secureStorage = ctx->GetStorage(IStorage::SECURE);
+        m_nonSecureStorage = ctx->GetStorage(IStorage::NONSECURE);
+    }
+
     if(ctx->GetMPinCryptoType() == CRYPTO_NON_TEE)
     {
         MPinCryptoNonTee *nonteeCrypto = new MPinCryptoNonTee();
-        Status s = nonteeCrypto->Init(ctx->GetStorage(IStorage::SECURE));
+        Status s = nonteeCrypto->Init(m_secureStorage);
         if(s != Status::OK)
         {
             delete nonteeCrypto;
+            ReleaseStorage();
             return s;
         }
         m_crypto = nonteeCrypto;
     }
     else
     {
+        ReleaseStorage();
         return Status(Status::FLOW_ERROR, String("CRYPTO_TEE crypto type is currently not supported"));
     }
 
+    if(m_metrics != NULL)
+    {
+        m_crypto = new MetricsCrypto(m_metrics, m_crypto);
+    }
+
 	Status s = LoadUsersFromStorage();
     if(s != Status::OK)
     {
+        // Destroy() does nothing before the SDK is initialized
+        ClearUsers();
+        delete m_crypto;
+        m_crypto = NULL;
+        ReleaseStorage();
         return s;
     }
 
@@ -755,6 +1051,7 @@ void MPinSDK::Destroy()
 
     delete m_crypto;
     m_crypto = NULL;
+    ReleaseStorage();
     m_context = NULL;
 
     m_customHeaders.clear();
@@ -762,6 +1059,25 @@ void MPinSDK::Destroy()
     m_state = NOT_INITIALIZED;
 }
 
+void MPinSDK::ReleaseStorage()
+{
+    // The storage is owned by the context, unless wrapped for metrics
+    if(m_metrics != NULL)
+    {
+        delete m_secureStorage;
+        delete m_nonSecureStorage;
+    }
+
+    m_secureStorage = NULL;
+    m_nonSecureStorage = NULL;
+    m_metrics = NULL;
+}
+
+MPinSDK::IStorage * MPinSDK::GetStorage(IStorage::Type type) const
+{
+    return (type == IStorage::SECURE) ? m_secureStorage : m_nonSecureStorage;
+}
+
 void MPinSDK::ClearUsers()
 {
 	for (UsersMap::iterator i = m_users.begin(); i != m_users.end(); ++i)
@@ -774,7 +1090,7 @@ void MPinSDK::ClearUsers()
 
 Status MPinSDK::GetClientSettings(const String& backend, const String& rpsPrefix, OUT util::JsonObject *clientSettings) const
 {
-    HttpResponse response = MakeGetRequest(String().Format("%s/%s/clientSettings", backend.c_str(), String(rpsPrefix).Trim("/").c_str()));
+    HttpResponse response = MakeGetRequest(HttpResponse::GET_CLIENT_SETTINGS, String().Format("%s/%s/clientSettings", backend.c_str(), String(rpsPrefix).Trim("/").c_str()));
     if(response.GetStatus() != HttpResponse::HTTP_OK)
     {
         return response.TranslateToMPinStatus(HttpResponse::GET_CLIENT_SETTINGS);
@@ -902,7 +1218,7 @@ Status MPinSDK::RequestRegistration(UserPtr user, const String& activateCode, co
         url = m_clientSettings.GetStringParam("registerURL");
     }
 
-    HttpResponse response = MakeRequest(url, IHttpRequest::PUT, data);
+    HttpResponse response = MakeRequest(HttpResponse::REGISTER, url, IHttpRequest::PUT, data);
     if(response.GetStatus() != HttpResponse::HTTP_OK)
     {
         return response.TranslateToMPinStatus(HttpResponse::REGISTER);
@@ -978,24 +1294,35 @@ Status MPinSDK::ConfirmRegistration(INOUT UserPtr user, const String& pushMessag
         url += "&pmiToken=" + pushMessageIdentifier;
     }
 
-    HttpResponse response = MakeGetRequest(url);
+    HttpResponse response = MakeGetRequest(HttpResponse::GET_CLIENT_SECRET1, url);
     if(response.GetStatus() != HttpResponse::HTTP_OK)
     {
         return response.TranslateToMPinStatus(HttpResponse::GET_CLIENT_SECRET1);
     }
 
-    user->m_clientSecret1 = util::HexDecode(response.GetJsonData().GetStringParam("clientSecretShare"));
+    // Only the decoded shares are kept, in secure memory, so the responses carrying them are wiped
+    bool decoded = DecodeWireData(response.GetJsonData(), "clientSecretShare", user->m_clientSecret1);
+    String cs2Params = response.GetJsonData().GetStringParam("params");
+    response.Overwrite();
+    if(!decoded)
+    {
+        return Status(Status::RESPONSE_PARSE_ERROR, "Invalid clientSecretShare in the client secret share response");
+    }
 
     // Request the client secret share from CertiVox's D-TA.
-    String cs2Params = response.GetJsonData().GetStringParam("params");
     url.Format("%sclientSecret?%s", m_clientSettings.GetStringParam("certivoxURL"), cs2Params.c_str());
-    response = MakeGetRequest(url);
-    if(response.GetStatus() != HttpResponse::HTTP_OK)
+    HttpResponse cs2Response = MakeGetRequest(HttpResponse::GET_CLIENT_SECRET2, url);
+    if(cs2Response.GetStatus() != HttpResponse::HTTP_OK)
     {
-        return response.TranslateToMPinStatus(HttpResponse::GET_CLIENT_SECRET2);
+        return cs2Response.TranslateToMPinStatus(HttpResponse::GET_CLIENT_SECRET2);
     }
 
-    user->m_clientSecret2 = util::HexDecode(response.GetJsonData().GetStringParam("clientSecret"));
+    decoded = DecodeWireData(cs2Response.GetJsonData(), "clientSecret", user->m_clientSecret2);
+    cs2Response.Overwrite();
+    if(!decoded)
+    {
+        return Status(Status::RESPONSE_PARSE_ERROR, "Invalid clientSecret in the client secret response");
+    }
 
     return Status::OK;
 }
@@ -1023,7 +1350,7 @@ Status MPinSDK::FinishRegistration(INOUT UserPtr user, const String& pin)
     }
 
     // In addition, client secret shares must be retrieved
-    if(user->m_clientSecret1.empty() || user->m_clientSecret2.empty())
+    if(user->m_clientSecret1.Empty() || user->m_clientSecret2.Empty())
     {
         return Status(Status::FLOW_ERROR, String().Format("Cannot finish user '%s' registration: User identity not verified", user->GetId().c_str()));
     }
@@ -1034,7 +1361,7 @@ Status MPinSDK::FinishRegistration(INOUT UserPtr user, const String& pin)
         return s;
     }
 
-    std::vector<String> clientSecretShares;
+    std::vector<util::SecureBuffer> clientSecretShares;
     clientSecretShares.push_back(user->m_clientSecret1);
     clientSecretShares.push_back(user->m_clientSecret2);
 
@@ -1047,6 +1374,10 @@ Status MPinSDK::FinishRegistration(INOUT UserPtr user, const String& pin)
 
     m_crypto->CloseSession();
 
+    // The shares are combined into the stored token and are not needed anymore
+    user->m_clientSecret1.Clear();
+    user->m_clientSecret2.Clear();
+
     user->SetRegistered();
     s = WriteUsersToStorage();
     if(s != Status::OK)
@@ -1079,7 +1410,7 @@ Status MPinSDK::StartAuthentication(INOUT UserPtr user, const String& accessCode
         data["status"] = json::String("user");
         data["wid"] = json::String(accessCode);
         data["userId"] = json::String(user->GetId());
-        MakeRequest(codeStatusURL, IHttpRequest::POST, data);
+        MakeRequest(HttpResponse::SEND_CODE_STATUS, codeStatusURL, IHttpRequest::POST, data);
     }
 
     bool useTimePermits = m_clientSettings.GetBoolParam("usePermits", true);
@@ -1091,13 +1422,13 @@ Status MPinSDK::StartAuthentication(INOUT UserPtr user, const String& accessCode
     // Request a time permit share from the customer's D-TA and a signed request for a time permit share from CertiVox's D-TA.
     String mpinIdHex = user->GetMPinIdHex();
     String url = String().Format("%s/%s", m_clientSettings.GetStringParam("timePermitsURL"), mpinIdHex.c_str());
-    HttpResponse response = MakeGetRequest(url);
+    HttpResponse response = MakeGetRequest(HttpResponse::GET_TIME_PERMIT1, url);
     if(response.GetStatus() != HttpResponse::HTTP_OK)
     {
         return response.TranslateToMPinStatus(HttpResponse::GET_TIME_PERMIT1);
     }
 
-    user->m_timePermitShare1 = util::HexDecode(response.GetJsonData().GetStringParam("timePermit"));
+    user->m_timePermitShare1 = DecodeWireData(response.GetJsonData(), "timePermit");
 
     // Request time permit share from CertiVox's D-TA (Searches first in user cache, than in S3 cache)
     s = GetCertivoxTimePermitShare(user, response.GetJsonData(), user->m_timePermitShare2);
@@ -1223,19 +1554,20 @@ Status MPinSDK::FinishAuthenticationImpl(INOUT UserPtr user, const String& pin,
     util::JsonObject requestData;
     requestData["pass"] = json::Number(1);
     requestData["mpin_id"] = json::String(mpinIdHex);
-    requestData["UT"] = json::String(util::HexEncode(ut));
-    requestData["U"] = json::String(util::HexEncode(u));
+    requestData["UT"] = json::String(EncodeWirePoint(ut));
+    requestData["U"] = json::String(EncodeWirePoint(u));
+    SetWireEncoding(requestData);
 
     String mpinAuthServerURL = m_clientSettings.GetStringParam("mpinAuthServerURL");
     String url = String().Format("%s/pass1", mpinAuthServerURL.c_str());
-    HttpResponse response = MakeRequest(url, IHttpRequest::POST, requestData);
+    HttpResponse response = MakeRequest(HttpResponse::AUTHENTICATE_PASS1, url, IHttpRequest::POST, requestData);
     if(response.GetStatus() != HttpResponse::HTTP_OK)
     {
         m_crypto->CloseSession();
         return response.TranslateToMPinStatus(HttpResponse::AUTHENTICATE_PASS1);
     }
 
-    String y = util::HexDecode(response.GetJsonData().GetStringParam("y"));
+    String y = DecodeWireData(response.GetJsonData(), "y");
 
     // Authentication pass 2
     String v;
@@ -1250,11 +1582,12 @@ Status MPinSDK::FinishAuthenticationImpl(INOUT UserPtr user, const String& pin,
     requestData["pass"] = json::Number(2);
     requestData["OTP"] = json::Boolean(otp != NULL ? true : false);
     requestData["WID"] = json::String(accessNumber.empty() ? "0" : accessNumber);
-    requestData["V"] = json::String(util::HexEncode(v));
+    requestData["V"] = json::String(EncodeWirePoint(v));
     requestData["mpin_id"] = json::String(mpinIdHex);
+    SetWireEncoding(requestData);
 
     url.Format("%s/pass2", mpinAuthServerURL.c_str());
-    response = MakeRequest(url, IHttpRequest::POST, requestData);
+    response = MakeRequest(HttpResponse::AUTHENTICATE_PASS2, url, IHttpRequest::POST, requestData);
     if(response.GetStatus() != HttpResponse::HTTP_OK)
     {
         m_crypto->CloseSession();
@@ -1271,7 +1604,7 @@ Status MPinSDK::FinishAuthenticationImpl(INOUT UserPtr user, const String& pin,
     url = m_clientSettings.GetStringParam(accessNumber.empty() ? "authenticateURL" : "mobileAuthenticateURL");
     requestData.Clear();
     requestData["mpinResponse"] = response.GetJsonData();
-    response = MakeRequest(url, IHttpRequest::POST, requestData);
+    response = MakeRequest(HttpResponse::AUTHENTICATE_RPA, url, IHttpRequest::POST, requestData);
     if(response.GetStatus() != HttpResponse::HTTP_OK)
     {
         m_crypto->CloseSession();
@@ -1314,7 +1647,7 @@ Status MPinSDK::GetCertivoxTimePermitShare(INOUT UserPtr user, const util::JsonO
 
     // Make GET request to s3Url/app_id/date/storageId
     String url = String().Format("%s/%s/%d/%s", s3Url.c_str(), appId.c_str(), date, storageId.c_str());
-    HttpResponse response = MakeGetRequest(url, HttpResponse::RAW);
+    HttpResponse response = MakeGetRequest(HttpResponse::GET_STORED_TIME_PERMIT, url, HttpResponse::RAW);
     if(response.GetStatus() == HttpResponse::HTTP_OK)
     {
         // OK - add time permit to user cache
@@ -1330,13 +1663,13 @@ Status MPinSDK::GetCertivoxTimePermitShare(INOUT UserPtr user, const util::JsonO
     String t2Params = String().Format("hash_mpin_id=%s&app_id=%s&mobile=1&signature=%s",
         storageId.c_str(), appId.c_str(), signature.c_str());
     url.Format("%stimePermit?%s", m_clientSettings.GetStringParam("certivoxURL"), t2Params.c_str());
-    response = MakeGetRequest(url);
+    response = MakeGetRequest(HttpResponse::GET_TIME_PERMIT2, url);
     if(response.GetStatus() != HttpResponse::HTTP_OK)
     {
         return response.TranslateToMPinStatus(HttpResponse::GET_TIME_PERMIT2);
     }
 
-    resultTimePermit = util::HexDecode(response.GetJsonData().GetStringParam("timePermit"));
+    resultTimePermit = DecodeWireData(response.GetJsonData(), "timePermit");
     // OK - add time permit to user cache
     user->CacheTimePermit(resultTimePermit, date);
     WriteUsersToStorage();
@@ -1456,7 +1789,7 @@ Status MPinSDK::GetSessionDetails(const String& accessCode, OUT SessionDetails&
     data["status"] = json::String("wid");
     data["wid"] = json::String(accessCode);
 
-    HttpResponse response = MakeRequest(codeStatusUrl, IHttpRequest::POST, data);
+    HttpResponse response = MakeRequest(HttpResponse::GET_SESSION_DETAILS, codeStatusUrl, IHttpRequest::POST, data);
     if(response.GetStatus() != HttpResponse::HTTP_OK)
     {
         return response.TranslateToMPinStatus(HttpResponse::GET_SESSION_DETAILS);
@@ -1586,7 +1919,7 @@ Status MPinSDK::ListBackends(OUT std::vector<String>& backends) const
     backends.clear();
 
     String data;
-    m_context->GetStorage(IStorage::NONSECURE)->GetData(data);
+    GetStorage(IStorage::NONSECURE)->GetData(data);
     data.Trim();
 	if(data.empty())
     {
@@ -1667,7 +2000,7 @@ Status MPinSDK::WriteUsersToStorage() const
 
 		std::stringstream strOut;
 		json::Writer::Write(rootObject, strOut);
-		m_context->GetStorage(IStorage::NONSECURE)->SetData(strOut.str());
+		GetStorage(IStorage::NONSECURE)->SetData(strOut.str());
 	}
     catch(const json::Exception& e)
     {
@@ -1682,7 +2015,7 @@ Status MPinSDK::LoadUsersFromStorage()
     ClearUsers();
 
 	String data;
-	m_context->GetStorage(IStorage::NONSECURE)->GetData(data);
+	GetStorage(IStorage::NONSECURE)->GetData(data);
     data.Trim();
 	if(data.empty())
     {
@@ -1769,7 +2102,7 @@ bool MPinSDK::Logout(UserPtr user)
 	}
     
     String url = String().Format("%s%s", m_RPAServer.c_str(), i->second.logoutURL.c_str());
-	HttpResponse response = MakeRequest(url, IHttpRequest::POST, logoutData);
+	HttpResponse response = MakeRequest(HttpResponse::LOGOUT, url, IHttpRequest::POST, logoutData);
     
     if(response.GetStatus() != HttpResponse::HTTP_OK)
     {
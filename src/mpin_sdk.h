@@ -97,6 +97,39 @@ public:
         virtual const String& GetErrorMessage() const = 0;
     };
 
+    // Receives a begin and an end event around every HTTP request, crypto call and storage access the SDK makes.
+    // Events are delivered on the thread that called into the SDK, in nesting order. See mpin_metrics.h for
+    // ready-made listeners.
+    class IMetricsListener
+    {
+    public:
+        enum SpanType
+        {
+            HTTP_REQUEST,
+            CRYPTO_CALL,
+            STORAGE_ACCESS,
+        };
+
+        class Span
+        {
+        public:
+            Span(SpanType type, const char *name) : type(type), name(name), bytesSent(0), bytesReceived(0), status(0) {}
+
+            SpanType type;
+            // The HTTP request context (e.g. "AUTHENTICATE_PASS1"), the crypto call or the storage operation
+            const char *name;
+            // Known only at the end of the span
+            size_t bytesSent;
+            size_t bytesReceived;
+            // The HTTP status code (-1 for network errors), or a Status::Code for crypto calls and storage access
+            int status;
+        };
+
+        virtual ~IMetricsListener() {}
+        virtual void OnSpanBegin(const Span& span) = 0;
+        virtual void OnSpanEnd(const Span& span) = 0;
+    };
+
     class IContext
     {
     public:
@@ -105,6 +138,8 @@ public:
         virtual void ReleaseHttpRequest(IN IHttpRequest *request) const = 0;
         virtual IStorage * GetStorage(IStorage::Type type) const = 0;
         virtual CryptoType GetMPinCryptoType() const = 0;
+        // Optional, the SDK is not instrumented at all without a listener
+        virtual IMetricsListener * GetMetricsListener() const { return NULL; }
     };
 
     class Status
@@ -210,8 +245,8 @@ public:
         TimePermitCache m_timePermitCache;
         String m_timePermitShare1;
         String m_timePermitShare2;
-        String m_clientSecret1;
-        String m_clientSecret2;
+        util::SecureBuffer m_clientSecret1;
+        util::SecureBuffer m_clientSecret2;
     };
 
 	class OTP
@@ -317,6 +352,9 @@ private:
             AUTHENTICATE_PASS2,
             AUTHENTICATE_RPA,
             GET_SESSION_DETAILS,
+            GET_STORED_TIME_PERMIT,
+            SEND_CODE_STATUS,
+            LOGOUT,
         };
 
         enum DataType
@@ -333,10 +371,13 @@ private:
         const util::JsonObject& GetJsonData() const;
         const String& GetRawData() const;
         const StringMap& GetHeaders() const;
+        // Wipes the body of responses that carry secrets, as it is not wiped on destruction
+        void Overwrite();
         void SetNetworkError(const String& error);
         void SetHttpError(int httpStatus);
         void SetResponseJsonParseError(const String& jsonParseError);
         Status TranslateToMPinStatus(Context context);
+        static const char * ContextToString(Context context);
 
     private:
         DataType DetermineDataType(const String& contentTypeStr) const;
@@ -377,12 +418,18 @@ private:
     bool IsBackendSet() const;
     Status CheckIfIsInitialized() const;
     Status CheckIfBackendIsSet() const;
-    HttpResponse MakeRequest(const String& url, IHttpRequest::Method method, const util::JsonObject& bodyJson, HttpResponse::DataType expectedResponseType = HttpResponse::JSON) const;
-    HttpResponse MakeGetRequest(const String& url, HttpResponse::DataType expectedResponseType = HttpResponse::JSON) const;
+    HttpResponse MakeRequest(HttpResponse::Context context, const String& url, IHttpRequest::Method method, const util::JsonObject& bodyJson, HttpResponse::DataType expectedResponseType = HttpResponse::JSON) const;
+    HttpResponse MakeGetRequest(HttpResponse::Context context, const String& url, HttpResponse::DataType expectedResponseType = HttpResponse::JSON) const;
     Status RewriteRelativeUrls();
     Status GetClientSettings(const String& backend, const String& rpsPrefix, OUT util::JsonObject *clientSettings) const;
     Status RequestRegistration(INOUT UserPtr user, const String& activateCode, const String& userData);
     Status FinishAuthenticationImpl(INOUT UserPtr user, const String& pin, const String& accessNumber, OUT String *otp, OUT util::JsonObject& authResultData);
+    bool UseBase64Encoding() const;
+    String EncodeWireData(const String& data) const;
+    String EncodeWirePoint(const String& point) const;
+    void SetWireEncoding(INOUT util::JsonObject& requestData) const;
+    static String DecodeWireData(const util::JsonObject& json, const char *name);
+    static bool DecodeWireData(const util::JsonObject& json, const char *name, OUT util::SecureBuffer& decoded);
     Status GetCertivoxTimePermitShare(INOUT UserPtr user, const util::JsonObject& cutomerTimePermitData, OUT String& resultTimePermit);
     bool ValidateAccessNumber(const String& accessNumber);
     bool ValidateAccessNumberChecksum(const String& accessNumber);
@@ -390,14 +437,21 @@ private:
     String MakeBackendKey(const String& backendServer) const;
 	Status WriteUsersToStorage() const;
 	Status LoadUsersFromStorage();
+    IStorage * GetStorage(IStorage::Type type) const;
+    void ReleaseStorage();
 
     static const char *DEFAULT_RPS_PREFIX;
+    static const char *WIRE_ENCODING_HEX;
+    static const char *WIRE_ENCODING_BASE64;
     static const int AN_WITH_CHECKSUM_LEN = 7;
 
 private:
     State m_state;
     IContext *m_context;
+    IMetricsListener *m_metrics;
     IMPinCrypto *m_crypto;
+    IStorage *m_secureStorage;
+    IStorage *m_nonSecureStorage;
     String m_RPAServer;
     util::JsonObject m_clientSettings;
     UsersMap m_users;
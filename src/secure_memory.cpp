@@ -0,0 +1,401 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+/*
+ * Storage for secret data (tokens, client secrets, ephemeral keys)
+ */
+
+#include "secure_memory.h"
+#include "CvMutex.h"
+
+#include <string.h>
+#include <new>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+
+
+namespace util
+{
+
+void SecureZero(void *ptr, size_t len)
+{
+    if(ptr == NULL || len == 0)
+    {
+        return;
+    }
+#if defined(_WIN32)
+    SecureZeroMemory(ptr, len);
+#else
+    volatile unsigned char *p = (volatile unsigned char *) ptr;
+    while(len--)
+    {
+        *p++ = 0;
+    }
+#endif
+}
+
+
+/*
+ * SecureArena class
+ *
+ * Small blocks are served from per size class free lists, carved out of locked slabs which are kept for the
+ * lifetime of the process. Blocks larger than the biggest size class get locked pages of their own.
+ */
+
+namespace
+{
+
+class SecureArena
+{
+public:
+    static SecureArena& Instance();
+
+    void * Allocate(size_t size, size_t& capacity);
+    void Free(void *ptr, size_t capacity);
+
+private:
+    SecureArena();
+    ~SecureArena() {}
+    SecureArena(const SecureArena&);
+    SecureArena& operator = (const SecureArena&);
+
+    static int GetSizeClass(size_t size);
+    size_t RoundToPages(size_t size) const;
+    void * MapPages(size_t size);
+    void UnmapPages(void *ptr, size_t size);
+    bool AddSlab(int sizeClass);
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    };
+
+    static const size_t MIN_BLOCK_SIZE = 16;
+    static const int NUM_SIZE_CLASSES = 8;  // 16 .. 2048 bytes
+    static const size_t SLAB_SIZE = 16 * 1024;
+
+    FreeBlock *m_freeLists[NUM_SIZE_CLASSES];
+    size_t m_pageSize;
+    CvShared::CvMutex m_mutex;
+};
+
+SecureArena& SecureArena::Instance()
+{
+    // Never destroyed, so buffers in static objects can still be released during program exit
+    static SecureArena *instance = new SecureArena();
+    return *instance;
+}
+
+SecureArena::SecureArena() : m_pageSize(4096)
+{
+    for(int i = 0; i < NUM_SIZE_CLASSES; ++i)
+    {
+        m_freeLists[i] = NULL;
+    }
+
+#if defined(_WIN32)
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    m_pageSize = systemInfo.dwPageSize;
+#else
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if(pageSize > 0)
+    {
+        m_pageSize = (size_t) pageSize;
+    }
+#endif
+
+    m_mutex.Create();
+}
+
+int SecureArena::GetSizeClass(size_t size)
+{
+    int sizeClass = 0;
+    size_t blockSize = MIN_BLOCK_SIZE;
+    while(blockSize < size)
+    {
+        blockSize <<= 1;
+        ++sizeClass;
+    }
+    return sizeClass;
+}
+
+size_t SecureArena::RoundToPages(size_t size) const
+{
+    return ((size + m_pageSize - 1) / m_pageSize) * m_pageSize;
+}
+
+void * SecureArena::MapPages(size_t size)
+{
+    // Locking may fail when the process is over its locked memory limit. The pages are still used then -
+    // they are zeroized on release anyway, they are just not protected from being swapped out.
+#if defined(_WIN32)
+    void *ptr = VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if(ptr == NULL)
+    {
+        return NULL;
+    }
+    VirtualLock(ptr, size);
+#else
+    void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(ptr == MAP_FAILED)
+    {
+        return NULL;
+    }
+    mlock(ptr, size);
+#ifdef MADV_DONTDUMP
+    madvise(ptr, size, MADV_DONTDUMP);
+#endif
+#endif
+    return ptr;
+}
+
+void SecureArena::UnmapPages(void *ptr, size_t size)
+{
+#if defined(_WIN32)
+    VirtualUnlock(ptr, size);
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munlock(ptr, size);
+    munmap(ptr, size);
+#endif
+}
+
+bool SecureArena::AddSlab(int sizeClass)
+{
+    char *slab = (char *) MapPages(SLAB_SIZE);
+    if(slab == NULL)
+    {
+        return false;
+    }
+
+    size_t blockSize = MIN_BLOCK_SIZE << sizeClass;
+    for(size_t offset = 0; offset + blockSize <= SLAB_SIZE; offset += blockSize)
+    {
+        FreeBlock *block = (FreeBlock *) (slab + offset);
+        block->next = m_freeLists[sizeClass];
+        m_freeLists[sizeClass] = block;
+    }
+
+    return true;
+}
+
+void * SecureArena::Allocate(size_t size, size_t& capacity)
+{
+    capacity = 0;
+    if(size == 0)
+    {
+        return NULL;
+    }
+
+    int sizeClass = GetSizeClass(size);
+    if(sizeClass >= NUM_SIZE_CLASSES)
+    {
+        size_t pagesSize = RoundToPages(size);
+        void *ptr = MapPages(pagesSize);
+        if(ptr != NULL)
+        {
+            capacity = pagesSize;
+        }
+        return ptr;
+    }
+
+    CvShared::CvMutexLock lock(m_mutex);
+
+    if(m_freeLists[sizeClass] == NULL && !AddSlab(sizeClass))
+    {
+        return NULL;
+    }
+
+    // Free blocks are zeroized on release, except for the free list link
+    FreeBlock *block = m_freeLists[sizeClass];
+    m_freeLists[sizeClass] = block->next;
+    block->next = NULL;
+
+    capacity = MIN_BLOCK_SIZE << sizeClass;
+    return block;
+}
+
+void SecureArena::Free(void *ptr, size_t capacity)
+{
+    if(ptr == NULL)
+    {
+        return;
+    }
+
+    SecureZero(ptr, capacity);
+
+    int sizeClass = GetSizeClass(capacity);
+    if(sizeClass >= NUM_SIZE_CLASSES)
+    {
+        UnmapPages(ptr, capacity);
+        return;
+    }
+
+    CvShared::CvMutexLock lock(m_mutex);
+
+    FreeBlock *block = (FreeBlock *) ptr;
+    block->next = m_freeLists[sizeClass];
+    m_freeLists[sizeClass] = block;
+}
+
+}
+
+
+/*
+ * SecureBuffer class
+ */
+
+SecureBuffer::SecureBuffer() : m_data(NULL), m_size(0), m_capacity(0)
+{
+}
+
+SecureBuffer::SecureBuffer(size_t size) : m_data(NULL), m_size(0), m_capacity(0)
+{
+    Resize(size);
+}
+
+SecureBuffer::SecureBuffer(const char *data, size_t size) : m_data(NULL), m_size(0), m_capacity(0)
+{
+    Assign(data, size);
+}
+
+SecureBuffer::SecureBuffer(const SecureBuffer& other) : m_data(NULL), m_size(0), m_capacity(0)
+{
+    Assign(other.m_data, other.m_size);
+}
+
+SecureBuffer::~SecureBuffer()
+{
+    Clear();
+}
+
+SecureBuffer& SecureBuffer::operator = (const SecureBuffer& other)
+{
+    if(this != &other)
+    {
+        Assign(other.m_data, other.m_size);
+    }
+    return *this;
+}
+
+void SecureBuffer::Assign(const char *data, size_t size)
+{
+    if(m_capacity < size)
+    {
+        Clear();
+        Reserve(size);
+    }
+    else if(size < m_size)
+    {
+        SecureZero(m_data + size, m_size - size);
+    }
+
+    if(size > 0)
+    {
+        memmove(m_data, data, size);
+    }
+    m_size = size;
+}
+
+void SecureBuffer::Assign(const std::string& str)
+{
+    Assign(str.data(), str.size());
+}
+
+void SecureBuffer::Resize(size_t size)
+{
+    if(size > m_capacity)
+    {
+        Reserve(size);
+    }
+    else if(size < m_size)
+    {
+        SecureZero(m_data + size, m_size - size);
+    }
+    m_size = size;
+}
+
+void SecureBuffer::Clear()
+{
+    SecureArena::Instance().Free(m_data, m_capacity);
+    m_data = NULL;
+    m_size = 0;
+    m_capacity = 0;
+}
+
+char * SecureBuffer::Data()
+{
+    return m_data;
+}
+
+const char * SecureBuffer::Data() const
+{
+    return m_data;
+}
+
+size_t SecureBuffer::Size() const
+{
+    return m_size;
+}
+
+size_t SecureBuffer::Capacity() const
+{
+    return m_capacity;
+}
+
+bool SecureBuffer::Empty() const
+{
+    return m_size == 0;
+}
+
+std::string SecureBuffer::ToString() const
+{
+    return std::string(m_data != NULL ? m_data : "", m_size);
+}
+
+void SecureBuffer::Reserve(size_t capacity)
+{
+    size_t newCapacity = 0;
+    char *newData = (char *) SecureArena::Instance().Allocate(capacity, newCapacity);
+    if(newData == NULL)
+    {
+        throw std::bad_alloc();
+    }
+
+    if(m_size > 0)
+    {
+        memcpy(newData, m_data, m_size);
+    }
+
+    SecureArena::Instance().Free(m_data, m_capacity);
+    m_data = newData;
+    m_capacity = newCapacity;
+}
+
+}
@@ -0,0 +1,81 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+/*
+ * Storage for secret data (tokens, client secrets, ephemeral keys)
+ *
+ * SecureBuffer memory comes from a pooled arena of pages that are locked in RAM (where the OS permits it) and
+ * excluded from core dumps. Every buffer is zeroized when it is released or reallocated, so only the data that
+ * really is secret pays for wiping. Ordinary strings should stay plain util::String.
+ */
+
+#ifndef _MPIN_SDK_SECURE_MEMORY_H_
+#define _MPIN_SDK_SECURE_MEMORY_H_
+
+#include <stddef.h>
+#include <string>
+
+
+namespace util
+{
+
+/*
+ * Zeroizes memory in a way that can not be optimized away by the compiler
+ */
+void SecureZero(void *ptr, size_t len);
+
+class SecureBuffer
+{
+public:
+    SecureBuffer();
+    explicit SecureBuffer(size_t size);
+    SecureBuffer(const char *data, size_t size);
+    SecureBuffer(const SecureBuffer& other);
+    ~SecureBuffer();
+    SecureBuffer& operator = (const SecureBuffer& other);
+
+    void Assign(const char *data, size_t size);
+    void Assign(const std::string& str);
+    // Changes the size, keeping the existing content. Added bytes are zero.
+    void Resize(size_t size);
+    // Zeroizes the content and returns the memory to the arena
+    void Clear();
+
+    char * Data();
+    const char * Data() const;
+    size_t Size() const;
+    size_t Capacity() const;
+    bool Empty() const;
+
+    // Makes a plain (not protected) copy of the data. Use only where the data must leave the SDK.
+    std::string ToString() const;
+
+private:
+    void Reserve(size_t capacity);
+
+private:
+    char *m_data;
+    size_t m_size;
+    size_t m_capacity;
+};
+
+}
+
+
+#endif // _MPIN_SDK_SECURE_MEMORY_H_
@@ -57,11 +57,6 @@ int String::GetHash() const
     return hash;
 }
 
-String::~String()
-{
-    Overwrite();
-}
-
 void OverwriteString(std::string& str, char c)
 {
     for(size_t i = 0; i < str.length(); ++i)
@@ -90,11 +85,6 @@ JsonObject& JsonObject::operator =(const json::Object& other)
     m_parseError = "";
     return *this;
 }
-    
-JsonObject::~JsonObject()
-{
-    OverwriteJsonValues(*this);
-}
 
 std::string JsonObject::ToString() const
 {
@@ -130,9 +120,15 @@ bool JsonObject::Parse(const char* str)
 
 const char * JsonObject::GetStringParam(const char *name, const char *defaultValue) const
 {
+    const json::UnknownElement *param = FindParam(name);
+    if(param == NULL)
+    {
+        return defaultValue;
+    }
+
     try
     {
-        return ((const json::String&) (*this)[name]).Value().c_str();
+        return ((const json::String&) *param).Value().c_str();
     }
     catch(const json::Exception&)
     {
@@ -142,9 +138,15 @@ const char * JsonObject::GetStringParam(const char *name, const char *defaultVal
 
 int JsonObject::GetIntParam(const char *name, int defaultValue) const
 {
+    const json::UnknownElement *param = FindParam(name);
+    if(param == NULL)
+    {
+        return defaultValue;
+    }
+
     try
     {
-        return (int) ((const json::Number&) (*this)[name]).Value();
+        return (int) ((const json::Number&) *param).Value();
     }
     catch(const json::Exception&)
     {
@@ -154,9 +156,15 @@ int JsonObject::GetIntParam(const char *name, int defaultValue) const
     
 int64_t JsonObject::GetInt64Param(const char *name, int64_t defaultValue) const
 {
+    const json::UnknownElement *param = FindParam(name);
+    if(param == NULL)
+    {
+        return defaultValue;
+    }
+
     try
     {
-        return (int64_t)((const json::Number&) (*this)[name]).Value();
+        return (int64_t)((const json::Number&) *param).Value();
     }
     catch(const json::Exception&)
     {
@@ -166,9 +174,15 @@ int64_t JsonObject::GetInt64Param(const char *name, int64_t defaultValue) const
 
 bool JsonObject::GetBoolParam(const char *name, bool defaultValue) const
 {
+    const json::UnknownElement *param = FindParam(name);
+    if(param == NULL)
+    {
+        return defaultValue;
+    }
+
     try
     {
-        return ((const json::Boolean&) (*this)[name]).Value();
+        return ((const json::Boolean&) *param).Value();
     }
     catch(const json::Exception&)
     {
@@ -176,6 +190,20 @@ bool JsonObject::GetBoolParam(const char *name, bool defaultValue) const
     }
 }
 
+const json::UnknownElement * JsonObject::FindParam(const char *name) const
+{
+    // Compared in place - looking the name up as a std::string would allocate for the longer names, and a missing
+    // param would throw
+    for(json::Object::const_iterator i = Begin(); i != End(); ++i)
+    {
+        if(strcmp(i->name.c_str(), name) == 0)
+        {
+            return &i->element;
+        }
+    }
+    return NULL;
+}
+
 std::string JsonObject::GetParseError() const
 {
     return m_parseError;
@@ -306,6 +334,23 @@ const char * StringMap::Get(const String& key) const
  * Hex encoding/decoding
  */
 
+static int HexNibble(char c)
+{
+    if(c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if(c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 0xA;
+    }
+    if(c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 0xA;
+    }
+    return -1;
+}
+
 std::string HexEncode(const char* str, size_t len)
 {
     std::string hexEncodedStr;
@@ -324,4 +369,129 @@ std::string HexDecode(const std::string& str)
     CvShared::CvHex::Decode(str, hexDecodedStr);
     return hexDecodedStr;
 }
+
+bool HexDecode(const std::string& str, SecureBuffer& decoded)
+{
+    // Decode directly into the secure buffer, so no plain copy of the data is left behind
+    decoded.Resize(str.length() / 2);
+    if(HexDecode(str, decoded.Data(), decoded.Size()) == 0 && !str.empty())
+    {
+        decoded.Resize(0);
+        return false;
+    }
+    return true;
+}
+
+size_t HexDecode(const std::string& str, char *buf, size_t maxLen)
+{
+    size_t len = str.length() / 2;
+    if(str.length() % 2 != 0 || len > maxLen)
+    {
+        return 0;
+    }
+
+    for(size_t i = 0; i < len; ++i)
+    {
+        int high = HexNibble(str[2 * i]);
+        int low = HexNibble(str[2 * i + 1]);
+        if(high < 0 || low < 0)
+        {
+            // Do not leave half of the data behind
+            memset(buf, 0, i);
+            return 0;
+        }
+        buf[i] = (char) ((high << 4) | low);
+    }
+
+    return len;
+}
+
+
+/*
+ * Base64 encoding/decoding
+ */
+
+static int Base64Sextet(char c)
+{
+    if(c >= 'A' && c <= 'Z')
+    {
+        return c - 'A';
+    }
+    if(c >= 'a' && c <= 'z')
+    {
+        return c - 'a' + 26;
+    }
+    if(c >= '0' && c <= '9')
+    {
+        return c - '0' + 52;
+    }
+    if(c == '+')
+    {
+        return 62;
+    }
+    if(c == '/')
+    {
+        return 63;
+    }
+    return -1;
+}
+
+std::string Base64Encode(const char *str, size_t len)
+{
+    std::string base64EncodedStr;
+    CvShared::CvBase64::Encode((const unsigned char *) str, (int) len, base64EncodedStr);
+    return base64EncodedStr;
+}
+
+std::string Base64Encode(const std::string& str)
+{
+    return Base64Encode(str.c_str(), str.size());
+}
+
+std::string Base64Decode(const std::string& str)
+{
+    std::string base64DecodedStr;
+    CvShared::CvBase64::Decode(str, base64DecodedStr);
+    return base64DecodedStr;
+}
+
+bool Base64Decode(const std::string& str, SecureBuffer& decoded)
+{
+    // Decode directly into the secure buffer, so no plain copy of the data is left behind
+    decoded.Resize(str.length() / 4 * 3 + 3);
+    decoded.Resize(Base64Decode(str, decoded.Data(), decoded.Size()));
+    return !decoded.Empty() || str.empty();
+}
+
+size_t Base64Decode(const std::string& str, char *buf, size_t maxLen)
+{
+    size_t len = 0;
+    unsigned int bits = 0;
+    int numBits = 0;
+
+    for(size_t i = 0; i < str.length() && str[i] != '='; ++i)
+    {
+        int sextet = Base64Sextet(str[i]);
+        if(sextet < 0)
+        {
+            memset(buf, 0, len);
+            return 0;
+        }
+
+        bits = (bits << 6) | (unsigned int) sextet;
+        numBits += 6;
+        if(numBits >= 8)
+        {
+            numBits -= 8;
+            if(len == maxLen)
+            {
+                memset(buf, 0, len);
+                return 0;
+            }
+            buf[len++] = (char) ((bits >> numBits) & 0xFF);
+        }
+    }
+
+    return len;
+}
 }
@@ -29,6 +29,7 @@ under the License.
 #include "json/elements.h"
 #include "json/writer.h"
 #include "CvString.h"
+#include "secure_memory.h"
 
 
 namespace util
@@ -44,7 +45,6 @@ public:
     String(const std::string& str, size_t pos, size_t size = npos) : CvString(str, pos, size) {}
     String(const char *str, size_t size) : CvString(str, size) {}
     String(size_t size, char c) : CvString(size, c) {}
-    ~String();
     String& Trim(const std::string& chars = " \t\f\v\n\r");
     void Overwrite(char c = ' ');
     int GetHash() const;
@@ -59,7 +59,6 @@ public:
     JsonObject();
     JsonObject(const json::Object& other);
     JsonObject& operator = (const json::Object& other);
-    ~JsonObject();
     std::string ToString() const;
     bool Parse(const char *str);
     const char * GetStringParam(const char *name, const char *defaultValue = "") const;
@@ -70,6 +69,7 @@ public:
     
 private:
     void Copy(const json::Object& other);
+    const json::UnknownElement * FindParam(const char *name) const;
 
 private:
     String m_parseError;
@@ -94,6 +94,14 @@ public:
 std::string HexEncode(const char *str, size_t len);
 std::string HexEncode(const std::string& str);
 std::string HexDecode(const std::string& str);
+// The decoders into buffers fail - return false or 0 - on invalid characters, odd hex length or data that does not fit
+bool HexDecode(const std::string& str, SecureBuffer& decoded);
+size_t HexDecode(const std::string& str, char *buf, size_t maxLen);
+std::string Base64Encode(const char *str, size_t len);
+std::string Base64Encode(const std::string& str);
+std::string Base64Decode(const std::string& str);
+bool Base64Decode(const std::string& str, SecureBuffer& decoded);
+size_t Base64Decode(const std::string& str, char *buf, size_t maxLen);
 
 }
 
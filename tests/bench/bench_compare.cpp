@@ -0,0 +1,270 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+/*
+ * Compares benchmark results against a baseline, both written by the benchmarks with --json
+ *
+ * The samples of every benchmark found in both files are compared with the one-sided Mann-Whitney U test. A
+ * benchmark has regressed when it is slower with a p-value below --alpha and its median time has grown by more than
+ * --threshold percent - significance alone would flag differences too small to matter. Only the --track benchmarks
+ * fail the comparison, or all of them when none are tracked. A tracked benchmark missing from either file fails it
+ * too, so renaming one does not quietly switch its check off.
+ */
+
+#include "json/elements.h"
+#include "json/reader.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+namespace
+{
+
+struct Benchmark
+{
+    double p50Ns;
+    std::vector<double> sampleNs;
+};
+
+typedef std::map<std::string, Benchmark> BenchmarkMap;
+
+bool Load(const std::string& fileName, BenchmarkMap& benchmarks)
+{
+    std::ifstream file(fileName.c_str());
+    if(!file)
+    {
+        std::cerr << "Failed to open " << fileName << std::endl;
+        return false;
+    }
+
+    try
+    {
+        json::Object root;
+        json::Reader::Read(root, file);
+
+        const json::Array& array = root["benchmarks"];
+        for(json::Array::const_iterator i = array.Begin(); i != array.End(); ++i)
+        {
+            const json::Object& object = *i;
+            const json::String& name = object["name"];
+            const json::Object& nsPerOp = object["ns_per_op"];
+            const json::Number& p50 = nsPerOp["p50"];
+            const json::Array& samples = object["samples_ns"];
+
+            Benchmark& benchmark = benchmarks[name.Value()];
+            benchmark.p50Ns = p50.Value();
+            for(json::Array::const_iterator sample = samples.Begin(); sample != samples.End(); ++sample)
+            {
+                const json::Number& value = *sample;
+                benchmark.sampleNs.push_back(value.Value());
+            }
+        }
+    }
+    catch(json::Exception& e)
+    {
+        std::cerr << "Failed to read " << fileName << ": " << e.what() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// Probability of the current samples being larger than the baseline ones by chance - the one-sided Mann-Whitney U
+// test with the normal approximation, corrected for ties
+double SlowerPValue(const std::vector<double>& baseline, const std::vector<double>& current)
+{
+    // The bool tells the current samples apart
+    std::vector<std::pair<double, bool> > all;
+    for(std::vector<double>::const_iterator i = baseline.begin(); i != baseline.end(); ++i)
+    {
+        all.push_back(std::make_pair(*i, false));
+    }
+    for(std::vector<double>::const_iterator i = current.begin(); i != current.end(); ++i)
+    {
+        all.push_back(std::make_pair(*i, true));
+    }
+    std::sort(all.begin(), all.end());
+
+    // Tied values share the average of their ranks
+    double currentRanks = 0;
+    double ties = 0;
+    for(size_t i = 0; i < all.size(); )
+    {
+        size_t j = i;
+        while(j < all.size() && all[j].first == all[i].first)
+        {
+            ++j;
+        }
+        double rank = (double) (i + 1 + j) / 2.0;
+        for(size_t k = i; k < j; ++k)
+        {
+            if(all[k].second)
+            {
+                currentRanks += rank;
+            }
+        }
+        double t = (double) (j - i);
+        ties += t * t * t - t;
+        i = j;
+    }
+
+    double n1 = (double) current.size();
+    double n2 = (double) baseline.size();
+    double n = n1 + n2;
+    double u = currentRanks - n1 * (n1 + 1) / 2.0;
+    double variance = n1 * n2 / 12.0 * ((n + 1) - ties / (n * (n - 1)));
+    if(variance <= 0)
+    {
+        return 1.0;
+    }
+
+    // With continuity correction
+    double z = (u - n1 * n2 / 2.0 - 0.5) / sqrt(variance);
+    return 0.5 * erfc(z / sqrt(2.0));
+}
+
+void PrintUsage(const char *program)
+{
+    std::cerr << "Usage: " << program << " [--threshold <percent>] [--alpha <p-value>] [--track <benchmark>]..."
+        << " <baseline json> <results json>" << std::endl;
+}
+
+} // namespace
+
+
+int main(int argc, char *argv[])
+{
+    double threshold = 5.0;
+    double alpha = 0.01;
+    std::set<std::string> tracked;
+    std::vector<std::string> files;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+        if(strcmp(argv[i], "--threshold") == 0 && hasValue)
+        {
+            threshold = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--alpha") == 0 && hasValue)
+        {
+            alpha = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--track") == 0 && hasValue)
+        {
+            tracked.insert(argv[++i]);
+        }
+        else if(strncmp(argv[i], "--", 2) != 0)
+        {
+            files.push_back(argv[i]);
+        }
+        else
+        {
+            PrintUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    if(files.size() != 2 || threshold < 0 || alpha <= 0 || alpha >= 1)
+    {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+
+    BenchmarkMap baseline;
+    BenchmarkMap current;
+    if(!Load(files[0], baseline) || !Load(files[1], current))
+    {
+        return 2;
+    }
+
+    int failures = 0;
+    char line[256];
+    snprintf(line, sizeof(line), "%-32s %12s %12s %9s %10s  %s", "benchmark", "base p50 ns", "p50 ns", "change", "p-value", "result");
+    std::cout << line << std::endl;
+
+    for(BenchmarkMap::const_iterator i = current.begin(); i != current.end(); ++i)
+    {
+        bool isTracked = tracked.empty() || tracked.count(i->first) > 0;
+        BenchmarkMap::const_iterator base = baseline.find(i->first);
+        if(base == baseline.end())
+        {
+            snprintf(line, sizeof(line), "%-32s %12s %12.0f %9s %10s  %s", i->first.c_str(), "-", i->second.p50Ns, "-", "-", "new");
+            std::cout << line << std::endl;
+            continue;
+        }
+
+        double change = base->second.p50Ns > 0 ? (i->second.p50Ns / base->second.p50Ns - 1.0) * 100.0 : 0;
+        double slower = SlowerPValue(base->second.sampleNs, i->second.sampleNs);
+        double faster = SlowerPValue(i->second.sampleNs, base->second.sampleNs);
+
+        const char *result = "ok";
+        if(slower < alpha && change > threshold)
+        {
+            result = isTracked ? "REGRESSED" : "regressed, not tracked";
+            if(isTracked)
+            {
+                ++failures;
+            }
+        }
+        else if(faster < alpha && -change > threshold)
+        {
+            result = "improved";
+        }
+
+        snprintf(line, sizeof(line), "%-32s %12.0f %12.0f %8.1f%% %10.2g  %s", i->first.c_str(),
+            base->second.p50Ns, i->second.p50Ns, change, slower < faster ? slower : faster, result);
+        std::cout << line << std::endl;
+    }
+
+    for(BenchmarkMap::const_iterator i = baseline.begin(); i != baseline.end(); ++i)
+    {
+        if(current.count(i->first) == 0 && tracked.count(i->first) > 0)
+        {
+            std::cerr << "Tracked benchmark " << i->first << " was not run" << std::endl;
+            ++failures;
+        }
+    }
+    for(std::set<std::string>::const_iterator i = tracked.begin(); i != tracked.end(); ++i)
+    {
+        if(baseline.count(*i) == 0)
+        {
+            std::cerr << "Tracked benchmark " << *i << " has no baseline" << std::endl;
+            ++failures;
+        }
+    }
+
+    if(failures > 0)
+    {
+        std::cerr << failures << " tracked benchmark checks failed against " << files[0] << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
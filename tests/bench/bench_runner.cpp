@@ -0,0 +1,402 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+#include "bench_runner.h"
+#include "json/elements.h"
+#include "json/writer.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <intrin.h>
+#else
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define BENCH_HAS_TSC
+#endif
+
+
+const double BenchRunner::SAMPLE_TARGET_NS = 20000.0;
+
+BenchRunner::BenchRunner(const std::string& suiteName) : m_suiteName(suiteName), m_minTimeNs(0.5e9)
+{
+}
+
+void BenchRunner::AddOption(const std::string& name, const std::string& description, std::string *value)
+{
+    Option option;
+    option.name = "--" + name;
+    option.description = description;
+    option.value = value;
+    m_options.push_back(option);
+}
+
+void BenchRunner::AddCounter(const std::string& name, Counter counter, void *ctx)
+{
+    CounterEntry entry;
+    entry.name = name;
+    entry.counter = counter;
+    entry.ctx = ctx;
+    m_counters.push_back(entry);
+}
+
+bool BenchRunner::ParseArgs(int argc, char *argv[])
+{
+    bool perf = false;
+    for(int i = 1; i < argc; ++i)
+    {
+        if(strcmp(argv[i], "--perf") == 0)
+        {
+            perf = true;
+            continue;
+        }
+
+        if(i + 1 >= argc)
+        {
+            return false;
+        }
+
+        std::vector<Option>::iterator option = m_options.begin();
+        while(option != m_options.end() && option->name != argv[i])
+        {
+            ++option;
+        }
+
+        if(option != m_options.end())
+        {
+            *option->value = argv[++i];
+        }
+        else if(strcmp(argv[i], "--filter") == 0)
+        {
+            m_filter = argv[++i];
+        }
+        else if(strcmp(argv[i], "--time") == 0)
+        {
+            double seconds = atof(argv[++i]);
+            if(seconds <= 0)
+            {
+                return false;
+            }
+            m_minTimeNs = seconds * 1e9;
+        }
+        else if(strcmp(argv[i], "--json") == 0)
+        {
+            m_jsonFile = argv[++i];
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    // The benchmarks are still worth running without the counters
+    if(perf && !m_perfCounters.Open())
+    {
+        std::cerr << "Hardware counters are not available, " << m_perfCounters.GetError() << std::endl;
+    }
+    return true;
+}
+
+void BenchRunner::PrintUsage(const char *program) const
+{
+    std::cerr << "Usage: " << program << " [--filter <substring>] [--time <seconds per benchmark>] [--json <file>] [--perf]";
+    for(std::vector<Option>::const_iterator i = m_options.begin(); i != m_options.end(); ++i)
+    {
+        std::cerr << " [" << i->name << " <" << i->description << ">]";
+    }
+    std::cerr << std::endl;
+}
+
+double BenchRunner::NowNs()
+{
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency = { 0 };
+    LARGE_INTEGER counter;
+    if(frequency.QuadPart == 0)
+    {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+    return (double) counter.QuadPart * 1e9 / (double) frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+#endif
+}
+
+unsigned long long BenchRunner::Cycles()
+{
+#if defined(BENCH_HAS_TSC)
+    return (unsigned long long) __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+bool BenchRunner::HasCycleCounter()
+{
+#if defined(BENCH_HAS_TSC)
+    return true;
+#else
+    return false;
+#endif
+}
+
+double BenchRunner::Percentile(const std::vector<double>& sorted, double p)
+{
+    // Nearest rank
+    size_t rank = (size_t) (p / 100.0 * (double) sorted.size() + 0.5);
+    if(rank < 1)
+    {
+        rank = 1;
+    }
+    if(rank > sorted.size())
+    {
+        rank = sorted.size();
+    }
+    return sorted[rank - 1];
+}
+
+void BenchRunner::Run(const std::string& name, Function fn, void *ctx)
+{
+    if(!m_filter.empty() && name.find(m_filter) == std::string::npos)
+    {
+        return;
+    }
+
+    // The first call warms up the caches and tells how many calls make up a sample
+    double start = NowNs();
+    fn(ctx);
+    double single = NowNs() - start;
+    long batch = 1;
+    if(single < SAMPLE_TARGET_NS)
+    {
+        batch = (long) (SAMPLE_TARGET_NS / (single > 1.0 ? single : 1.0));
+    }
+
+    std::vector<double> countersStart;
+    for(std::vector<CounterEntry>::const_iterator i = m_counters.begin(); i != m_counters.end(); ++i)
+    {
+        countersStart.push_back(i->counter(i->ctx));
+    }
+
+    m_perfCounters.Start();
+
+    std::vector<double> samples;
+    double elapsed = 0;
+    unsigned long long cycles = 0;
+    long iterations = 0;
+    while((long) samples.size() < MIN_SAMPLES || (elapsed < m_minTimeNs && (long) samples.size() < MAX_SAMPLES))
+    {
+        unsigned long long c0 = Cycles();
+        double t0 = NowNs();
+        for(long i = 0; i < batch; ++i)
+        {
+            fn(ctx);
+        }
+        double t1 = NowNs();
+        unsigned long long c1 = Cycles();
+
+        samples.push_back((t1 - t0) / (double) batch);
+        elapsed += t1 - t0;
+        cycles += c1 - c0;
+        iterations += batch;
+    }
+
+    std::vector<double> perfCounts = m_perfCounters.Stop();
+
+    Result result;
+    for(size_t i = 0; i < perfCounts.size(); ++i)
+    {
+        result.perfCounters.push_back(std::make_pair(m_perfCounters.GetNames()[i], perfCounts[i] / (double) iterations));
+    }
+    for(size_t i = 0; i < m_counters.size(); ++i)
+    {
+        double total = m_counters[i].counter(m_counters[i].ctx) - countersStart[i];
+        result.counters.push_back(std::make_pair(m_counters[i].name, total / (double) iterations));
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    result.name = name;
+    result.samples = (long) samples.size();
+    result.iterations = iterations;
+    result.meanNs = elapsed / (double) iterations;
+    result.minNs = samples.front();
+    result.p50Ns = Percentile(samples, 50);
+    result.p90Ns = Percentile(samples, 90);
+    result.p99Ns = Percentile(samples, 99);
+    result.maxNs = samples.back();
+    // Picking evenly spaced ranks keeps the distribution of the samples, only with fewer of them
+    long saved = (long) samples.size() < SAVED_SAMPLES ? (long) samples.size() : SAVED_SAMPLES;
+    for(long i = 0; i < saved; ++i)
+    {
+        size_t rank = saved > 1 ? (size_t) ((double) i * (double) (samples.size() - 1) / (double) (saved - 1) + 0.5) : 0;
+        result.sampleNs.push_back(samples[rank]);
+    }
+    result.cyclesPerOp = HasCycleCounter() ? (double) cycles / (double) iterations : 0;
+    result.opsPerSec = 1e9 / result.meanNs;
+    m_results.push_back(result);
+
+    // Results are printed as they come, the slower benchmarks take a while
+    char line[256];
+    if(m_results.size() == 1)
+    {
+        snprintf(line, sizeof(line), "%-32s %12s %12s %12s %12s %12s", "benchmark", "p50 ns", "p90 ns", "p99 ns", "cycles/op", "ops/sec");
+        std::cout << line << std::endl;
+    }
+    snprintf(line, sizeof(line), "%-32s %12.0f %12.0f %12.0f %12.0f %12.0f", name.c_str(),
+        result.p50Ns, result.p90Ns, result.p99Ns, result.cyclesPerOp, result.opsPerSec);
+    std::cout << line << std::endl;
+    for(std::vector<std::pair<std::string, double> >::const_iterator i = result.counters.begin(); i != result.counters.end(); ++i)
+    {
+        snprintf(line, sizeof(line), "    %-28s %12.1f /op", i->first.c_str(), i->second);
+        std::cout << line << std::endl;
+    }
+    for(std::vector<std::pair<std::string, double> >::const_iterator i = result.perfCounters.begin(); i != result.perfCounters.end(); ++i)
+    {
+        snprintf(line, sizeof(line), "    %-28s %12.1f /op", i->first.c_str(), i->second);
+        std::cout << line << std::endl;
+    }
+    double instructions = FindCounter(result.perfCounters, "instructions");
+    double hwCycles = FindCounter(result.perfCounters, "cycles");
+    if(instructions > 0 && hwCycles > 0)
+    {
+        snprintf(line, sizeof(line), "    %-28s %12.2f", "ipc", instructions / hwCycles);
+        std::cout << line << std::endl;
+    }
+}
+
+double BenchRunner::FindCounter(const std::vector<std::pair<std::string, double> >& counters, const char *name)
+{
+    for(std::vector<std::pair<std::string, double> >::const_iterator i = counters.begin(); i != counters.end(); ++i)
+    {
+        if(i->first == name)
+        {
+            return i->second;
+        }
+    }
+    return 0;
+}
+
+bool BenchRunner::WriteJson() const
+{
+    if(m_jsonFile.empty())
+    {
+        return true;
+    }
+
+    json::Array benchmarks;
+    for(std::vector<Result>::const_iterator i = m_results.begin(); i != m_results.end(); ++i)
+    {
+        json::Object nsPerOp;
+        nsPerOp["mean"] = json::Number(i->meanNs);
+        nsPerOp["min"] = json::Number(i->minNs);
+        nsPerOp["p50"] = json::Number(i->p50Ns);
+        nsPerOp["p90"] = json::Number(i->p90Ns);
+        nsPerOp["p99"] = json::Number(i->p99Ns);
+        nsPerOp["max"] = json::Number(i->maxNs);
+
+        json::Object benchmark;
+        benchmark["name"] = json::String(i->name);
+        benchmark["samples"] = json::Number((double) i->samples);
+        benchmark["iterations"] = json::Number((double) i->iterations);
+        benchmark["ns_per_op"] = nsPerOp;
+        json::Array sampleNs;
+        for(std::vector<double>::const_iterator sample = i->sampleNs.begin(); sample != i->sampleNs.end(); ++sample)
+        {
+            sampleNs.Insert(json::Number(*sample));
+        }
+        benchmark["samples_ns"] = sampleNs;
+        if(HasCycleCounter())
+        {
+            benchmark["cycles_per_op"] = json::Number(i->cyclesPerOp);
+        }
+        else
+        {
+            benchmark["cycles_per_op"] = json::Null();
+        }
+        benchmark["ops_per_sec"] = json::Number(i->opsPerSec);
+        if(!i->counters.empty())
+        {
+            json::Object counters;
+            for(std::vector<std::pair<std::string, double> >::const_iterator c = i->counters.begin(); c != i->counters.end(); ++c)
+            {
+                counters[c->first] = json::Number(c->second);
+            }
+            benchmark["counters_per_op"] = counters;
+        }
+        if(!i->perfCounters.empty())
+        {
+            json::Object perfCounters;
+            for(std::vector<std::pair<std::string, double> >::const_iterator c = i->perfCounters.begin(); c != i->perfCounters.end(); ++c)
+            {
+                perfCounters[c->first] = json::Number(c->second);
+            }
+            double instructions = FindCounter(i->perfCounters, "instructions");
+            double cycles = FindCounter(i->perfCounters, "cycles");
+            if(instructions > 0 && cycles > 0)
+            {
+                perfCounters["ipc"] = json::Number(instructions / cycles);
+            }
+            benchmark["perf_per_op"] = perfCounters;
+        }
+        benchmarks.Insert(benchmark);
+    }
+
+    json::Object root;
+    root["suite"] = json::String(m_suiteName);
+    root["cycle_counter"] = json::String(HasCycleCounter() ? "tsc" : "none");
+    if(m_perfCounters.IsOpen())
+    {
+        root["perf_counters"] = json::String("on");
+    }
+    else if(!m_perfCounters.GetError().empty())
+    {
+        root["perf_counters"] = json::String(m_perfCounters.GetError());
+    }
+    root["benchmarks"] = benchmarks;
+
+    std::ofstream file(m_jsonFile.c_str());
+    if(!file)
+    {
+        std::cerr << "Failed to open " << m_jsonFile << std::endl;
+        return false;
+    }
+    json::Writer::Write(root, file);
+    file << std::endl;
+    return file.good();
+}
+
+const std::vector<BenchRunner::Result>& BenchRunner::GetResults() const
+{
+    return m_results;
+}
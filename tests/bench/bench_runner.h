@@ -0,0 +1,124 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+/*
+ * Benchmark runner
+ *
+ * Each benchmark is a function that performs one operation. The runner calls it in batches that take at least
+ * SAMPLE_TARGET_NS, so the timer cost disappears, and keeps the time per operation of every batch. It goes on until
+ * the benchmark has run for the requested time and has at least MIN_SAMPLES samples, and reports the percentiles of
+ * the samples.
+ *
+ * With --perf, hardware performance counters (see perf_counters.h) run over the same calls and are reported per
+ * operation next to the times.
+ */
+
+#ifndef _BENCH_RUNNER_H_
+#define _BENCH_RUNNER_H_
+
+#include "perf_counters.h"
+
+#include <string>
+#include <vector>
+
+
+class BenchRunner
+{
+public:
+    typedef void (*Function)(void *ctx);
+    // Returns a running total, e.g. of allocations made so far. Results report its increase per operation.
+    typedef double (*Counter)(void *ctx);
+
+    struct Result
+    {
+        std::string name;
+        long samples;
+        long iterations;
+        // Time per operation, in nanoseconds
+        double meanNs;
+        double minNs;
+        double p50Ns;
+        double p90Ns;
+        double p99Ns;
+        double maxNs;
+        // Up to SAVED_SAMPLES times per operation, spread evenly over the sorted samples, for comparing runs
+        std::vector<double> sampleNs;
+        // Time stamp counter ticks per operation, 0 where there is no counter
+        double cyclesPerOp;
+        double opsPerSec;
+        std::vector<std::pair<std::string, double> > counters;
+        // Hardware counters per operation, empty without --perf
+        std::vector<std::pair<std::string, double> > perfCounters;
+    };
+
+    BenchRunner(const std::string& suiteName);
+
+    // Adds a suite specific --<name> <value> option, for ParseArgs
+    void AddOption(const std::string& name, const std::string& description, std::string *value);
+    void AddCounter(const std::string& name, Counter counter, void *ctx);
+
+    // Accepts --filter <substring>, --time <seconds per benchmark>, --json <output file>, --perf and the added options
+    bool ParseArgs(int argc, char *argv[]);
+    void PrintUsage(const char *program) const;
+
+    // Runs a benchmark, unless it is filtered out, and prints its result
+    void Run(const std::string& name, Function fn, void *ctx);
+    // Writes the results to the --json file, if one was given
+    bool WriteJson() const;
+    const std::vector<Result>& GetResults() const;
+
+    static double NowNs();
+    static unsigned long long Cycles();
+    static bool HasCycleCounter();
+
+private:
+    static double Percentile(const std::vector<double>& sorted, double p);
+    static double FindCounter(const std::vector<std::pair<std::string, double> >& counters, const char *name);
+
+    static const double SAMPLE_TARGET_NS;
+    static const long MIN_SAMPLES = 10;
+    static const long MAX_SAMPLES = 100000;
+    static const long SAVED_SAMPLES = 100;
+
+    struct Option
+    {
+        std::string name;
+        std::string description;
+        std::string *value;
+    };
+
+    struct CounterEntry
+    {
+        std::string name;
+        Counter counter;
+        void *ctx;
+    };
+
+    std::string m_suiteName;
+    std::string m_filter;
+    std::string m_jsonFile;
+    double m_minTimeNs;
+    std::vector<Option> m_options;
+    std::vector<CounterEntry> m_counters;
+    std::vector<Result> m_results;
+    PerfCounters m_perfCounters;
+};
+
+
+#endif // _BENCH_RUNNER_H_
@@ -0,0 +1,390 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+/*
+ * Micro benchmarks of the CLINT core and of the M-Pin primitives
+ */
+
+#include "bench_runner.h"
+
+#include <iostream>
+#include <string.h>
+
+extern "C"
+{
+#include "crypto/mpin.h"
+}
+
+
+namespace
+{
+
+const int BATCH = MPIN_BATCH_SIZE;
+const int PIN = 1234;
+
+class Octet : public octet
+{
+public:
+    Octet()
+    {
+        len = 0;
+        max = sizeof(m_buf);
+        val = m_buf;
+    }
+
+    void CopyFrom(const octet& other)
+    {
+        memcpy(m_buf, other.val, other.len);
+        len = other.len;
+    }
+
+private:
+    Octet(const Octet&);
+    Octet& operator = (const Octet&);
+
+    char m_buf[12 * PFS];
+};
+
+struct State
+{
+    csprng rng;
+    char seed[128];
+
+    // Field and group elements
+    BIG a, b, r, k;
+    ECP G, P;
+    ECP2 Q, T;
+    FP12 g, f, h;
+
+    // Symmetric crypto
+    hash sha;
+    aes aesCtx;
+    gcm gcmCtx;
+    char key[16];
+    char iv[12];
+    char data[1024];
+    char out[1024];
+    char digest[HASH_BYTES];
+    char tag[16];
+
+    // M-Pin data of one client
+    int date;
+    Octet S, SST, ID, HCID, CST, TOKEN, PERMIT, X, Y, SEC, U, UT, V;
+    Octet HID, HTID, MCID, MTCID, E, F, BADE, BADF;
+    Octet R, Z, W, WCID, G1, G2, CK, SK;
+    Octet ENC, RX;
+    Octet tmp, tmp2;
+    mpin_point_cache cache;
+
+    // The same client, BATCH times over
+    octet *hids[BATCH], *htids[BATCH], *ys[BATCH], *us[BATCH], *uts[BATCH], *vs[BATCH], *hcids[BATCH], *permits[BATCH];
+    Octet permitBuf[BATCH];
+    int res[BATCH];
+};
+
+/*
+ * Field and curve arithmetic
+ */
+
+void FpMul(void *ctx) { State *s = (State *) ctx; FP_mul(s->r, s->a, s->b); }
+void FpSqr(void *ctx) { State *s = (State *) ctx; FP_sqr(s->r, s->a); }
+void FpInv(void *ctx) { State *s = (State *) ctx; FP_inv(s->r, s->a); }
+void FpSqrt(void *ctx) { State *s = (State *) ctx; FP_sqrt(s->r, s->a); }
+void EcpMul(void *ctx) { State *s = (State *) ctx; ECP_copy(&s->P, &s->G); ECP_mul(&s->P, s->k); }
+void PairG1Mul(void *ctx) { State *s = (State *) ctx; ECP_copy(&s->P, &s->G); PAIR_G1mul(&s->P, s->k); }
+void Ecp2Mul(void *ctx) { State *s = (State *) ctx; ECP2_copy(&s->T, &s->Q); ECP2_mul(&s->T, s->k); }
+void PairG2Mul(void *ctx) { State *s = (State *) ctx; ECP2_copy(&s->T, &s->Q); PAIR_G2mul(&s->T, s->k); }
+void PairAte(void *ctx) { State *s = (State *) ctx; PAIR_ate(&s->h, &s->Q, &s->G); }
+void PairDoubleAte(void *ctx) { State *s = (State *) ctx; PAIR_double_ate(&s->h, &s->Q, &s->G, &s->Q, &s->G); }
+void PairFexp(void *ctx) { State *s = (State *) ctx; FP12_copy(&s->h, &s->f); PAIR_fexp(&s->h); }
+void Fp12Pow(void *ctx) { State *s = (State *) ctx; FP12_pow(&s->h, &s->g, s->k); }
+void Fp12Compow(void *ctx) { State *s = (State *) ctx; FP12_compow(&s->h, &s->g, s->k); }
+void PairGTpow(void *ctx) { State *s = (State *) ctx; FP12_copy(&s->h, &s->g); PAIR_GTpow(&s->h, s->k); }
+
+/*
+ * Symmetric crypto and random numbers
+ */
+
+void Hash64(void *ctx)
+{
+    State *s = (State *) ctx;
+    HASH_init(&s->sha);
+    HASH_update(&s->sha, s->data, 64);
+    HASH_hash(&s->sha, s->digest);
+}
+
+void Hash1K(void *ctx)
+{
+    State *s = (State *) ctx;
+    HASH_init(&s->sha);
+    HASH_update(&s->sha, s->data, sizeof(s->data));
+    HASH_hash(&s->sha, s->digest);
+}
+
+void AesInit(void *ctx) { State *s = (State *) ctx; AES_init(&s->aesCtx, CBC, s->key, s->iv); }
+void AesEcbEncrypt(void *ctx) { State *s = (State *) ctx; AES_ecb_encrypt(&s->aesCtx, (uchar *) s->out); }
+void AesEcbEncrypt1K(void *ctx) { State *s = (State *) ctx; AES_ecb_encrypt_blocks(&s->aesCtx, (uchar *) s->out, sizeof(s->out) / 16); }
+void AesEcbDecrypt(void *ctx) { State *s = (State *) ctx; AES_ecb_decrypt(&s->aesCtx, (uchar *) s->out); }
+void AesCbcEncrypt(void *ctx) { State *s = (State *) ctx; AES_encrypt(&s->aesCtx, s->out); }
+void AesCbcDecrypt(void *ctx) { State *s = (State *) ctx; AES_decrypt(&s->aesCtx, s->out); }
+
+void Gcm1K(void *ctx)
+{
+    State *s = (State *) ctx;
+    GCM_init(&s->gcmCtx, s->key, sizeof(s->iv), s->iv);
+    GCM_add_header(&s->gcmCtx, s->data, 16);
+    GCM_add_plain(&s->gcmCtx, s->out, s->data, sizeof(s->data));
+    GCM_finish(&s->gcmCtx, s->tag);
+}
+
+void Gcm1KDecrypt(void *ctx)
+{
+    State *s = (State *) ctx;
+    GCM_init(&s->gcmCtx, s->key, sizeof(s->iv), s->iv);
+    GCM_add_header(&s->gcmCtx, s->data, 16);
+    GCM_add_cipher(&s->gcmCtx, s->data, s->out, sizeof(s->out));
+    GCM_finish(&s->gcmCtx, s->tag);
+}
+
+void RandByte(void *ctx) { State *s = (State *) ctx; s->out[0] = (char) RAND_byte(&s->rng); }
+void RandBytes32(void *ctx) { State *s = (State *) ctx; RAND_bytes(&s->rng, s->out, 32); }
+void RandSeed(void *ctx) { State *s = (State *) ctx; csprng rng; RAND_seed(&rng, sizeof(s->seed), s->seed); RAND_clean(&rng); }
+
+/*
+ * M-Pin entry points
+ */
+
+void MpinToday(void *ctx) { State *s = (State *) ctx; s->date = (int) today(); }
+void MpinCreateCsprng(void *ctx) { State *s = (State *) ctx; csprng rng; octet raw = { sizeof(s->seed), sizeof(s->seed), s->seed }; CREATE_CSPRNG(&rng, &raw); KILL_CSPRNG(&rng); }
+void MpinCreateSessionCsprng(void *ctx) { csprng rng; CREATE_SESSION_CSPRNG(&rng); KILL_CSPRNG(&rng); }
+void MpinHashId(void *ctx) { State *s = (State *) ctx; MPIN_HASH_ID(&s->ID, &s->tmp); }
+void MpinRandomGenerate(void *ctx) { State *s = (State *) ctx; MPIN_RANDOM_GENERATE(&s->rng, &s->tmp); }
+void MpinGetServerSecret(void *ctx) { State *s = (State *) ctx; MPIN_GET_SERVER_SECRET(&s->S, &s->tmp); }
+void MpinGetClientSecret(void *ctx) { State *s = (State *) ctx; MPIN_GET_CLIENT_SECRET(&s->S, &s->HCID, &s->tmp); }
+void MpinGetClientPermit(void *ctx) { State *s = (State *) ctx; MPIN_GET_CLIENT_PERMIT(s->date, &s->S, &s->HCID, &s->tmp); }
+void MpinGetClientPermits(void *ctx) { State *s = (State *) ctx; MPIN_GET_CLIENT_PERMITS(s->date, &s->S, BATCH, s->hcids, s->permits); }
+void MpinGetG1Multiple(void *ctx) { State *s = (State *) ctx; MPIN_GET_G1_MULTIPLE(&s->rng, 1, &s->RX, &s->ID, &s->tmp); }
+void MpinRecombineG1(void *ctx) { State *s = (State *) ctx; MPIN_RECOMBINE_G1(&s->CST, &s->PERMIT, &s->tmp); }
+void MpinRecombineG2(void *ctx) { State *s = (State *) ctx; MPIN_RECOMBINE_G2(&s->SST, &s->SST, &s->tmp); }
+void MpinCompressG1(void *ctx) { State *s = (State *) ctx; s->tmp.CopyFrom(s->U); MPIN_COMPRESS_G1(&s->tmp); }
+void MpinExtractPin(void *ctx) { State *s = (State *) ctx; s->tmp.CopyFrom(s->CST); MPIN_EXTRACT_PIN(&s->ID, PIN, &s->tmp); }
+void MpinEncoding(void *ctx) { State *s = (State *) ctx; s->tmp.CopyFrom(s->U); MPIN_ENCODING(&s->rng, &s->tmp); }
+void MpinDecoding(void *ctx) { State *s = (State *) ctx; s->tmp.CopyFrom(s->ENC); MPIN_DECODING(&s->tmp); }
+void MpinMapClientId(void *ctx) { State *s = (State *) ctx; MPIN_MAP_CLIENT_ID(s->date, &s->ID, &s->tmp, &s->tmp2); }
+
+void MpinClient1(void *ctx)
+{
+    State *s = (State *) ctx;
+    MPIN_CLIENT_1(s->date, &s->ID, NULL, &s->X, PIN, &s->TOKEN, &s->tmp, &s->U, &s->UT, &s->PERMIT);
+}
+
+void MpinClient1Precomp(void *ctx)
+{
+    State *s = (State *) ctx;
+    MPIN_CLIENT_1_PRECOMP(s->date, &s->MCID, &s->MTCID, NULL, &s->X, PIN, &s->TOKEN, &s->tmp, &s->U, &s->UT, &s->PERMIT);
+}
+
+void MpinClient2(void *ctx) { State *s = (State *) ctx; s->tmp.CopyFrom(s->SEC); MPIN_CLIENT_2(&s->X, &s->Y, &s->tmp); }
+void MpinServer1(void *ctx) { State *s = (State *) ctx; MPIN_SERVER_1(s->date, &s->ID, &s->HID, &s->HTID); }
+void MpinServer1Cached(void *ctx) { State *s = (State *) ctx; MPIN_SERVER_1_CACHED(&s->cache, s->date, &s->ID, &s->HID, &s->HTID); }
+
+void MpinServer2(void *ctx)
+{
+    State *s = (State *) ctx;
+    MPIN_SERVER_2(s->date, &s->HID, &s->HTID, &s->Y, &s->SST, &s->U, &s->UT, &s->V, &s->E, &s->F);
+}
+
+void MpinServer2Batch(void *ctx)
+{
+    State *s = (State *) ctx;
+    MPIN_SERVER_2_BATCH(s->date, BATCH, &s->rng, s->hids, s->htids, s->ys, &s->SST, s->us, s->uts, s->vs, s->res);
+}
+
+void MpinServer2BatchNoRng(void *ctx)
+{
+    State *s = (State *) ctx;
+    MPIN_SERVER_2_BATCH(s->date, BATCH, NULL, s->hids, s->htids, s->ys, &s->SST, s->us, s->uts, s->vs, s->res);
+}
+
+void MpinKangaroo(void *ctx) { State *s = (State *) ctx; MPIN_KANGAROO(&s->BADE, &s->BADF); }
+void MpinPrecompute(void *ctx) { State *s = (State *) ctx; MPIN_PRECOMPUTE(&s->TOKEN, &s->HCID, &s->G1, &s->G2); }
+void MpinClientKey(void *ctx) { State *s = (State *) ctx; MPIN_CLIENT_KEY(&s->G1, &s->G2, PIN, &s->R, &s->X, &s->WCID, &s->CK); }
+void MpinServerKey(void *ctx) { State *s = (State *) ctx; MPIN_SERVER_KEY(&s->Z, &s->SST, &s->W, &s->U, &s->UT, &s->SK); }
+
+void Setup(State *s)
+{
+    for(size_t i = 0; i < sizeof(s->seed); ++i)
+    {
+        s->seed[i] = (char) (i * 7 + 1);
+    }
+    RAND_seed(&s->rng, sizeof(s->seed), s->seed);
+
+    BIG m, gx, gy;
+    BIG_rcopy(m, Modulus);
+    BIG_randomnum(s->a, m, &s->rng); FP_nres(s->a);
+    BIG_randomnum(s->b, m, &s->rng); FP_nres(s->b);
+    BIG_rcopy(m, CURVE_Order);
+    BIG_randomnum(s->k, m, &s->rng);
+
+    BIG_rcopy(gx, CURVE_Gx);
+    BIG_rcopy(gy, CURVE_Gy);
+    ECP_set(&s->G, gx, gy);
+
+    FP2 qx, qy;
+    BIG_rcopy(qx.a, CURVE_Pxa); FP_nres(qx.a);
+    BIG_rcopy(qx.b, CURVE_Pxb); FP_nres(qx.b);
+    BIG_rcopy(qy.a, CURVE_Pya); FP_nres(qy.a);
+    BIG_rcopy(qy.b, CURVE_Pyb); FP_nres(qy.b);
+    ECP2_set(&s->Q, &qx, &qy);
+
+    PAIR_ate(&s->f, &s->Q, &s->G);
+    FP12_copy(&s->g, &s->f);
+    PAIR_fexp(&s->g);
+
+    RAND_bytes(&s->rng, s->key, sizeof(s->key));
+    RAND_bytes(&s->rng, s->iv, sizeof(s->iv));
+    RAND_bytes(&s->rng, s->data, sizeof(s->data));
+    memcpy(s->out, s->data, sizeof(s->out));
+    AES_init(&s->aesCtx, CBC, s->key, s->iv);
+
+    // One registered client, with a time permit for today
+    s->date = (int) today();
+    MPIN_RANDOM_GENERATE(&s->rng, &s->S);
+    MPIN_GET_SERVER_SECRET(&s->S, &s->SST);
+    s->ID.len = sprintf(s->ID.val, "bench@example.com");
+    MPIN_HASH_ID(&s->ID, &s->HCID);
+    MPIN_GET_CLIENT_SECRET(&s->S, &s->HCID, &s->CST);
+    s->TOKEN.CopyFrom(s->CST);
+    MPIN_EXTRACT_PIN(&s->ID, PIN, &s->TOKEN);
+    MPIN_GET_CLIENT_PERMIT(s->date, &s->S, &s->HCID, &s->PERMIT);
+    MPIN_MAP_CLIENT_ID(s->date, &s->ID, &s->MCID, &s->MTCID);
+
+    // A successful authentication
+    MPIN_RANDOM_GENERATE(&s->rng, &s->X);
+    MPIN_RANDOM_GENERATE(&s->rng, &s->Y);
+    MPIN_CLIENT_1(s->date, &s->ID, NULL, &s->X, PIN, &s->TOKEN, &s->SEC, &s->U, &s->UT, &s->PERMIT);
+    s->V.CopyFrom(s->SEC);
+    MPIN_CLIENT_2(&s->X, &s->Y, &s->V);
+    MPIN_SERVER_1(s->date, &s->ID, &s->HID, &s->HTID);
+    MPIN_INIT_POINT_CACHE(&s->cache);
+
+    // A wrong PIN, for the kangaroos
+    MPIN_CLIENT_1(s->date, &s->ID, NULL, &s->X, PIN + 7, &s->TOKEN, &s->tmp, &s->tmp2, &s->R, &s->PERMIT);
+    MPIN_CLIENT_2(&s->X, &s->Y, &s->tmp);
+    MPIN_SERVER_2(s->date, &s->HID, &s->HTID, &s->Y, &s->SST, &s->tmp2, &s->R, &s->tmp, &s->BADE, &s->BADF);
+
+    // M-Pin Full key agreement
+    MPIN_GET_G1_MULTIPLE(&s->rng, 1, &s->R, &s->HCID, &s->Z);
+    MPIN_GET_G1_MULTIPLE(&s->rng, 0, &s->W, &s->HTID, &s->WCID);
+    MPIN_PRECOMPUTE(&s->TOKEN, &s->HCID, &s->G1, &s->G2);
+
+    for(int i = 0; i < BATCH; ++i)
+    {
+        s->hids[i] = &s->HID;
+        s->htids[i] = &s->HTID;
+        s->ys[i] = &s->Y;
+        s->us[i] = &s->U;
+        s->uts[i] = &s->UT;
+        s->vs[i] = &s->V;
+        s->hcids[i] = &s->HCID;
+        s->permits[i] = &s->permitBuf[i];
+    }
+
+    // An encoded point for MPIN_DECODING
+    s->ENC.CopyFrom(s->U);
+    MPIN_ENCODING(&s->rng, &s->ENC);
+}
+
+}
+
+
+int main(int argc, char *argv[])
+{
+    BenchRunner runner("crypto");
+    if(!runner.ParseArgs(argc, argv))
+    {
+        runner.PrintUsage(argv[0]);
+        return 1;
+    }
+
+    static State state;
+    Setup(&state);
+    void *s = &state;
+
+    runner.Run("FP_mul", FpMul, s);
+    runner.Run("FP_sqr", FpSqr, s);
+    runner.Run("FP_inv", FpInv, s);
+    runner.Run("FP_sqrt", FpSqrt, s);
+    runner.Run("ECP_mul", EcpMul, s);
+    runner.Run("PAIR_G1mul", PairG1Mul, s);
+    runner.Run("ECP2_mul", Ecp2Mul, s);
+    runner.Run("PAIR_G2mul", PairG2Mul, s);
+    runner.Run("PAIR_ate", PairAte, s);
+    runner.Run("PAIR_double_ate", PairDoubleAte, s);
+    runner.Run("PAIR_fexp", PairFexp, s);
+    runner.Run("FP12_pow", Fp12Pow, s);
+    runner.Run("FP12_compow", Fp12Compow, s);
+    runner.Run("PAIR_GTpow", PairGTpow, s);
+
+    runner.Run("HASH_sha256/64B", Hash64, s);
+    runner.Run("HASH_sha256/1KB", Hash1K, s);
+    runner.Run("AES_init", AesInit, s);
+    runner.Run("AES_ecb_encrypt", AesEcbEncrypt, s);
+    runner.Run("AES_ecb_encrypt_blocks/1KB", AesEcbEncrypt1K, s);
+    runner.Run("AES_ecb_decrypt", AesEcbDecrypt, s);
+    runner.Run("AES_encrypt/CBC", AesCbcEncrypt, s);
+    runner.Run("AES_decrypt/CBC", AesCbcDecrypt, s);
+    runner.Run("GCM_encrypt/1KB", Gcm1K, s);
+    runner.Run("GCM_decrypt/1KB", Gcm1KDecrypt, s);
+    runner.Run("RAND_byte", RandByte, s);
+    runner.Run("RAND_bytes/32B", RandBytes32, s);
+    runner.Run("RAND_seed", RandSeed, s);
+
+    runner.Run("today", MpinToday, s);
+    runner.Run("CREATE_CSPRNG", MpinCreateCsprng, s);
+    runner.Run("CREATE_SESSION_CSPRNG", MpinCreateSessionCsprng, s);
+    runner.Run("MPIN_HASH_ID", MpinHashId, s);
+    runner.Run("MPIN_RANDOM_GENERATE", MpinRandomGenerate, s);
+    runner.Run("MPIN_GET_SERVER_SECRET", MpinGetServerSecret, s);
+    runner.Run("MPIN_GET_CLIENT_SECRET", MpinGetClientSecret, s);
+    runner.Run("MPIN_GET_CLIENT_PERMIT", MpinGetClientPermit, s);
+    runner.Run("MPIN_GET_CLIENT_PERMITS/16", MpinGetClientPermits, s);
+    runner.Run("MPIN_GET_G1_MULTIPLE", MpinGetG1Multiple, s);
+    runner.Run("MPIN_RECOMBINE_G1", MpinRecombineG1, s);
+    runner.Run("MPIN_RECOMBINE_G2", MpinRecombineG2, s);
+    runner.Run("MPIN_COMPRESS_G1", MpinCompressG1, s);
+    runner.Run("MPIN_EXTRACT_PIN", MpinExtractPin, s);
+    runner.Run("MPIN_ENCODING", MpinEncoding, s);
+    runner.Run("MPIN_DECODING", MpinDecoding, s);
+    runner.Run("MPIN_MAP_CLIENT_ID", MpinMapClientId, s);
+    runner.Run("MPIN_CLIENT_1", MpinClient1, s);
+    runner.Run("MPIN_CLIENT_1_PRECOMP", MpinClient1Precomp, s);
+    runner.Run("MPIN_CLIENT_2", MpinClient2, s);
+    runner.Run("MPIN_SERVER_1", MpinServer1, s);
+    runner.Run("MPIN_SERVER_1_CACHED", MpinServer1Cached, s);
+    runner.Run("MPIN_SERVER_2", MpinServer2, s);
+    runner.Run("MPIN_SERVER_2_BATCH/16", MpinServer2Batch, s);
+    runner.Run("MPIN_SERVER_2_BATCH/16/no_rng", MpinServer2BatchNoRng, s);
+    runner.Run("MPIN_KANGAROO", MpinKangaroo, s);
+    runner.Run("MPIN_PRECOMPUTE", MpinPrecompute, s);
+    runner.Run("MPIN_CLIENT_KEY", MpinClientKey, s);
+    runner.Run("MPIN_SERVER_KEY", MpinServerKey, s);
+
+    return runner.WriteJson() ? 0 : 1;
+}
@@ -0,0 +1,582 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+/*
+ * Local stand-in for the M-Pin backend - the RPA, both D-TAs, the time permits storage and the
+ * authentication server - for load tests that must not depend on a real deployment
+ */
+
+#include "local_backend.h"
+#include "CvLogger.h"
+
+#include <string.h>
+#include <time.h>
+
+typedef util::String String;
+typedef util::StringMap StringMap;
+typedef util::JsonObject JsonObject;
+
+using CvShared::LogMessage;
+using CvShared::enLogLevel_Debug1;
+using CvShared::enLogLevel_Error;
+
+namespace
+{
+
+const char *WIRE_ENCODING_BASE64 = "base64";
+const char *JSON_CONTENT_TYPE = "application/json";
+const char *TEXT_PLAIN_CONTENT_TYPE = "text/plain";
+
+const int HTTP_OK = 200;
+const int HTTP_BAD_REQUEST = 400;
+const int HTTP_UNAUTHORIZED = 401;
+const int HTTP_NOT_FOUND = 404;
+const int HTTP_REQUEST_TIMEOUT = 408;
+
+class Octet : public octet
+{
+public:
+    Octet()
+    {
+        len = 0;
+        max = sizeof(m_buf);
+        val = m_buf;
+    }
+
+    // Data longer than the buffer is cut, which the crypto functions reject as an invalid point
+    Octet(const std::string& data)
+    {
+        len = (int) std::min(data.size(), sizeof(m_buf));
+        max = sizeof(m_buf);
+        val = m_buf;
+        memcpy(m_buf, data.data(), len);
+    }
+
+    String ToString() const
+    {
+        return String(val, len);
+    }
+
+private:
+    Octet(const Octet&);
+    Octet& operator = (const Octet&);
+
+    char m_buf[12 * PFS];
+};
+
+const char * StatusMessage(int status)
+{
+    switch(status)
+    {
+    case HTTP_OK:
+        return "OK";
+    case HTTP_BAD_REQUEST:
+        return "Bad Request";
+    case HTTP_UNAUTHORIZED:
+        return "Unauthorized";
+    case HTTP_NOT_FOUND:
+        return "Not Found";
+    case HTTP_REQUEST_TIMEOUT:
+        return "Request Timeout";
+    default:
+        return "";
+    }
+}
+
+void ParseQuery(const String& queryString, OUT StringMap& query)
+{
+    std::vector<CvString> params;
+    queryString.Tokenize("&", params);
+    for(std::vector<CvString>::const_iterator i = params.begin(); i != params.end(); ++i)
+    {
+        size_t pos = i->find('=');
+        if(pos == String::npos)
+        {
+            query.Put(*i, "");
+        }
+        else
+        {
+            query.Put(i->substr(0, pos), i->substr(pos + 1));
+        }
+    }
+}
+
+String HashMpinId(const String& mpinId)
+{
+    Octet cid(mpinId);
+    Octet hcid;
+    MPIN_HASH_ID(&cid, &hcid);
+    return hcid.ToString();
+}
+
+String GetUserId(const String& mpinIdHex)
+{
+    JsonObject mpinId;
+    if(!mpinId.Parse(util::HexDecode(mpinIdHex).c_str()))
+    {
+        return "";
+    }
+    return mpinId.GetStringParam("userID");
+}
+
+} // namespace
+
+
+LocalBackend::Settings::Settings() :
+    port(8005), maxConnections(128), usePermits(true), compressedPoints(false), base64Encoding(false)
+{
+}
+
+LocalBackend::Reply::Reply() : status(HTTP_OK)
+{
+}
+
+const LocalBackend::Route LocalBackend::ROUTES[] =
+{
+    { enHttpMethod_GET, "/rps/clientSettings", &LocalBackend::GetClientSettings },
+    { enHttpMethod_PUT, "/rps/user", &LocalBackend::RegisterUser },
+    { enHttpMethod_GET, "/rps/signature/", &LocalBackend::GetSignature },
+    { enHttpMethod_GET, "/rps/timePermit/", &LocalBackend::GetTimePermit },
+    { enHttpMethod_POST, "/rps/pass1", &LocalBackend::Pass1 },
+    { enHttpMethod_POST, "/rps/pass2", &LocalBackend::Pass2 },
+    { enHttpMethod_POST, "/mpinAuthenticate", &LocalBackend::Authenticate },
+    { enHttpMethod_GET, "/dta/clientSecret", &LocalBackend::GetDtaClientSecret },
+    { enHttpMethod_GET, "/dta/timePermit", &LocalBackend::GetDtaTimePermit },
+    { enHttpMethod_GET, "/s3/", &LocalBackend::GetStoredTimePermit },
+    { enHttpMethod_Unknown, NULL, NULL },
+};
+
+LocalBackend::LocalBackend(const Settings& settings) : m_settings(settings)
+{
+    CMapOptions options;
+    options[HTTP_SERVER_OPTION_PORT] = String().Format("%d", settings.port);
+    options[HTTP_SERVER_OPTION_MAX_CONNECTIONS_NUM] = String().Format("%d", settings.maxConnections);
+    Init(options);
+
+    if(!CREATE_SESSION_CSPRNG(&m_rng))
+    {
+        LogMessage(enLogLevel_Error, "No entropy for the local backend random generator");
+    }
+
+    m_appId = RandomHex(16);
+    m_signingKey = RandomHex(32);
+
+    Octet share1, share2, sst1, sst2, sst;
+    MPIN_RANDOM_GENERATE(&m_rng, &share1);
+    MPIN_RANDOM_GENERATE(&m_rng, &share2);
+    MPIN_GET_SERVER_SECRET(&share1, &sst1);
+    MPIN_GET_SERVER_SECRET(&share2, &sst2);
+    MPIN_RECOMBINE_G2(&sst1, &sst2, &sst);
+    m_customerShare = share1.ToString();
+    m_certivoxShare = share2.ToString();
+    m_serverSecret = sst.ToString();
+
+    MPIN_INIT_POINT_CACHE(&m_pointCache);
+}
+
+LocalBackend::~LocalBackend()
+{
+    KILL_CSPRNG(&m_rng);
+    m_customerShare.Overwrite();
+    m_certivoxShare.Overwrite();
+    m_serverSecret.Overwrite();
+}
+
+bool LocalBackend::Run()
+{
+    return Start();
+}
+
+bool LocalBackend::OnReceiveRequest(IN CvContextHandle contextHandle)
+{
+    CvContext *context = NULL;
+    CvMutexLock lock = LockContext(contextHandle, context);
+    if(context == NULL)
+    {
+        return false;
+    }
+
+    Reply reply;
+    Dispatch(context->GetRequest(), reply);
+
+    String data;
+    CvResponse& response = context->GetResponse();
+    response.SetStatusCode(reply.status);
+    response.SetStatusMessage(StatusMessage(reply.status));
+    if(!reply.raw.empty())
+    {
+        data = reply.raw;
+        response.SetHeaderValue(HTTP_HEADER_CONTENT_TYPE, TEXT_PLAIN_CONTENT_TYPE);
+    }
+    else
+    {
+        data = reply.json.ToString();
+        response.SetHeaderValue(HTTP_HEADER_CONTENT_TYPE, JSON_CONTENT_TYPE);
+    }
+    response.SetContent(data.data(), (uint32_t) data.size());
+
+    return context->SendResponse();
+}
+
+void LocalBackend::Dispatch(const CvRequest& request, OUT Reply& reply)
+{
+    const String& uri = request.GetUri();
+
+    const Route *route = ROUTES;
+    while(route->prefix != NULL && (route->method != request.GetMethod() || uri.compare(0, strlen(route->prefix), route->prefix) != 0))
+    {
+        ++route;
+    }
+
+    if(route->prefix == NULL)
+    {
+        SetError(reply, HTTP_NOT_FOUND, "Not found");
+        return;
+    }
+
+    Request parsed;
+    parsed.method = request.GetMethod();
+    parsed.resource = String(uri, strlen(route->prefix)).TrimLeft("/");
+    ParseQuery(request.GetQueryString(), parsed.query);
+
+    size_t contentLength = request.GetHeaderValue(HTTP_HEADER_CONTENT_LENGTH).Ulong();
+    if(contentLength > 0 && !parsed.body.Parse(String((const char *) request.GetContent(), contentLength).c_str()))
+    {
+        SetError(reply, HTTP_BAD_REQUEST, "Invalid json");
+        return;
+    }
+
+    (this->*route->handler)(parsed, reply);
+
+    LogMessage(enLogLevel_Debug1, "%s %s -> %d", HttpMethodEnumToString(parsed.method).c_str(), uri.c_str(), reply.status);
+}
+
+void LocalBackend::GetClientSettings(const Request& request, OUT Reply& reply)
+{
+    // Relative urls are resolved by the SDK against the backend url, so all the services are served from here
+    reply.json["mpinAuthServerURL"] = json::String("/rps");
+    reply.json["registerURL"] = json::String("/rps/user");
+    reply.json["signatureURL"] = json::String("/rps/signature");
+    reply.json["timePermitsURL"] = json::String("/rps/timePermit");
+    reply.json["timePermitsStorageURL"] = json::String("/s3");
+    reply.json["certivoxURL"] = json::String("/dta/");
+    reply.json["authenticateURL"] = json::String("/mpinAuthenticate");
+    reply.json["appID"] = json::String(m_appId);
+    reply.json["requestOTP"] = json::Boolean(false);
+    reply.json["setDeviceName"] = json::Boolean(false);
+    reply.json["usePermits"] = json::Boolean(m_settings.usePermits);
+    reply.json["compressedPoints"] = json::Boolean(m_settings.compressedPoints);
+    reply.json["wireEncoding"] = json::String(m_settings.base64Encoding ? WIRE_ENCODING_BASE64 : "hex");
+}
+
+void LocalBackend::RegisterUser(const Request& request, OUT Reply& reply)
+{
+    String userId = request.body.GetStringParam("userId");
+    if(userId.empty())
+    {
+        SetError(reply, HTTP_BAD_REQUEST, "Missing userId");
+        return;
+    }
+
+    // PUT /rps/user/<mpinId> restarts a registration and keeps the M-Pin ID
+    String mpinIdHex = request.resource;
+    if(mpinIdHex.empty())
+    {
+        char issued[32];
+        time_t now = time(NULL);
+        strftime(issued, sizeof(issued), "%Y-%m-%d %H:%M:%S", gmtime(&now));
+
+        JsonObject mpinId;
+        mpinId["mobile"] = json::Number(1);
+        mpinId["issued"] = json::String(issued);
+        mpinId["userID"] = json::String(userId);
+        mpinId["salt"] = json::String(RandomHex(16));
+        mpinIdHex = util::HexEncode(mpinId.ToString());
+    }
+    else if(m_users.find(mpinIdHex) == m_users.end())
+    {
+        SetError(reply, HTTP_NOT_FOUND, "Unknown M-Pin ID");
+        return;
+    }
+
+    User& user = m_users[mpinIdHex];
+    user.regOTT = RandomHex(16);
+    user.hashMpinId = HashMpinId(util::HexDecode(mpinIdHex));
+
+    reply.json["mpinId"] = json::String(mpinIdHex);
+    reply.json["regOTT"] = json::String(user.regOTT);
+    reply.json["active"] = json::Boolean(true);
+}
+
+void LocalBackend::GetSignature(const Request& request, OUT Reply& reply)
+{
+    std::map<String, User>::const_iterator user = m_users.find(request.resource);
+    const char *regOTT = request.query.Get("regOTT");
+    if(user == m_users.end() || regOTT == NULL || user->second.regOTT != regOTT)
+    {
+        SetError(reply, HTTP_UNAUTHORIZED, "Identity not verified");
+        return;
+    }
+
+    Octet share(m_customerShare);
+    Octet hcid(user->second.hashMpinId);
+    Octet clientSecret;
+    MPIN_GET_CLIENT_SECRET(&share, &hcid, &clientSecret);
+
+    String hashMpinIdHex = util::HexEncode(user->second.hashMpinId);
+    SetWireData(reply.json, "clientSecretShare", EncodePoint(clientSecret.ToString()));
+    reply.json["params"] = json::String(String().Format("mobile=1&app_id=%s&hash_mpin_id=%s&signature=%s",
+        m_appId.c_str(), hashMpinIdHex.c_str(), Sign("clientSecret" + hashMpinIdHex).c_str()));
+}
+
+void LocalBackend::GetTimePermit(const Request& request, OUT Reply& reply)
+{
+    std::map<String, User>::const_iterator user = m_users.find(request.resource);
+    if(user == m_users.end())
+    {
+        SetError(reply, HTTP_NOT_FOUND, "Unknown M-Pin ID");
+        return;
+    }
+
+    int date = (int) today();
+    Octet share(m_customerShare);
+    Octet hcid(user->second.hashMpinId);
+    Octet timePermit;
+    MPIN_GET_CLIENT_PERMIT(date, &share, &hcid, &timePermit);
+
+    String storageId = util::HexEncode(user->second.hashMpinId);
+    reply.json["date"] = json::Number(date);
+    reply.json["storageId"] = json::String(storageId);
+    reply.json["signature"] = json::String(Sign("timePermit" + storageId));
+    SetWireData(reply.json, "timePermit", EncodePoint(timePermit.ToString()));
+}
+
+void LocalBackend::GetDtaClientSecret(const Request& request, OUT Reply& reply)
+{
+    const char *hashMpinIdHex = request.query.Get("hash_mpin_id");
+    if(hashMpinIdHex == NULL || !CheckSignature(request, String("clientSecret") + hashMpinIdHex))
+    {
+        SetError(reply, HTTP_UNAUTHORIZED, "Invalid signature");
+        return;
+    }
+
+    Octet share(m_certivoxShare);
+    Octet hcid(util::HexDecode(hashMpinIdHex));
+    Octet clientSecret;
+    MPIN_GET_CLIENT_SECRET(&share, &hcid, &clientSecret);
+
+    SetWireData(reply.json, "clientSecret", EncodePoint(clientSecret.ToString()));
+    reply.json["message"] = json::String("OK");
+}
+
+void LocalBackend::GetDtaTimePermit(const Request& request, OUT Reply& reply)
+{
+    const char *hashMpinIdHex = request.query.Get("hash_mpin_id");
+    if(hashMpinIdHex == NULL || !CheckSignature(request, String("timePermit") + hashMpinIdHex))
+    {
+        SetError(reply, HTTP_UNAUTHORIZED, "Invalid signature");
+        return;
+    }
+
+    int date = (int) today();
+    Octet share(m_certivoxShare);
+    Octet hcid(util::HexDecode(hashMpinIdHex));
+    Octet timePermit;
+    MPIN_GET_CLIENT_PERMIT(date, &share, &hcid, &timePermit);
+
+    // The D-TA publishes its time permit shares to the storage, where clients look first
+    String point = EncodePoint(timePermit.ToString());
+    m_storedTimePermits[String().Format("%s/%d/%s", m_appId.c_str(), date, hashMpinIdHex)] = util::HexEncode(point);
+
+    SetWireData(reply.json, "timePermit", point);
+    reply.json["message"] = json::String("OK");
+}
+
+void LocalBackend::GetStoredTimePermit(const Request& request, OUT Reply& reply)
+{
+    std::map<String, String>::const_iterator timePermit = m_storedTimePermits.find(request.resource);
+    if(timePermit == m_storedTimePermits.end())
+    {
+        reply.status = HTTP_NOT_FOUND;
+        reply.raw = "NoSuchKey";
+        return;
+    }
+
+    reply.raw = timePermit->second;
+}
+
+void LocalBackend::Pass1(const Request& request, OUT Reply& reply)
+{
+    String mpinIdHex = request.body.GetStringParam("mpin_id");
+    if(mpinIdHex.empty())
+    {
+        SetError(reply, HTTP_BAD_REQUEST, "Missing mpin_id");
+        return;
+    }
+
+    AuthSession session;
+    session.u = GetWireData(request.body, "U");
+    session.ut = GetWireData(request.body, "UT");
+    session.date = session.ut.empty() ? 0 : (int) today();
+
+    Octet cid(util::HexDecode(mpinIdHex));
+    Octet hid, htid, y;
+    MPIN_SERVER_1_CACHED(&m_pointCache, session.date, &cid, &hid, &htid);
+    MPIN_RANDOM_GENERATE(&m_rng, &y);
+    session.hid = hid.ToString();
+    session.htid = htid.ToString();
+    session.y = y.ToString();
+    m_authSessions[mpinIdHex] = session;
+
+    SetWireData(reply.json, "y", session.y);
+    reply.json["pass"] = json::Number(1);
+    reply.json["message"] = json::String("OK");
+}
+
+void LocalBackend::Pass2(const Request& request, OUT Reply& reply)
+{
+    String mpinIdHex = request.body.GetStringParam("mpin_id");
+    std::map<String, AuthSession>::iterator i = m_authSessions.find(mpinIdHex);
+    if(i == m_authSessions.end())
+    {
+        SetError(reply, HTTP_BAD_REQUEST, "No pass 1 for mpin_id");
+        return;
+    }
+
+    AuthSession session = i->second;
+    m_authSessions.erase(i);
+
+    int date = session.date;
+    Octet hid(session.hid), htid(session.htid), y(session.y), sst(m_serverSecret);
+    Octet u(session.u), ut(session.ut), v(GetWireData(request.body, "V"));
+    Octet e, f;
+    int res = MPIN_SERVER_2(date, &hid, date ? &htid : NULL, &y, &sst, &u, date ? &ut : NULL, &v, &e, &f);
+    if(res == MPIN_BAD_PIN)
+    {
+        // Like the real server, find out how far the PIN was off
+        LogMessage(enLogLevel_Debug1, "Wrong PIN, error %d", MPIN_KANGAROO(&e, &f));
+    }
+
+    String authOTT = RandomHex(16);
+    AuthResult& result = m_authResults[authOTT];
+    result.userId = GetUserId(mpinIdHex);
+    result.ok = (res == MPIN_OK);
+
+    reply.json["authOTT"] = json::String(authOTT);
+    reply.json["pass"] = json::Number(2);
+}
+
+void LocalBackend::Authenticate(const Request& request, OUT Reply& reply)
+{
+    String authOTT;
+    try
+    {
+        authOTT = JsonObject((const json::Object&) request.body["mpinResponse"]).GetStringParam("authOTT");
+    }
+    catch(json::Exception&)
+    {
+        SetError(reply, HTTP_BAD_REQUEST, "Missing mpinResponse");
+        return;
+    }
+
+    std::map<String, AuthResult>::iterator i = m_authResults.find(authOTT);
+    if(i == m_authResults.end())
+    {
+        SetError(reply, HTTP_REQUEST_TIMEOUT, "Request expired");
+        return;
+    }
+
+    AuthResult result = i->second;
+    m_authResults.erase(i);
+
+    if(!result.ok)
+    {
+        SetError(reply, HTTP_UNAUTHORIZED, "Wrong PIN.");
+        return;
+    }
+
+    reply.json["userId"] = json::String(result.userId);
+}
+
+String LocalBackend::RandomHex(int len)
+{
+    String bytes(len, '\0');
+    RAND_bytes(&m_rng, &bytes[0], len);
+    return util::HexEncode(bytes);
+}
+
+String LocalBackend::Sign(const String& message) const
+{
+    hash sha;
+    char digest[HASH_BYTES];
+    HASH_init(&sha);
+    HASH_update(&sha, m_signingKey.data(), (int) m_signingKey.size());
+    HASH_update(&sha, message.data(), (int) message.size());
+    HASH_hash(&sha, digest);
+    return util::HexEncode(digest, sizeof(digest));
+}
+
+bool LocalBackend::CheckSignature(const Request& request, const String& message) const
+{
+    const char *appId = request.query.Get("app_id");
+    const char *signature = request.query.Get("signature");
+    return appId != NULL && signature != NULL && m_appId == appId && Sign(message) == signature;
+}
+
+String LocalBackend::EncodePoint(const String& point) const
+{
+    if(!m_settings.compressedPoints)
+    {
+        return point;
+    }
+
+    Octet compressed(point);
+    MPIN_COMPRESS_G1(&compressed);
+    return compressed.ToString();
+}
+
+void LocalBackend::SetWireData(OUT JsonObject& json, const char *name, const String& data) const
+{
+    if(m_settings.base64Encoding)
+    {
+        json[name] = json::String(util::Base64Encode(data));
+        json["encoding"] = json::String(WIRE_ENCODING_BASE64);
+    }
+    else
+    {
+        json[name] = json::String(util::HexEncode(data));
+    }
+}
+
+String LocalBackend::GetWireData(const JsonObject& json, const char *name)
+{
+    if(String(json.GetStringParam("encoding")) == WIRE_ENCODING_BASE64)
+    {
+        return util::Base64Decode(json.GetStringParam(name));
+    }
+
+    return util::HexDecode(json.GetStringParam(name));
+}
+
+void LocalBackend::SetError(OUT Reply& reply, int status, const char *message)
+{
+    reply.status = status;
+    reply.json.Clear();
+    reply.json["message"] = json::String(message);
+}
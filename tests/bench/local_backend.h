@@ -0,0 +1,154 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+/*
+ * Local stand-in for the M-Pin backend - the RPA, both D-TAs, the time permits storage and the
+ * authentication server - for load tests that must not depend on a real deployment
+ */
+
+#ifndef _LOCAL_BACKEND_H_
+#define _LOCAL_BACKEND_H_
+
+#include "CvHttpServerUv.h"
+#include "utils.h"
+
+extern "C"
+{
+#include "crypto/mpin.h"
+}
+
+#include <map>
+
+class LocalBackend : public CvHttpServerUv
+{
+public:
+    typedef util::String String;
+    typedef util::StringMap StringMap;
+    typedef util::JsonObject JsonObject;
+
+    struct Settings
+    {
+        Settings();
+
+        int port;
+        int maxConnections;
+        // Client settings the SDK picks up
+        bool usePermits;
+        bool compressedPoints;
+        bool base64Encoding;
+    };
+
+    LocalBackend(const Settings& settings);
+    ~LocalBackend();
+
+    // Serves requests until the process is stopped. All requests are handled on the libuv loop thread.
+    bool Run();
+
+private:
+    struct Request
+    {
+        enHttpMethod_t method;
+        // The uri part after the handler prefix
+        String resource;
+        StringMap query;
+        JsonObject body;
+    };
+
+    struct Reply
+    {
+        Reply();
+
+        int status;
+        JsonObject json;
+        // Sent instead of json if not empty
+        String raw;
+    };
+
+    typedef void (LocalBackend::*Handler)(const Request& request, OUT Reply& reply);
+
+    struct Route
+    {
+        enHttpMethod_t method;
+        const char *prefix;
+        Handler handler;
+    };
+
+    struct User
+    {
+        String regOTT;
+        String hashMpinId;
+    };
+
+    struct AuthSession
+    {
+        int date;
+        String hid;
+        String htid;
+        String u;
+        String ut;
+        String y;
+    };
+
+    struct AuthResult
+    {
+        String userId;
+        bool ok;
+    };
+
+    virtual bool OnReceiveRequest(IN CvContextHandle contextHandle);
+    void Dispatch(const CvRequest& request, OUT Reply& reply);
+
+    void GetClientSettings(const Request& request, OUT Reply& reply);
+    void RegisterUser(const Request& request, OUT Reply& reply);
+    void GetSignature(const Request& request, OUT Reply& reply);
+    void GetTimePermit(const Request& request, OUT Reply& reply);
+    void GetDtaClientSecret(const Request& request, OUT Reply& reply);
+    void GetDtaTimePermit(const Request& request, OUT Reply& reply);
+    void GetStoredTimePermit(const Request& request, OUT Reply& reply);
+    void Pass1(const Request& request, OUT Reply& reply);
+    void Pass2(const Request& request, OUT Reply& reply);
+    void Authenticate(const Request& request, OUT Reply& reply);
+
+    String RandomHex(int len);
+    String Sign(const String& message) const;
+    bool CheckSignature(const Request& request, const String& message) const;
+    String EncodePoint(const String& point) const;
+    void SetWireData(OUT JsonObject& json, const char *name, const String& data) const;
+    static String GetWireData(const JsonObject& json, const char *name);
+    static void SetError(OUT Reply& reply, int status, const char *message);
+
+    static const Route ROUTES[];
+
+    Settings m_settings;
+    csprng m_rng;
+    String m_appId;
+    String m_signingKey;
+    // The master secret is split between the customer's D-TA and the CertiVox D-TA, like in a real deployment
+    String m_customerShare;
+    String m_certivoxShare;
+    String m_serverSecret;
+    mpin_point_cache m_pointCache;
+
+    std::map<String, User> m_users;
+    std::map<String, AuthSession> m_authSessions;
+    std::map<String, AuthResult> m_authResults;
+    std::map<String, String> m_storedTimePermits;
+};
+
+#endif // _LOCAL_BACKEND_H_
@@ -0,0 +1,89 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+/*
+ * Runs the local M-Pin backend, e.g. for MPinClient -b http://127.0.0.1:8005
+ */
+
+#include "local_backend.h"
+#include "CvLogger.h"
+
+#include <iostream>
+#include <getopt.h>
+#include <stdlib.h>
+
+static void PrintUsage(const char *program)
+{
+    std::cerr << "Usage: " << program << " [--port <port>] [--no-permits] [--compressed] [--base64] [--verbose]" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    static struct option options[] = {
+        { "port", required_argument, NULL, 'p' },
+        { "no-permits", no_argument, NULL, 'n' },
+        { "compressed", no_argument, NULL, 'c' },
+        { "base64", no_argument, NULL, 'b' },
+        { "verbose", no_argument, NULL, 'v' },
+        { "help", no_argument, NULL, 'h' },
+        { 0, 0, 0, 0 }
+    };
+
+    LocalBackend::Settings settings;
+    bool verbose = false;
+
+    int ch;
+    while((ch = getopt_long(argc, argv, "", options, NULL)) != -1)
+    {
+        switch(ch)
+        {
+        case 'p':
+            settings.port = atoi(optarg);
+            break;
+        case 'n':
+            settings.usePermits = false;
+            break;
+        case 'c':
+            settings.compressedPoints = true;
+            break;
+        case 'b':
+            settings.base64Encoding = true;
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        default:
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Requests are logged to syslog only with --verbose, logging each one costs more than handling it
+    CvShared::InitLogger("local_backend", verbose ? CvShared::enLogLevel_Debug1 : CvShared::enLogLevel_Error);
+
+    LocalBackend backend(settings);
+    std::cout << "M-Pin backend listening on http://127.0.0.1:" << settings.port << std::endl;
+    if(!backend.Run())
+    {
+        std::cerr << "Failed to start the backend on port " << settings.port << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
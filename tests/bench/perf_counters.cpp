@@ -0,0 +1,185 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+#include "perf_counters.h"
+
+#include <string.h>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+PerfCounters::PerfCounters()
+{
+}
+
+PerfCounters::~PerfCounters()
+{
+    Close();
+}
+
+#if defined(__linux__)
+
+bool PerfCounters::OpenCounter(const char *name, unsigned int type, unsigned long long config)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    // Only user space is counted, which is also what an unprivileged process may count
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    int groupFd = m_fds.empty() ? -1 : m_fds.front();
+    attr.disabled = m_fds.empty() ? 1 : 0;
+
+    int fd = (int) syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0);
+    if(fd < 0)
+    {
+        if(m_fds.empty())
+        {
+            m_error = std::string("perf_event_open failed: ") + strerror(errno);
+            if(errno == EACCES || errno == EPERM)
+            {
+                m_error += " (see /proc/sys/kernel/perf_event_paranoid)";
+            }
+            else if(errno == ENOENT || errno == EOPNOTSUPP)
+            {
+                m_error += " (no hardware counters, e.g. in a virtual machine)";
+            }
+        }
+        return false;
+    }
+
+    m_fds.push_back(fd);
+    m_names.push_back(name);
+    return true;
+}
+
+bool PerfCounters::Open()
+{
+    Close();
+
+    // The cycles counter leads the group, so all counters run over exactly the same time
+    if(!OpenCounter("cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES))
+    {
+        return false;
+    }
+
+    OpenCounter("instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    OpenCounter("branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    OpenCounter("l1d_read_misses", PERF_TYPE_HW_CACHE,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    return true;
+}
+
+void PerfCounters::Close()
+{
+    for(std::vector<int>::iterator i = m_fds.begin(); i != m_fds.end(); ++i)
+    {
+        close(*i);
+    }
+    m_fds.clear();
+    m_names.clear();
+}
+
+void PerfCounters::Start()
+{
+    if(m_fds.empty())
+    {
+        return;
+    }
+    ioctl(m_fds.front(), PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(m_fds.front(), PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+std::vector<double> PerfCounters::Stop()
+{
+    std::vector<double> counts;
+    if(m_fds.empty())
+    {
+        return counts;
+    }
+    ioctl(m_fds.front(), PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    // nr, time_enabled, time_running, value[nr]
+    std::vector<unsigned long long> data(3 + m_fds.size());
+    ssize_t size = read(m_fds.front(), &data[0], data.size() * sizeof(data[0]));
+    if(size < (ssize_t) (data.size() * sizeof(data[0])) || data[0] != m_fds.size())
+    {
+        return counts;
+    }
+
+    // When the PMU is shared with other groups the group runs only part of the time, scale up to the full time
+    double scale = (data[2] > 0 && data[2] < data[1]) ? (double) data[1] / (double) data[2] : 1.0;
+    for(size_t i = 0; i < m_fds.size(); ++i)
+    {
+        counts.push_back((double) data[3 + i] * scale);
+    }
+    return counts;
+}
+
+#else
+
+bool PerfCounters::OpenCounter(const char *, unsigned int, unsigned long long)
+{
+    return false;
+}
+
+bool PerfCounters::Open()
+{
+    m_error = "perf events are available on Linux only";
+    return false;
+}
+
+void PerfCounters::Close()
+{
+}
+
+void PerfCounters::Start()
+{
+}
+
+std::vector<double> PerfCounters::Stop()
+{
+    return std::vector<double>();
+}
+
+#endif
+
+bool PerfCounters::IsOpen() const
+{
+    return !m_fds.empty();
+}
+
+const std::string& PerfCounters::GetError() const
+{
+    return m_error;
+}
+
+const std::vector<std::string>& PerfCounters::GetNames() const
+{
+    return m_names;
+}
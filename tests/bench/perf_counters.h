@@ -0,0 +1,63 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+/*
+ * Hardware performance counters around a benchmark, through a Linux perf_event_open group
+ *
+ * The group counts user space cycles, instructions, branch misses and L1 data cache read misses. Counters the CPU or
+ * the kernel does not offer are left out. Where perf events are not permitted at all (other platforms, containers,
+ * a high kernel.perf_event_paranoid) Open() fails with a reason, and the benchmarks run without counters.
+ */
+
+#ifndef _PERF_COUNTERS_H_
+#define _PERF_COUNTERS_H_
+
+#include <string>
+#include <vector>
+
+
+class PerfCounters
+{
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    bool Open();
+    bool IsOpen() const;
+    const std::string& GetError() const;
+
+    void Start();
+    // Stops counting and returns the counts since Start(), in the order of GetNames()
+    std::vector<double> Stop();
+    const std::vector<std::string>& GetNames() const;
+
+private:
+    PerfCounters(const PerfCounters&);
+    PerfCounters& operator = (const PerfCounters&);
+
+    bool OpenCounter(const char *name, unsigned int type, unsigned long long config);
+    void Close();
+
+    std::vector<int> m_fds;
+    std::vector<std::string> m_names;
+    std::string m_error;
+};
+
+
+#endif // _PERF_COUNTERS_H_
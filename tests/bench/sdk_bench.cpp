@@ -0,0 +1,261 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+/*
+ * End-to-end MPinSDK benchmarks. The backend is replayed from the recorded unit tests data, so the
+ * flows run without network and the time the SDK spends in its own code can be told apart. With --network
+ * the replayed requests take the latency of a simulated network instead, to see the flows' wall-clock time.
+ */
+
+#include "bench_runner.h"
+#include "../common/test_context.h"
+#include "../common/test_mpin_sdk.h"
+#include "../common/memory_storage.h"
+#include "../common/alloc_tracker.h"
+#include "CvLogger.h"
+
+#include <iostream>
+
+typedef MPinSDK::String String;
+typedef MPinSDK::StringMap StringMap;
+typedef MPinSDK::Status Status;
+typedef MPinSDK::UserPtr UserPtr;
+typedef MPinSDK::IHttpRequest IHttpRequest;
+typedef MPinSDK::IStorage IStorage;
+
+
+namespace
+{
+
+const char *BACKEND = "http://10.10.40.62:8005";
+const char *USER_ID = "testUser";
+const char *PIN = "1234";
+
+// Time spent outside of the SDK code, in nanoseconds
+double g_networkNs = 0;
+double g_storageNs = 0;
+unsigned long long g_requests = 0;
+unsigned long long g_failures = 0;
+
+class TimedHttpRequest : public IHttpRequest
+{
+public:
+    TimedHttpRequest(IHttpRequest *request) : m_request(request) {}
+    ~TimedHttpRequest() { delete m_request; }
+
+    virtual void SetHeaders(const StringMap& headers) { m_request->SetHeaders(headers); }
+    virtual void SetQueryParams(const StringMap& queryParams) { m_request->SetQueryParams(queryParams); }
+    virtual void SetContent(const String& data) { m_request->SetContent(data); }
+    virtual void SetTimeout(int seconds) { m_request->SetTimeout(seconds); }
+    virtual const String& GetExecuteErrorMessage() const { return m_request->GetExecuteErrorMessage(); }
+    virtual int GetHttpStatusCode() const { return m_request->GetHttpStatusCode(); }
+    virtual const StringMap& GetResponseHeaders() const { return m_request->GetResponseHeaders(); }
+    virtual const String& GetResponseData() const { return m_request->GetResponseData(); }
+
+    virtual bool Execute(Method method, const String& url)
+    {
+        double start = BenchRunner::NowNs();
+        bool res = m_request->Execute(method, url);
+        g_networkNs += BenchRunner::NowNs() - start;
+        ++g_requests;
+        return res;
+    }
+
+private:
+    TimedHttpRequest(const TimedHttpRequest&);
+    TimedHttpRequest& operator = (const TimedHttpRequest&);
+
+    IHttpRequest *m_request;
+};
+
+class TimedStorage : public IStorage
+{
+public:
+    virtual bool SetData(const String& data)
+    {
+        double start = BenchRunner::NowNs();
+        bool res = m_storage.SetData(data);
+        g_storageNs += BenchRunner::NowNs() - start;
+        return res;
+    }
+
+    virtual bool GetData(String& data)
+    {
+        double start = BenchRunner::NowNs();
+        bool res = m_storage.GetData(data);
+        g_storageNs += BenchRunner::NowNs() - start;
+        return res;
+    }
+
+    virtual const String& GetErrorMessage() const
+    {
+        return m_storage.GetErrorMessage();
+    }
+
+private:
+    MemoryStorage m_storage;
+};
+
+// Selects which test case of the recorded data is replayed
+class RecordedTestCase : public TestContext::AutoContextData
+{
+public:
+    virtual String Get() const { return m_name; }
+    void Set(const String& name) { m_name = name; }
+
+private:
+    String m_name;
+};
+
+class BenchContext : public TestContext
+{
+public:
+    BenchContext(const AutoContextData& autoContextData) : TestContext(autoContextData) {}
+
+    virtual IHttpRequest * CreateHttpRequest() const
+    {
+        return new TimedHttpRequest(TestContext::CreateHttpRequest());
+    }
+
+    virtual IStorage * GetStorage(IStorage::Type type) const
+    {
+        return const_cast<TimedStorage *>(type == IStorage::SECURE ? &m_secureStorage : &m_nonSecureStorage);
+    }
+
+    virtual MPinSDK::CryptoType GetMPinCryptoType() const
+    {
+        return MPinSDK::CRYPTO_NON_TEE;
+    }
+
+private:
+    TimedStorage m_nonSecureStorage;
+    TimedStorage m_secureStorage;
+};
+
+struct State
+{
+    State() : context(testCase), sdk(context) {}
+
+    RecordedTestCase testCase;
+    BenchContext context;
+    TestMPinSDK sdk;
+    UserPtr user;
+};
+
+void Check(const Status& s)
+{
+    if(s != Status::OK)
+    {
+        ++g_failures;
+    }
+}
+
+// The flows run on the main thread, as do the replayed requests
+double AllocCount(void *) { return (double) AllocTracker::GetThreadCounts().allocations; }
+double AllocBytes(void *) { return (double) AllocTracker::GetThreadCounts().bytes; }
+double Requests(void *) { return (double) g_requests; }
+double NetworkNs(void *) { return g_networkNs; }
+double StorageNs(void *) { return g_storageNs; }
+double SdkNs(void *) { return BenchRunner::NowNs() - g_networkNs - g_storageNs; }
+double Failures(void *) { return (double) g_failures; }
+
+void Register(void *ctx)
+{
+    State *s = (State *) ctx;
+    UserPtr user = s->sdk.MakeNewUser(USER_ID);
+    Check(s->sdk.StartRegistration(user));
+    Check(s->sdk.ConfirmRegistration(user));
+    Check(s->sdk.FinishRegistration(user, PIN));
+    s->sdk.DeleteUser(user);
+}
+
+void Authenticate(void *ctx)
+{
+    State *s = (State *) ctx;
+    Check(s->sdk.StartAuthentication(s->user));
+    Check(s->sdk.FinishAuthentication(s->user, PIN));
+}
+
+} // namespace
+
+
+int main(int argc, char *argv[])
+{
+    BenchRunner runner("sdk");
+    String recordedDataFile = "unit_tests_recorded_data.json";
+    runner.AddOption("data", "recorded http data file", &recordedDataFile);
+    // See NetworkModel::Parse, e.g. "rtt=50,jitter=10,distribution=lognormal,bandwidth=2048"
+    String networkSpec;
+    runner.AddOption("network", "simulated network spec", &networkSpec);
+    if(!runner.ParseArgs(argc, argv))
+    {
+        runner.PrintUsage(argv[0]);
+        return 1;
+    }
+
+    CvShared::InitLogger("cvlog.txt", CvShared::enLogLevel_None);
+
+    static State state;
+    state.context.EnterRequestPlayerMode(recordedDataFile);
+    String error;
+    if(!networkSpec.empty() && !state.context.GetNetworkModel().Parse(networkSpec, error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    state.testCase.Set("testInit");
+    StringMap config;
+    config.Put(MPinSDK::CONFIG_BACKEND, BACKEND);
+    Status s = state.sdk.Init(config);
+    if(s != Status::OK)
+    {
+        std::cerr << "Failed to initialize the SDK from " << recordedDataFile << ": " << s.GetErrorMessage() << std::endl;
+        return 1;
+    }
+
+    runner.AddCounter("allocs", AllocCount, NULL);
+    runner.AddCounter("alloc_bytes", AllocBytes, NULL);
+    runner.AddCounter("http_requests", Requests, NULL);
+    runner.AddCounter("network_ns", NetworkNs, NULL);
+    runner.AddCounter("storage_ns", StorageNs, NULL);
+    runner.AddCounter("sdk_ns", SdkNs, NULL);
+    runner.AddCounter("failures", Failures, NULL);
+
+    // Both flows replay the requests recorded by the testAuthenticate1 unit test
+    state.testCase.Set("testAuthenticate1");
+    runner.Run("flow/register", Register, &state);
+
+    state.user = state.sdk.MakeNewUser(USER_ID);
+    Check(state.sdk.StartRegistration(state.user));
+    Check(state.sdk.ConfirmRegistration(state.user));
+    Check(state.sdk.FinishRegistration(state.user, PIN));
+    runner.Run("flow/authenticate", Authenticate, &state);
+    state.sdk.DeleteUser(state.user);
+    state.user = UserPtr();
+
+    // Unless they were injected by the network spec
+    if(g_failures > 0 && networkSpec.empty())
+    {
+        std::cerr << g_failures << " SDK calls failed, the recorded data does not match the flows" << std::endl;
+        return 1;
+    }
+
+    return runner.WriteJson() ? 0 : 1;
+}
@@ -0,0 +1,141 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+/*
+ * Heap allocations accounting for tests and benchmarks
+ */
+
+#include "alloc_tracker.h"
+#include <stdlib.h>
+#include <new>
+
+#if defined(_MSC_VER)
+#define ALLOC_TRACKER_THREAD_LOCAL __declspec(thread)
+#else
+#define ALLOC_TRACKER_THREAD_LOCAL __thread
+#endif
+
+typedef AllocTracker::Counts Counts;
+
+namespace
+{
+    // Plain integers, the counting must not allocate and must not take locks
+    ALLOC_TRACKER_THREAD_LOCAL unsigned long long threadAllocations = 0;
+    ALLOC_TRACKER_THREAD_LOCAL unsigned long long threadBytes = 0;
+
+    inline void Count(size_t size)
+    {
+        ++threadAllocations;
+        threadBytes += size;
+    }
+}
+
+#if defined(__GLIBC__)
+
+// glibc exports its allocator under these names too, so the replacements below can forward to it
+extern "C"
+{
+    void * __libc_malloc(size_t size);
+    void * __libc_calloc(size_t count, size_t size);
+    void * __libc_realloc(void *ptr, size_t size);
+    void __libc_free(void *ptr);
+
+    void * malloc(size_t size) __THROW
+    {
+        Count(size);
+        return __libc_malloc(size);
+    }
+
+    void * calloc(size_t count, size_t size) __THROW
+    {
+        Count(count * size);
+        return __libc_calloc(count, size);
+    }
+
+    // Growing or shrinking a block counts as an allocation, freeing it with realloc(ptr, 0) does not
+    void * realloc(void *ptr, size_t size) __THROW
+    {
+        if (size > 0)
+        {
+            Count(size);
+        }
+        return __libc_realloc(ptr, size);
+    }
+
+    void free(void *ptr) __THROW
+    {
+        __libc_free(ptr);
+    }
+}
+
+bool AllocTracker::CountsMalloc()
+{
+    return true;
+}
+
+#else
+
+void * operator new(size_t size)
+{
+    Count(size);
+    void *ptr = malloc(size > 0 ? size : 1);
+    if (ptr == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void * operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) throw()
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr) throw()
+{
+    free(ptr);
+}
+
+bool AllocTracker::CountsMalloc()
+{
+    return false;
+}
+
+#endif
+
+Counts AllocTracker::GetThreadCounts()
+{
+    Counts counts;
+    counts.allocations = threadAllocations;
+    counts.bytes = threadBytes;
+    return counts;
+}
+
+Counts AllocTracker::Scope::Get() const
+{
+    Counts counts = GetThreadCounts();
+    counts.allocations -= m_start.allocations;
+    counts.bytes -= m_start.bytes;
+    return counts;
+}
@@ -0,0 +1,60 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+/*
+ * Heap allocations accounting for tests and benchmarks
+ *
+ * Linking alloc_tracker.cpp replaces malloc, calloc and realloc with glibc, which covers operator new and the C code
+ * as well, and the global operator new elsewhere. The library never links it, so only the builds that opt in pay for
+ * the counting.
+ */
+
+#ifndef _TEST_ALLOC_TRACKER_H_
+#define _TEST_ALLOC_TRACKER_H_
+
+class AllocTracker
+{
+public:
+    class Counts
+    {
+    public:
+        Counts() : allocations(0), bytes(0) {}
+
+        unsigned long long allocations;
+        unsigned long long bytes;
+    };
+
+    // Allocations made by the calling thread so far
+    static Counts GetThreadCounts();
+    // Whether malloc is counted, or only operator new
+    static bool CountsMalloc();
+
+    // Counts the allocations the calling thread makes while the scope is alive
+    class Scope
+    {
+    public:
+        Scope() : m_start(GetThreadCounts()) {}
+        Counts Get() const;
+
+    private:
+        Counts m_start;
+    };
+};
+
+#endif // _TEST_ALLOC_TRACKER_H_
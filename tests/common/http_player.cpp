@@ -22,6 +22,7 @@ under the License.
  */
 
 #include "http_player.h"
+#include "CvTime.h"
 
 typedef MPinSDK::String String;
 typedef MPinSDK::StringMap StringMap;
@@ -47,6 +48,23 @@ void HttpPlayer::SetTimeout(int seconds)
 bool HttpPlayer::Execute(Method method, const String & url)
 {
     m_response = m_recordedData.FindResponseFor(Request(method, url, m_requestData, m_context));
+
+    if (m_networkModel != NULL)
+    {
+        NetworkModel::Outcome outcome = m_networkModel->Simulate(url, m_requestData.length(), m_response.data.length(), m_response.durationMs);
+        // Rounded to the millisecond the sleep can take
+        CvShared::SleepFor(CvShared::Millisecs(static_cast<CvShared::TimeValue_t>(outcome.delayMs + 0.5)));
+
+        if (outcome.networkFailure)
+        {
+            m_response = Response(false, "Simulated network failure", 0, StringMap(), "");
+        }
+        else if (outcome.serverError)
+        {
+            m_response = Response(true, "", 503, StringMap(), "");
+        }
+    }
+
     return m_response.success;
 }
 
@@ -25,6 +25,7 @@ under the License.
 #define _TEST_HTTP_PLAYER_H_
 
 #include "http_recorded_data.h"
+#include "network_model.h"
 
 class HttpPlayer : public MPinSDK::IHttpRequest
 {
@@ -34,7 +35,8 @@ public:
     typedef HttpRecordedData::Request Request;
     typedef HttpRecordedData::Response Response;
 
-    HttpPlayer(HttpRecordedData& recordedData, const String& context) : m_recordedData(recordedData), m_context(context) {}
+    HttpPlayer(HttpRecordedData& recordedData, const String& context, NetworkModel *networkModel = NULL) :
+        m_recordedData(recordedData), m_context(context), m_networkModel(networkModel) {}
     virtual void SetHeaders(const StringMap& headers);
     virtual void SetQueryParams(const StringMap& queryParams);
     virtual void SetContent(const String& data);
@@ -49,6 +51,7 @@ private:
     String m_requestData;
     HttpRecordedData& m_recordedData;
     String m_context;
+    NetworkModel *m_networkModel;
     Response m_response;
 };
 
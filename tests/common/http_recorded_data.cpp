@@ -113,12 +113,12 @@ String HttpRecordedData::Request::GetKey() const
     return method + " " + url + " " + context;
 }
 
-HttpRecordedData::Response::Response() : success(false), httpStatus(0)
+HttpRecordedData::Response::Response() : success(false), httpStatus(0), durationMs(-1)
 {
 }
 
 HttpRecordedData::Response::Response(bool _success, const String & _error, int _httpStatus, const StringMap & _headers, const String & _data) :
-    success(_success), error(_error), httpStatus(_httpStatus), headers(_headers), data(_data)
+    success(_success), error(_error), httpStatus(_httpStatus), headers(_headers), data(_data), durationMs(-1)
 {
 }
 
@@ -127,8 +127,15 @@ HttpRecordedData::Response::Response(const json::Object & object) :
     error(((const json::String&) object["error"]).Value()),
     httpStatus(static_cast<int>(((const json::Number&) object["httpStatus"]).Value())),
     headers(object["headers"]),
-    data(((const json::String&) object["data"]).Value())
+    data(((const json::String&) object["data"]).Value()),
+    durationMs(-1)
 {
+    // Older recordings have no timing
+    json::Object::const_iterator duration = object.Find("durationMs");
+    if (duration != object.End())
+    {
+        durationMs = ((const json::Number&) duration->element).Value();
+    }
 }
 
 json::Object HttpRecordedData::Response::ToJsonObject() const
@@ -139,6 +146,10 @@ json::Object HttpRecordedData::Response::ToJsonObject() const
     object["httpStatus"] = json::Number(httpStatus);
     object["headers"] = headers.ToJsonObject();
     object["data"] = json::String(data);
+    if (durationMs >= 0)
+    {
+        object["durationMs"] = json::Number(durationMs);
+    }
     return object;
 }
 
@@ -63,6 +63,8 @@ public:
         int httpStatus;
         StringMap headers;
         String data;
+        // How long the request took when recorded, -1 if unknown
+        double durationMs;
     };
 
     HttpRecordedData();
@@ -23,6 +23,7 @@ under the License.
 
 #include "http_recorder.h"
 #include "http_recorded_data.h"
+#include "CvTime.h"
 #include <cassert>
 
 typedef MPinSDK::String String;
@@ -53,10 +54,15 @@ void HttpRecorder::SetTimeout(int seconds)
 
 bool HttpRecorder::Execute(Method method, const String & url)
 {
+    CvShared::TimeSpec start;
+    CvShared::GetCurrentTime(start);
     bool res = m_request.Execute(method, url);
+    CvShared::TimeSpec end;
+    CvShared::GetCurrentTime(end);
 
-    m_recorder.Record(Request(method, url, m_requestData, m_context),
-        Response(res, m_request.GetExecuteErrorMessage(), m_request.GetHttpStatusCode(), m_request.GetResponseHeaders(), m_request.GetResponseData()));
+    Response response(res, m_request.GetExecuteErrorMessage(), m_request.GetHttpStatusCode(), m_request.GetResponseHeaders(), m_request.GetResponseData());
+    response.durationMs = static_cast<double>((end - start).ToMicrosecs()) / 1000;
+    m_recorder.Record(Request(method, url, m_requestData, m_context), response);
 
     return res;
 }
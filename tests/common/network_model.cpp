@@ -0,0 +1,259 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+/*
+ * Network conditions simulated by the HttpPlayer - latency, bandwidth and failures per host
+ */
+
+#include "network_model.h"
+#include <math.h>
+#include <stdlib.h>
+
+typedef MPinSDK::String String;
+typedef NetworkModel::Link Link;
+typedef NetworkModel::Outcome Outcome;
+
+namespace
+{
+    const double PI = 3.14159265358979323846;
+
+    bool ParseDistribution(const String& name, NetworkModel::Distribution& distribution)
+    {
+        if (name == "fixed")
+            distribution = NetworkModel::FIXED;
+        else if (name == "uniform")
+            distribution = NetworkModel::UNIFORM;
+        else if (name == "normal")
+            distribution = NetworkModel::NORMAL;
+        else if (name == "lognormal")
+            distribution = NetworkModel::LOG_NORMAL;
+        else if (name == "recorded")
+            distribution = NetworkModel::RECORDED;
+        else
+            return false;
+        return true;
+    }
+
+    bool ParseNumber(const String& str, double& number)
+    {
+        char *end = NULL;
+        number = strtod(str.c_str(), &end);
+        return !str.empty() && *end == '\0' && number >= 0;
+    }
+}
+
+NetworkModel::Link::Link() :
+    distribution(FIXED), rttMs(0), jitterMs(0), bandwidthKbps(0), connectRoundTrips(1), failureRate(0), serverErrorRate(0)
+{
+}
+
+NetworkModel::Outcome::Outcome() : delayMs(0), networkFailure(false), serverError(false)
+{
+}
+
+NetworkModel::NetworkModel() : m_enabled(false), m_randomState(88172645463325252ULL)
+{
+    m_mutex.Create();
+}
+
+bool NetworkModel::IsEnabled() const
+{
+    return m_enabled;
+}
+
+void NetworkModel::SetDefaultLink(const Link& link)
+{
+    m_defaultLink = link;
+    m_enabled = true;
+}
+
+void NetworkModel::SetHostLink(const String& host, const Link& link)
+{
+    m_hostLinks[host] = link;
+    m_enabled = true;
+}
+
+void NetworkModel::SetSeed(unsigned long seed)
+{
+    // xorshift must not start from 0
+    m_randomState = seed != 0 ? seed : 88172645463325252ULL;
+}
+
+bool NetworkModel::Parse(const String& spec, OUT String& error)
+{
+    Link defaultLink;
+    LinkMap hostLinks;
+
+    size_t sectionStart = 0;
+    while (sectionStart <= spec.length())
+    {
+        size_t sectionEnd = spec.find(';', sectionStart);
+        if (sectionEnd == String::npos)
+        {
+            sectionEnd = spec.length();
+        }
+        String section(spec, sectionStart, sectionEnd - sectionStart);
+        sectionStart = sectionEnd + 1;
+
+        // Host sections start from the default link
+        Link *link = &defaultLink;
+        size_t at = section.find('@');
+        if (at != String::npos)
+        {
+            String host(section, 0, at);
+            link = &hostLinks.insert(std::make_pair(host, defaultLink)).first->second;
+            section = String(section, at + 1);
+        }
+
+        size_t pairStart = 0;
+        while (pairStart < section.length())
+        {
+            size_t pairEnd = section.find(',', pairStart);
+            if (pairEnd == String::npos)
+            {
+                pairEnd = section.length();
+            }
+            String pair(section, pairStart, pairEnd - pairStart);
+            pairStart = pairEnd + 1;
+
+            size_t eq = pair.find('=');
+            String key(pair, 0, eq);
+            String value = (eq != String::npos) ? String(pair, eq + 1) : String();
+            double number = 0;
+            bool valid = (key == "distribution") ? ParseDistribution(value, link->distribution) : ParseNumber(value, number);
+            if (!valid)
+            {
+                error = "Invalid value of '" + key + "' in network spec";
+                return false;
+            }
+
+            if (key == "rtt")
+                link->rttMs = number;
+            else if (key == "jitter")
+                link->jitterMs = number;
+            else if (key == "bandwidth")
+                link->bandwidthKbps = number;
+            else if (key == "connect")
+                link->connectRoundTrips = static_cast<int>(number);
+            else if (key == "failures")
+                link->failureRate = number;
+            else if (key == "errors")
+                link->serverErrorRate = number;
+            else if (key == "seed")
+                SetSeed(static_cast<unsigned long>(number));
+            else if (key != "distribution")
+            {
+                error = "Unknown key '" + key + "' in network spec";
+                return false;
+            }
+        }
+    }
+
+    m_defaultLink = defaultLink;
+    m_hostLinks = hostLinks;
+    m_enabled = true;
+    return true;
+}
+
+Outcome NetworkModel::Simulate(const String& url, size_t bytesSent, size_t bytesReceived, double recordedMs)
+{
+    CvShared::CvMutexLock lock(m_mutex);
+
+    const Link& link = GetLink(url);
+    Outcome outcome;
+
+    if (link.distribution == RECORDED && recordedMs >= 0)
+    {
+        // The recorded time already includes the connection setup and the transfer
+        outcome.delayMs = recordedMs;
+    }
+    else
+    {
+        // Every round trip draws its own latency
+        for (int i = 0; i <= link.connectRoundTrips; ++i)
+        {
+            outcome.delayMs += SampleRoundTrip(link);
+        }
+        if (link.bandwidthKbps > 0)
+        {
+            outcome.delayMs += static_cast<double>(bytesSent + bytesReceived) * 8 / link.bandwidthKbps;
+        }
+    }
+
+    double roll = Uniform();
+    outcome.networkFailure = roll < link.failureRate;
+    outcome.serverError = !outcome.networkFailure && roll < link.failureRate + link.serverErrorRate;
+    return outcome;
+}
+
+const Link& NetworkModel::GetLink(const String& url) const
+{
+    size_t hostStart = url.find("://");
+    hostStart = (hostStart == String::npos) ? 0 : hostStart + 3;
+    String host(url, hostStart, url.find('/', hostStart) - hostStart);
+
+    LinkMap::const_iterator i = m_hostLinks.find(host);
+    return (i != m_hostLinks.end()) ? i->second : m_defaultLink;
+}
+
+double NetworkModel::SampleRoundTrip(const Link& link)
+{
+    double rtt = link.rttMs;
+    switch (link.distribution)
+    {
+    case UNIFORM:
+        rtt += (2 * Uniform() - 1) * link.jitterMs;
+        break;
+    case NORMAL:
+        rtt += Normal() * link.jitterMs;
+        break;
+    case LOG_NORMAL:
+        // With rttMs as the mean and jitterMs as the standard deviation - the long tail of real networks
+        if (link.rttMs > 0)
+        {
+            double ratio = link.jitterMs / link.rttMs;
+            double sigma2 = log(1 + ratio * ratio);
+            rtt = exp(log(link.rttMs) - sigma2 / 2 + sqrt(sigma2) * Normal());
+        }
+        break;
+    case FIXED:
+    case RECORDED:
+    default:
+        break;
+    }
+    return (rtt > 0) ? rtt : 0;
+}
+
+double NetworkModel::Uniform()
+{
+    // xorshift64*, the runs are reproducible for a given seed
+    m_randomState ^= m_randomState >> 12;
+    m_randomState ^= m_randomState << 25;
+    m_randomState ^= m_randomState >> 27;
+    unsigned long long value = m_randomState * 2685821657736338717ULL;
+    return static_cast<double>(value >> 11) / 9007199254740992.0;
+}
+
+double NetworkModel::Normal()
+{
+    // Box-Muller
+    double u1 = Uniform();
+    double u2 = Uniform();
+    return sqrt(-2 * log(u1 > 0 ? u1 : 1e-300)) * cos(2 * PI * u2);
+}
@@ -0,0 +1,95 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+/*
+ * Network conditions simulated by the HttpPlayer - latency, bandwidth and failures per host
+ */
+
+#ifndef _TEST_NETWORK_MODEL_H_
+#define _TEST_NETWORK_MODEL_H_
+
+#include "mpin_sdk.h"
+#include "CvMutex.h"
+
+class NetworkModel
+{
+public:
+    typedef MPinSDK::String String;
+
+    enum Distribution { FIXED, UNIFORM, NORMAL, LOG_NORMAL, RECORDED };
+
+    class Link
+    {
+    public:
+        Link();
+
+        // Round trip time and its spread around rttMs, in milliseconds
+        Distribution distribution;
+        double rttMs;
+        double jitterMs;
+        // 0 for unlimited
+        double bandwidthKbps;
+        // Round trips of the connection setup, paid by every request as the SDK does not reuse connections
+        int connectRoundTrips;
+        // Probabilities of a request failing without response and of the server answering with 503
+        double failureRate;
+        double serverErrorRate;
+    };
+
+    class Outcome
+    {
+    public:
+        Outcome();
+
+        double delayMs;
+        bool networkFailure;
+        bool serverError;
+    };
+
+    NetworkModel();
+    bool IsEnabled() const;
+    void SetDefaultLink(const Link& link);
+    void SetHostLink(const String& host, const Link& link);
+    void SetSeed(unsigned long seed);
+
+    // Parses a spec like "rtt=50,jitter=10,distribution=normal;10.10.40.62:8005@rtt=120,bandwidth=512". The first
+    // section sets the default link and the "host@" sections override it for a host. The keys are the Link members:
+    // distribution (fixed, uniform, normal, lognormal or recorded), rtt, jitter, bandwidth, connect, failures, errors,
+    // and also seed.
+    bool Parse(const String& spec, OUT String& error);
+
+    // Draws the conditions of a request. recordedMs is the time the request took when recorded, -1 if unknown.
+    Outcome Simulate(const String& url, size_t bytesSent, size_t bytesReceived, double recordedMs);
+
+private:
+    const Link& GetLink(const String& url) const;
+    double SampleRoundTrip(const Link& link);
+    double Uniform();
+    double Normal();
+
+    typedef std::map<String, Link> LinkMap;
+
+    bool m_enabled;
+    Link m_defaultLink;
+    LinkMap m_hostLinks;
+    unsigned long long m_randomState;
+    CvShared::CvMutex m_mutex;
+};
+
+#endif // _TEST_NETWORK_MODEL_H_
@@ -71,7 +71,8 @@ IHttpRequest * TestContext::CreateHttpRequest() const
     case MODE_MAKE_REAL_REQUESTS:
         return new HttpRequest();
     case MODE_USE_RECORDED_REQUESTS:
-        return new HttpPlayer(const_cast<HttpRecordedData&>(m_recordedData), GetRequestContextData());
+        return new HttpPlayer(const_cast<HttpRecordedData&>(m_recordedData), GetRequestContextData(),
+            m_networkModel.IsEnabled() ? const_cast<NetworkModel *>(&m_networkModel) : NULL);
     case MODE_RECORD_REAL_REQUESTS:
         return new HttpRecorder(const_cast<HttpRecordedData&>(m_recordedData), GetRequestContextData());
     default:
@@ -95,6 +96,11 @@ void TestContext::SetAdditionalContextData(const String & additionalContextData)
     m_additionalContextData = additionalContextData;
 }
 
+NetworkModel& TestContext::GetNetworkModel()
+{
+    return m_networkModel;
+}
+
 String TestContext::GetRequestContextData() const
 {
     return m_requestContextData + (m_autoContextData ? ("@" + m_autoContextData->Get()) : "") + m_additionalContextData;
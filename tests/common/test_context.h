@@ -26,6 +26,7 @@ under the License.
 
 #include "mpin_sdk.h"
 #include "http_recorded_data.h"
+#include "network_model.h"
 
 class TestContext : public MPinSDK::IContext
 {
@@ -50,6 +51,8 @@ public:
     virtual void ReleaseHttpRequest(IN IHttpRequest *request) const;
     void SetRequestContextData(const String& requestContextData);
     void SetAdditionalContextData(const String& additionalContextData);
+    // Conditions the recorded requests are replayed with, instantly by default
+    NetworkModel& GetNetworkModel();
 
 protected:
     String GetRequestContextData() const;
@@ -61,6 +64,7 @@ protected:
     String m_requestContextData;
     const AutoContextData *m_autoContextData;
     String m_additionalContextData;
+    NetworkModel m_networkModel;
 };
 
 #endif // _TEST_CONTEXT_H_
@@ -0,0 +1,1079 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+/*
+ * Known answer and consistency tests of the crypto library, without the SDK around it. The accelerated code paths
+ * are checked against the portable ones by limiting CPU_features().
+ */
+
+extern "C"
+{
+#include "crypto/mpin.h"
+}
+
+#define BOOST_TEST_MODULE Crypto testcases
+#include "boost/test/included/unit_test.hpp"
+
+#include <string>
+#include <set>
+#include <string.h>
+#include <stdio.h>
+
+static std::string ToHex(const char *data, int len)
+{
+    std::string hex;
+    char byte[3];
+    for(int i = 0; i < len; ++i)
+    {
+        sprintf(byte, "%02x", (unsigned char) data[i]);
+        hex += byte;
+    }
+    return hex;
+}
+
+static std::string ToHex(const octet& oct)
+{
+    return ToHex(oct.val, oct.len);
+}
+
+static std::string ToHex(const std::string& str)
+{
+    return ToHex(str.data(), (int) str.size());
+}
+
+static std::string FromHex(const char *hex)
+{
+    std::string bytes;
+    for(size_t i = 0; hex[i] != '\0' && hex[i + 1] != '\0'; i += 2)
+    {
+        unsigned int byte = 0;
+        sscanf(&hex[i], "%2x", &byte);
+        bytes += (char) byte;
+    }
+    return bytes;
+}
+
+// Octet over a buffer of its own
+template<int N>
+class TestOctet : public octet
+{
+public:
+    TestOctet()
+    {
+        memset(m_buf, 0, sizeof(m_buf));
+        len = 0;
+        max = N;
+        val = m_buf;
+    }
+
+private:
+    char m_buf[N];
+};
+
+// Reproducible test data, xorshift32
+class TestData
+{
+public:
+    TestData(unsigned int seed) : m_state(seed) {}
+
+    unsigned int Next()
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return m_state;
+    }
+
+    void Fill(char *buf, int len)
+    {
+        for(int i = 0; i < len; ++i)
+        {
+            buf[i] = (char) Next();
+        }
+    }
+
+private:
+    unsigned int m_state;
+};
+
+// Passes over the same checks, the first one with whatever the CPU offers and the second one with the portable code
+static const int PASSES = 2;
+
+static void LimitCpuFeatures(int pass)
+{
+    CPU_limit((pass == 0) ? -1 : 0);
+}
+
+static std::string Sha256(const char *data, int len)
+{
+    hash sh;
+    char digest[32];
+    HASH_init(&sh);
+    HASH_update(&sh, data, len);
+    HASH_hash(&sh, digest);
+    return ToHex(digest, sizeof(digest));
+}
+
+static std::string Sha256(const std::string& str)
+{
+    return Sha256(str.data(), (int) str.size());
+}
+
+BOOST_AUTO_TEST_CASE(testHash)
+{
+    BOOST_MESSAGE("Starting testHash...");
+
+    const std::string million(1000000, 'a');
+    for(int pass = 0; pass < PASSES; ++pass)
+    {
+        LimitCpuFeatures(pass);
+
+        // FIPS 180-2 examples
+        BOOST_CHECK_EQUAL(Sha256(""), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+        BOOST_CHECK_EQUAL(Sha256("abc"), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+        BOOST_CHECK_EQUAL(Sha256("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+            "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+        BOOST_CHECK_EQUAL(Sha256(million), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+    }
+    CPU_limit(-1);
+
+    BOOST_MESSAGE("    testHash finished");
+}
+
+BOOST_AUTO_TEST_CASE(testHashMulti)
+{
+    BOOST_MESSAGE("Starting testHashMulti...");
+
+    const int COUNT = 19;
+    char msg[COUNT][200];
+    char digests[COUNT][32];
+    char *msgs[COUNT];
+    char *digestPtrs[COUNT];
+    int lens[COUNT];
+
+    TestData data(1);
+    for(int i = 0; i < COUNT; ++i)
+    {
+        data.Fill(msg[i], sizeof(msg[i]));
+        msgs[i] = msg[i];
+        digestPtrs[i] = digests[i];
+    }
+
+    strcpy(msg[0], "abc");
+    for(int pass = 0; pass < PASSES; ++pass)
+    {
+        LimitCpuFeatures(pass);
+
+        // Every batch size up to more than two full sets of lanes, with lengths around the padding boundaries
+        for(int n = 1; n <= COUNT; ++n)
+        {
+            for(int i = 0; i < n; ++i)
+            {
+                lens[i] = (i == 0) ? 3 : (int) ((n * 37 + i * 53) % sizeof(msg[i]));
+            }
+            if(n > 1)
+            {
+                lens[n - 1] = (n % 2) ? 55 : 56;
+            }
+
+            memset(digests, 0, sizeof(digests));
+            HASH_multi(n, msgs, lens, digestPtrs);
+
+            BOOST_CHECK_EQUAL(ToHex(digests[0], 32), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+            for(int i = 0; i < n; ++i)
+            {
+                BOOST_CHECK_EQUAL(ToHex(digests[i], 32), Sha256(msg[i], lens[i]));
+            }
+        }
+    }
+    CPU_limit(-1);
+
+    BOOST_MESSAGE("    testHashMulti finished");
+}
+
+BOOST_AUTO_TEST_CASE(testClientPermits)
+{
+    BOOST_MESSAGE("Starting testClientPermits...");
+
+    // More than a batch, and one id longer than a hash, which the batch hashes on its own
+    const int COUNT = MPIN_BATCH_SIZE + 3;
+    TestOctet<PGS> secret;
+    TestOctet<2 * PFS> ids[COUNT];
+    TestOctet<2 * PFS + 1> permits[COUNT];
+    octet *idPtrs[COUNT];
+    octet *permitPtrs[COUNT];
+
+    TestData data(2);
+    data.Fill(secret.val, PGS);
+    secret.val[0] = 0x0f;
+    secret.len = PGS;
+    for(int i = 0; i < COUNT; ++i)
+    {
+        char id[64];
+        sprintf(id, "{\"userID\":\"user%d@example.com\"}", i);
+        TestOctet<64> clientId;
+        OCT_jstring(&clientId, id);
+        MPIN_HASH_ID(&clientId, &ids[i]);
+        idPtrs[i] = &ids[i];
+        permitPtrs[i] = &permits[i];
+    }
+    OCT_jbytes(&ids[MPIN_BATCH_SIZE + 1], (char *) "longer than a hash", 18);
+
+    for(int pass = 0; pass < PASSES; ++pass)
+    {
+        LimitCpuFeatures(pass);
+
+        BOOST_CHECK_EQUAL(MPIN_GET_CLIENT_PERMITS(16000, &secret, COUNT, idPtrs, permitPtrs), 0);
+        for(int i = 0; i < COUNT; ++i)
+        {
+            TestOctet<2 * PFS + 1> permit;
+            MPIN_GET_CLIENT_PERMIT(16000, &secret, &ids[i], &permit);
+            BOOST_CHECK_EQUAL(ToHex(permits[i]), ToHex(permit));
+        }
+    }
+    CPU_limit(-1);
+
+    BOOST_MESSAGE("    testClientPermits finished");
+}
+
+BOOST_AUTO_TEST_CASE(testMapToG1)
+{
+#ifdef USE_SW_MAP
+    BOOST_MESSAGE("Starting testMapToG1 with the Shallue-van de Woestijne map...");
+#else
+    BOOST_MESSAGE("Starting testMapToG1...");
+#endif
+
+    std::set<std::string> points;
+    for(int i = 0; i < 64; ++i)
+    {
+        char id[64];
+        sprintf(id, "{\"userID\":\"user%d@example.com\"}", i);
+        TestOctet<64> clientId;
+        OCT_jstring(&clientId, id);
+
+        TestOctet<2 * PFS + 1> hcid, htcid, again;
+        MPIN_MAP_CLIENT_ID(16000 + i, &clientId, &hcid, &htcid);
+
+        // Points on the curve, the same every time and a different one for every input
+        ECP p;
+        BOOST_CHECK(ECP_fromOctet(&p, &hcid));
+        BOOST_CHECK(ECP_fromOctet(&p, &htcid));
+        MPIN_MAP_CLIENT_ID(16000 + i, &clientId, &again, NULL);
+        BOOST_CHECK_EQUAL(ToHex(again), ToHex(hcid));
+        BOOST_CHECK(points.insert(ToHex(hcid)).second);
+        BOOST_CHECK(points.insert(ToHex(htcid)).second);
+    }
+
+#ifndef USE_SW_MAP
+    // Try-and-increment, as the library has always mapped identities
+    TestOctet<64> clientId;
+    TestOctet<2 * PFS + 1> hid, htid;
+    OCT_jstring(&clientId, (char *) "{\"userID\":\"testuser@example.com\"}");
+    MPIN_SERVER_1(16000, &clientId, &hid, &htid);
+    BOOST_CHECK_EQUAL(ToHex(hid), "041ce2adc01c7908e218cf4b8593d116affa8d8e8ffc7bf2788e394413cca65e"
+        "ba154bafce3816fbd5ccea942d4d2a011f91d7da129a49cdd75ff9f146e4385fc4");
+    BOOST_CHECK_EQUAL(ToHex(htid), "041c2945a008435499600335f191c7eb5fdad8ca4bb4e76330cc3acb45886727"
+        "480b760a77270cfe56f5db48b8b436045f696768b7d3f9e4f2219859fdbd55acfb");
+#endif
+
+    BOOST_MESSAGE("    testMapToG1 finished");
+}
+
+// The generators of G1 and G2
+static void Generators(ECP *g1, ECP2 *g2)
+{
+    BIG x, y;
+    BIG_rcopy(x, CURVE_Gx);
+    BIG_rcopy(y, CURVE_Gy);
+    ECP_set(g1, x, y);
+
+    FP2 qx, qy;
+    BIG_rcopy(qx.a, CURVE_Pxa); FP_nres(qx.a);
+    BIG_rcopy(qx.b, CURVE_Pxb); FP_nres(qx.b);
+    BIG_rcopy(qy.a, CURVE_Pya); FP_nres(qy.a);
+    BIG_rcopy(qy.b, CURVE_Pyb); FP_nres(qy.b);
+    ECP2_set(g2, &qx, &qy);
+}
+
+static std::string ToHex(FP12 *f)
+{
+    TestOctet<12 * PFS> oct;
+    FP12_toOctet(&oct, f);
+    return ToHex(oct);
+}
+
+BOOST_AUTO_TEST_CASE(testCompow)
+{
+    BOOST_MESSAGE("Starting testCompow...");
+
+    // e(G2,G1), which is in the cyclotomic subgroup, as the final exponentiation leaves every pairing
+    ECP g1;
+    ECP2 g2;
+    Generators(&g1, &g2);
+    FP12 g;
+    PAIR_ate(&g, &g2, &g1);
+    PAIR_fexp(&g);
+
+    // Small exponents, the ones of the final exponentiation and random ones that need several batches of squarings
+    const int COUNT = 40;
+    BIG e[COUNT];
+    int n = 0;
+    for(int i = 0; i < 20; ++i)
+    {
+        BIG_zero(e[n]);
+        BIG_inc(e[n++], i);
+    }
+    BIG_rcopy(e[n++], CURVE_Bnx);
+    BIG_rcopy(e[n], CURVE_Order);
+    BIG_dec(e[n++], 1);
+
+    BIG order;
+    BIG_rcopy(order, CURVE_Order);
+    TestData data(4);
+    while(n < COUNT)
+    {
+        char bytes[MODBYTES];
+        data.Fill(bytes, MODBYTES);
+        BIG_fromBytes(e[n], bytes);
+        BIG_mod(e[n++], order);
+    }
+
+    for(int i = 0; i < COUNT; ++i)
+    {
+        FP12 r1, r2;
+        FP12_compow(&r1, &g, e[i]);
+        FP12_pow(&r2, &g, e[i]);
+        BOOST_CHECK_EQUAL(ToHex(&r1), ToHex(&r2));
+    }
+
+    // g has the order of the group
+    FP12 one, r;
+    FP12_one(&one);
+    FP12_compow(&r, &g, order);
+    BOOST_CHECK(FP12_equals(&r, &one));
+    BOOST_CHECK(!FP12_equals(&g, &one));
+
+    BOOST_MESSAGE("    testCompow finished");
+}
+
+static std::string ToHex(FP4 *f)
+{
+    TestOctet<4 * MODBYTES> oct;
+    BIG *parts[4] = { &f->a.a, &f->a.b, &f->b.a, &f->b.b };
+    FP4_reduce(f);
+    for(int i = 0; i < 4; ++i)
+    {
+        BIG t;
+        BIG_copy(t, *parts[i]);
+        FP_redc(t);
+        BIG_toBytes(oct.val + i * MODBYTES, t);
+    }
+    oct.len = 4 * MODBYTES;
+    return ToHex(oct);
+}
+
+static std::string Sha256(FP12 *f)
+{
+    TestOctet<12 * PFS> oct;
+    FP12_toOctet(&oct, f);
+    return Sha256(oct.val, oct.len);
+}
+
+BOOST_AUTO_TEST_CASE(testPairing)
+{
+    BOOST_MESSAGE("Starting testPairing...");
+
+    // Known answers of the library before the lazy reduction of FP4 products, the same with 32 and 64-bit chunks
+    ECP g1;
+    ECP2 g2;
+    Generators(&g1, &g2);
+    FP12 g;
+    PAIR_ate(&g, &g2, &g1);
+    BOOST_CHECK_EQUAL(Sha256(&g), "6b27ee78d612185942515ba19b529d454e10ae6fd8c31bb6deb690e30d27a1f4");
+    PAIR_fexp(&g);
+    BOOST_CHECK_EQUAL(Sha256(&g), "7c34dd36148059dfa12b69ae84001e144c0599b1d04d50ab303fd5700bd8016a");
+
+    FP4 f;
+    FP4_mul(&f, &g.a, &g.b);
+    BOOST_CHECK_EQUAL(ToHex(&f), "2067775f5c2249f0fc359be7f20ecb5307f5851c1fd666fbae8abee5352fabb6"
+        "0bc1979f06c8adfa46008d923c477cb2b16769e77d97957a70cc253ad2cdf4fd"
+        "0fb47369651ef07490bcafda07ea2fd9348fb612f229fc413086118c7e4d5d89"
+        "1b7c9dae95fe6055c6a0de3765edcd8ce581b2140c8d19544b7fa4665ea09a5f");
+    FP4_sqr(&f, &g.c);
+    BOOST_CHECK_EQUAL(ToHex(&f), "142e6198c6bd88e7a26295d220afc4b2d859add7540ba4dd188f59d19436bd06"
+        "1fa73ddb51fbd157e3e8cb65fdf6b9fa2db87844cd74f4f97588e3e18f75e085"
+        "19dcbf469548322b47298ab54b14cfcde581f49d2267025949b9b027ce35e543"
+        "204bbbdad0e45e35697e3673cf39b3a8c24a9c4034a696214897408427aa7e7f");
+
+    FP12 h;
+    FP12_copy(&h, &g);
+    FP12_mul(&h, &g);
+    BOOST_CHECK_EQUAL(Sha256(&h), "329895570fc3702331c117aee766676dbe3179037965de5a797303d8b19e34da");
+    BIG e;
+    BIG_zero(e);
+    BIG_inc(e, 12345);
+    FP12_pow(&h, &g, e);
+    BOOST_CHECK_EQUAL(Sha256(&h), "d640fbd0ea744882cd32051b6235e1a74816815a75b7c8621193e0d48e1aaed0");
+
+    // Bilinearity - e(G2,12345.G1)=e(12345.G2,G1)=e(G2,G1)^12345
+    ECP p1;
+    ECP2 p2;
+    FP12 r;
+    ECP_copy(&p1, &g1);
+    PAIR_G1mul(&p1, e);
+    PAIR_ate(&r, &g2, &p1);
+    PAIR_fexp(&r);
+    BOOST_CHECK_EQUAL(Sha256(&r), Sha256(&h));
+    ECP2_copy(&p2, &g2);
+    PAIR_G2mul(&p2, e);
+    PAIR_ate(&r, &p2, &g1);
+    PAIR_fexp(&r);
+    BOOST_CHECK_EQUAL(Sha256(&r), Sha256(&h));
+
+    BOOST_MESSAGE("    testPairing finished");
+}
+
+BOOST_AUTO_TEST_CASE(testMpinFlow)
+{
+    BOOST_MESSAGE("Starting testMpinFlow...");
+
+    // The client and server steps of an authentication with a time permit, with fixed secrets and random values
+    const int date = 16000;
+    const int pin = 1234;
+    TestOctet<PGS> secret, x, y;
+    TestData data(5);
+    data.Fill(secret.val, PGS);
+    data.Fill(x.val, PGS);
+    data.Fill(y.val, PGS);
+    secret.val[0] = x.val[0] = y.val[0] = 0x0f;
+    secret.len = x.len = y.len = PGS;
+
+    TestOctet<64> clientId;
+    TestOctet<HASH_BYTES> hashedId;
+    OCT_jstring(&clientId, (char *) "{\"userID\":\"testuser@example.com\"}");
+    MPIN_HASH_ID(&clientId, &hashedId);
+
+    TestOctet<2 * PFS + 1> token, permit;
+    TestOctet<4 * PFS> serverSecret;
+    BOOST_CHECK_EQUAL(MPIN_GET_CLIENT_SECRET(&secret, &hashedId, &token), 0);
+    BOOST_CHECK_EQUAL(MPIN_GET_CLIENT_PERMIT(date, &secret, &hashedId, &permit), 0);
+    BOOST_CHECK_EQUAL(MPIN_GET_SERVER_SECRET(&secret, &serverSecret), 0);
+    BOOST_CHECK_EQUAL(MPIN_EXTRACT_PIN(&clientId, pin, &token), 0);
+
+    for(int attempt = 0; attempt < 2; ++attempt)
+    {
+        // The second attempt is with a PIN that is wrong by 3
+        TestOctet<2 * PFS + 1> sec, u, ut, hid, htid;
+        BOOST_CHECK_EQUAL(MPIN_CLIENT_1(date, &clientId, NULL, &x, pin + 3 * attempt, &token, &sec, &u, &ut, &permit), 0);
+        MPIN_SERVER_1(date, &clientId, &hid, &htid);
+        BOOST_CHECK_EQUAL(MPIN_CLIENT_2(&x, &y, &sec), 0);
+
+        TestOctet<12 * PFS> e, f;
+        int res = MPIN_SERVER_2(date, &hid, &htid, &y, &serverSecret, &u, &ut, &sec, &e, &f);
+        if(attempt == 0)
+        {
+            BOOST_CHECK_EQUAL(res, 0);
+        }
+        else
+        {
+            BOOST_CHECK_EQUAL(res, MPIN_BAD_PIN);
+            BOOST_CHECK_EQUAL(MPIN_KANGAROO(&e, &f), 3);
+        }
+    }
+
+    BOOST_MESSAGE("    testMpinFlow finished");
+}
+
+// A random number below the group order
+static void RandomNumber(TestData& data, octet *num)
+{
+    data.Fill(num->val, PGS);
+    num->val[0] = 0x0f;
+    num->len = PGS;
+}
+
+// What MPIN_SERVER_2 takes from a client authenticating with a time permit, and from MPIN_SERVER_1
+struct TestAuthentication
+{
+    TestOctet<2 * PFS + 1> hid, htid, u, ut, v;
+    TestOctet<PGS> y;
+};
+
+static void Authenticate(int date, octet *secret, int user, int pinError, TestData& data, TestAuthentication& auth)
+{
+    const int pin = 1234;
+    char id[64];
+    sprintf(id, "{\"userID\":\"user%d@example.com\"}", user);
+    TestOctet<64> clientId;
+    TestOctet<HASH_BYTES> hashedId;
+    OCT_jstring(&clientId, id);
+    MPIN_HASH_ID(&clientId, &hashedId);
+
+    TestOctet<2 * PFS + 1> token, permit;
+    BOOST_CHECK_EQUAL(MPIN_GET_CLIENT_SECRET(secret, &hashedId, &token), 0);
+    BOOST_CHECK_EQUAL(MPIN_GET_CLIENT_PERMIT(date, secret, &hashedId, &permit), 0);
+    BOOST_CHECK_EQUAL(MPIN_EXTRACT_PIN(&clientId, pin, &token), 0);
+
+    TestOctet<PGS> x;
+    RandomNumber(data, &x);
+    RandomNumber(data, &auth.y);
+    BOOST_CHECK_EQUAL(MPIN_CLIENT_1(date, &clientId, NULL, &x, pin + pinError, &token, &auth.v, &auth.u, &auth.ut, &permit), 0);
+    MPIN_SERVER_1(date, &clientId, &auth.hid, &auth.htid);
+    BOOST_CHECK_EQUAL(MPIN_CLIENT_2(&x, &auth.y, &auth.v), 0);
+}
+
+BOOST_AUTO_TEST_CASE(testServer2Batch)
+{
+    BOOST_MESSAGE("Starting testServer2Batch...");
+
+    // Three groups of MPIN_BATCH_SIZE clients - wrong PINs in the first two, an invalid V in the first one and
+    // a last group in which every client fails
+    const int date = 16000;
+    const int COUNT = 2 * MPIN_BATCH_SIZE + 4;
+    const int firstBad = 3;
+    const int badV = 9;
+
+    TestData data(6);
+    TestOctet<PGS> secret;
+    TestOctet<4 * PFS> serverSecret;
+    RandomNumber(data, &secret);
+    BOOST_CHECK_EQUAL(MPIN_GET_SERVER_SECRET(&secret, &serverSecret), 0);
+
+    TestAuthentication auth[COUNT];
+    octet *hid[COUNT], *htid[COUNT], *y[COUNT], *u[COUNT], *ut[COUNT], *v[COUNT];
+    int expected[COUNT];
+    for(int i = 0; i < COUNT; ++i)
+    {
+        bool badPin = (i == firstBad || i == MPIN_BATCH_SIZE + 7 || i >= 2 * MPIN_BATCH_SIZE);
+        Authenticate(date, &secret, i, badPin ? i : 0, data, auth[i]);
+        if(i == badV)
+        {
+            // y+1 instead of y, which is not on the curve
+            auth[i].v.val[2 * PFS] ^= 1;
+        }
+
+        hid[i] = &auth[i].hid;
+        htid[i] = &auth[i].htid;
+        y[i] = &auth[i].y;
+        u[i] = &auth[i].u;
+        ut[i] = &auth[i].ut;
+        v[i] = &auth[i].v;
+        expected[i] = MPIN_SERVER_2(date, hid[i], htid[i], y[i], &serverSecret, u[i], ut[i], v[i], NULL, NULL);
+        BOOST_CHECK_EQUAL(expected[i], badPin ? MPIN_BAD_PIN : (i == badV) ? MPIN_INVALID_POINT : 0);
+    }
+
+    char seed[32];
+    data.Fill(seed, sizeof(seed));
+    csprng rng;
+    RAND_seed(&rng, sizeof(seed), seed);
+
+    // With the random multipliers, which need the failures to be found by bisection, and with a pairing per client
+    for(int pass = 0; pass < 2; ++pass)
+    {
+        csprng *rngPtr = (pass == 0) ? &rng : NULL;
+
+        int res[COUNT];
+        memset(res, 0x55, sizeof(res));
+        BOOST_CHECK_EQUAL(MPIN_SERVER_2_BATCH(date, COUNT, rngPtr, hid, htid, y, &serverSecret, u, ut, v, res),
+            expected[firstBad]);
+        for(int i = 0; i < COUNT; ++i)
+        {
+            BOOST_CHECK_EQUAL(res[i], expected[i]);
+        }
+
+        // The valid clients between the invalid V and the wrong PIN of the second group, which all pass
+        const int first = badV + 1;
+        const int n = MPIN_BATCH_SIZE + 7 - first;
+        memset(res, 0x55, sizeof(res));
+        BOOST_CHECK_EQUAL(MPIN_SERVER_2_BATCH(date, n, rngPtr, &hid[first], &htid[first], &y[first], &serverSecret,
+            &u[first], &ut[first], &v[first], res), 0);
+        for(int i = 0; i < n; ++i)
+        {
+            BOOST_CHECK_EQUAL(res[i], 0);
+        }
+    }
+    RAND_clean(&rng);
+
+    BOOST_MESSAGE("    testServer2Batch finished");
+}
+
+// The entry of the point cache that holds hid, or -1 if there is none
+static int FindCachedPoint(const mpin_point_cache& cache, const octet& hid)
+{
+    for(int i = 0; i < MPIN_POINT_CACHE_SIZE; ++i)
+    {
+        const mpin_point_entry& e = cache.entry[i];
+        if(e.stamp != 0 && memcmp(e.hid, hid.val, hid.len) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+BOOST_AUTO_TEST_CASE(testPointCache)
+{
+    BOOST_MESSAGE("Starting testPointCache...");
+
+    // The cached server step 1 and the client step 1 from precomputed points give what the uncached ones give
+    const int date = 16000;
+    const int USERS = MPIN_POINT_CACHE_SIZE + 8;
+
+    TestData data(7);
+    TestOctet<PGS> secret;
+    RandomNumber(data, &secret);
+
+    mpin_point_cache cache;
+    MPIN_INIT_POINT_CACHE(&cache);
+
+    TestOctet<2 * PFS + 1> hid[USERS];
+    for(int i = 0; i < USERS; ++i)
+    {
+        char id[64];
+        sprintf(id, "{\"userID\":\"user%d@example.com\"}", i);
+        TestOctet<64> clientId;
+        TestOctet<HASH_BYTES> hashedId;
+        OCT_jstring(&clientId, id);
+        MPIN_HASH_ID(&clientId, &hashedId);
+
+        TestOctet<2 * PFS + 1> htid, cachedHid, cachedHtid;
+        MPIN_SERVER_1(date, &clientId, &hid[i], &htid);
+        MPIN_SERVER_1_CACHED(&cache, date, &clientId, &cachedHid, &cachedHtid);
+        BOOST_CHECK_EQUAL(ToHex(cachedHid), ToHex(hid[i]));
+        BOOST_CHECK_EQUAL(ToHex(cachedHtid), ToHex(htid));
+
+        // A hit, for the first user every time, so that it is never the least recently used one
+        TestOctet<64> firstId;
+        OCT_jstring(&firstId, (char *) "{\"userID\":\"user0@example.com\"}");
+        MPIN_SERVER_1_CACHED(&cache, date, &firstId, &cachedHid, &cachedHtid);
+        BOOST_CHECK_EQUAL(ToHex(cachedHid), ToHex(hid[0]));
+
+        // Another date is another entry, without a time permit point for date 0
+        if(i == 1)
+        {
+            TestOctet<2 * PFS + 1> hid0, hid0Cached, unused;
+            MPIN_SERVER_1(0, &clientId, &hid0, &unused);
+            MPIN_SERVER_1_CACHED(&cache, 0, &clientId, &hid0Cached, &unused);
+            BOOST_CHECK_EQUAL(ToHex(hid0Cached), ToHex(hid0));
+            BOOST_CHECK_EQUAL(unused.len, 0);
+        }
+
+        TestOctet<2 * PFS + 1> token, permit, mappedId, mappedTid;
+        BOOST_CHECK_EQUAL(MPIN_GET_CLIENT_SECRET(&secret, &hashedId, &token), 0);
+        BOOST_CHECK_EQUAL(MPIN_GET_CLIENT_PERMIT(date, &secret, &hashedId, &permit), 0);
+        MPIN_MAP_CLIENT_ID(date, &clientId, &mappedId, &mappedTid);
+        BOOST_CHECK_EQUAL(ToHex(mappedId), ToHex(hid[i]));
+
+        TestOctet<PGS> x;
+        RandomNumber(data, &x);
+        for(int d = 0; d <= date; d += date)
+        {
+            TestOctet<2 * PFS + 1> v, u, ut, vPrecomp, uPrecomp, utPrecomp;
+            BOOST_CHECK_EQUAL(MPIN_CLIENT_1(d, &clientId, NULL, &x, 1234, &token, &v, &u, &ut, &permit), 0);
+            BOOST_CHECK_EQUAL(MPIN_CLIENT_1_PRECOMP(d, &mappedId, &mappedTid, NULL, &x, 1234, &token, &vPrecomp,
+                &uPrecomp, &utPrecomp, &permit), 0);
+            BOOST_CHECK_EQUAL(ToHex(vPrecomp), ToHex(v));
+            BOOST_CHECK_EQUAL(ToHex(uPrecomp), ToHex(u));
+            BOOST_CHECK_EQUAL(ToHex(utPrecomp), ToHex(ut));
+        }
+    }
+
+    // Left are the first user, which every step used, and the last MPIN_POINT_CACHE_SIZE - 1 users
+    BOOST_CHECK(FindCachedPoint(cache, hid[0]) >= 0);
+    for(int i = 1; i < USERS; ++i)
+    {
+        BOOST_CHECK_EQUAL(FindCachedPoint(cache, hid[i]) >= 0, i > USERS - MPIN_POINT_CACHE_SIZE);
+    }
+
+    // The evicted ones are mapped again
+    for(int i = 1; i < 4; ++i)
+    {
+        char id[64];
+        sprintf(id, "{\"userID\":\"user%d@example.com\"}", i);
+        TestOctet<64> clientId;
+        OCT_jstring(&clientId, id);
+
+        TestOctet<2 * PFS + 1> htid, cachedHid, cachedHtid;
+        MPIN_SERVER_1(date, &clientId, NULL, &htid);
+        MPIN_SERVER_1_CACHED(&cache, date, &clientId, &cachedHid, &cachedHtid);
+        BOOST_CHECK_EQUAL(ToHex(cachedHid), ToHex(hid[i]));
+        BOOST_CHECK_EQUAL(ToHex(cachedHtid), ToHex(htid));
+        BOOST_CHECK(FindCachedPoint(cache, hid[i]) >= 0);
+    }
+    BOOST_CHECK(FindCachedPoint(cache, hid[0]) >= 0);
+
+    BOOST_MESSAGE("    testPointCache finished");
+}
+
+// Checks that batch normalised points are the points ECP_affine() gives, one at a time
+static void CheckBatchAffine(ECP *points, ECP *projective, int n)
+{
+    for(int i = 0; i < n; ++i)
+    {
+        ECP expected;
+        ECP_copy(&expected, &projective[i]);
+        ECP_affine(&expected);
+
+        BOOST_CHECK_EQUAL(ECP_isinf(&points[i]), ECP_isinf(&expected));
+        if(!ECP_isinf(&expected))
+        {
+            BOOST_CHECK_EQUAL(BIG_comp(points[i].x, expected.x), 0);
+            BOOST_CHECK_EQUAL(BIG_comp(points[i].y, expected.y), 0);
+            BOOST_CHECK_EQUAL(BIG_comp(points[i].z, expected.z), 0);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(testBatchAffine)
+{
+    BOOST_MESSAGE("Starting testBatchAffine...");
+
+    // Multiples of the generator, at infinity, already affine or projective, with runs of each and at both ends
+    enum { INF, AFFINE, PROJECTIVE };
+    const int kinds[] = { INF, PROJECTIVE, AFFINE, PROJECTIVE, PROJECTIVE, INF, INF, AFFINE, PROJECTIVE, AFFINE,
+        PROJECTIVE, PROJECTIVE, AFFINE, INF };
+    const int COUNT = sizeof(kinds) / sizeof(kinds[0]);
+
+    ECP g1;
+    ECP2 g2;
+    Generators(&g1, &g2);
+
+    BIG one;
+    FP_one(one);
+
+    ECP projective[COUNT], points[COUNT], multiple;
+    BIG work[COUNT];
+    ECP_copy(&multiple, &g1);
+    for(int i = 0; i < COUNT; ++i)
+    {
+        ECP_dbl(&multiple);
+        ECP_add(&multiple, &g1);
+        ECP_copy(&projective[i], &multiple);
+        if(kinds[i] == INF)
+        {
+            ECP_inf(&projective[i]);
+        }
+        else if(kinds[i] == AFFINE)
+        {
+            ECP_affine(&projective[i]);
+        }
+        BOOST_CHECK_EQUAL(kinds[i] == PROJECTIVE, !ECP_isinf(&projective[i]) && BIG_comp(projective[i].z, one) != 0);
+    }
+
+    for(int i = 0; i < COUNT; ++i)
+    {
+        ECP_copy(&points[i], &projective[i]);
+    }
+    ECP_batch_affine(COUNT, points, work);
+    CheckBatchAffine(points, projective, COUNT);
+
+    // A single projective point, and points of which none needs converting
+    const int firsts[] = { 1, 5 };
+    const int counts[] = { 1, 3 };
+    for(int run = 0; run < 2; ++run)
+    {
+        for(int i = 0; i < counts[run]; ++i)
+        {
+            ECP_copy(&points[i], &projective[firsts[run] + i]);
+        }
+        ECP_batch_affine(counts[run], points, work);
+        CheckBatchAffine(points, &projective[firsts[run]], counts[run]);
+    }
+    ECP_batch_affine(0, points, work);
+
+    BOOST_MESSAGE("    testBatchAffine finished");
+}
+
+// Checks that a times BIG_invmodp(a) is 1 mod p
+static void CheckInverse(BIG a, BIG p)
+{
+    BIG x, inv, one;
+    BIG_copy(x, a);
+    BIG_invmodp(inv, x, p);
+    BOOST_CHECK(BIG_comp(inv, p) < 0);
+
+    BIG_copy(x, a);
+    BIG_modmul(x, x, inv, p);
+    BIG_one(one);
+    BOOST_CHECK_EQUAL(BIG_comp(x, one), 0);
+}
+
+BOOST_AUTO_TEST_CASE(testInvModP)
+{
+    BOOST_MESSAGE("Starting testInvModP...");
+
+    // Modulo the field modulus and the group order, for random numbers, those next to p and numbers above p
+    const chunk *moduli[] = { Modulus, CURVE_Order };
+    TestData data(8);
+    for(int m = 0; m < 2; ++m)
+    {
+        BIG p, a;
+        BIG_rcopy(p, moduli[m]);
+
+        for(int i = 0; i < 64; ++i)
+        {
+            // Below p for even i, and most likely above it for odd i
+            char bytes[MODBYTES];
+            data.Fill(bytes, sizeof(bytes));
+            if(i % 2 == 0)
+            {
+                bytes[0] &= 0x0f;
+            }
+            BIG_fromBytes(a, bytes);
+            CheckInverse(a, p);
+        }
+
+        for(int k = 1; k <= 4; ++k)
+        {
+            BIG_copy(a, p);
+            BIG_dec(a, k);
+            BIG_norm(a);
+            CheckInverse(a, p);
+
+            BIG_one(a);
+            BIG_inc(a, k - 1);
+            CheckInverse(a, p);
+        }
+
+        // 2p - 1 and p + 1
+        BIG_add(a, p, p);
+        BIG_dec(a, 1);
+        BIG_norm(a);
+        CheckInverse(a, p);
+        BIG_copy(a, p);
+        BIG_inc(a, 1);
+        BIG_norm(a);
+        CheckInverse(a, p);
+    }
+
+    BOOST_MESSAGE("    testInvModP finished");
+}
+
+BOOST_AUTO_TEST_CASE(testCompressedPoints)
+{
+    BOOST_MESSAGE("Starting testCompressedPoints...");
+
+    // Multiples of the generator, and their negatives, which have the other parity of y
+    ECP g1;
+    ECP2 g2;
+    Generators(&g1, &g2);
+
+    ECP point;
+    ECP_copy(&point, &g1);
+    for(int i = 0; i < 32; ++i)
+    {
+        ECP_dbl(&point);
+        ECP_add(&point, &g1);
+        for(int sign = 0; sign < 2; ++sign)
+        {
+            ECP_neg(&point);
+
+            TestOctet<MODBYTES + 1> compressed, again;
+            TestOctet<2 * MODBYTES + 1> uncompressed, decoded;
+            ECP_toOctetC(&compressed, &point);
+            ECP_toOctet(&uncompressed, &point);
+            BOOST_CHECK_EQUAL(compressed.len, MODBYTES + 1);
+            BOOST_CHECK(compressed.val[0] == 2 || compressed.val[0] == 3);
+            BOOST_CHECK_EQUAL(ToHex(compressed.val + 1, MODBYTES), ToHex(uncompressed.val + 1, MODBYTES));
+
+            ECP restored;
+            BOOST_CHECK(ECP_fromOctet(&restored, &compressed));
+            ECP_toOctet(&decoded, &restored);
+            BOOST_CHECK_EQUAL(ToHex(decoded), ToHex(uncompressed));
+            ECP_toOctetC(&again, &restored);
+            BOOST_CHECK_EQUAL(ToHex(again), ToHex(compressed));
+        }
+    }
+
+    // An x for which x^3+b is not a square is not on the curve, whatever the parity
+    int rejected = 0;
+    for(int x = 1; x <= 32; ++x)
+    {
+        TestOctet<MODBYTES + 1> compressed;
+        compressed.len = MODBYTES + 1;
+        compressed.val[MODBYTES] = (char) x;
+
+        ECP restored;
+        compressed.val[0] = 2;
+        int even = ECP_fromOctet(&restored, &compressed);
+        BOOST_CHECK_EQUAL(ECP_isinf(&restored) != 0, even == 0);
+        compressed.val[0] = 3;
+        int odd = ECP_fromOctet(&restored, &compressed);
+        BOOST_CHECK_EQUAL(ECP_isinf(&restored) != 0, odd == 0);
+
+        BOOST_CHECK_EQUAL(even, odd);
+        if(!even)
+        {
+            ++rejected;
+        }
+    }
+    BOOST_CHECK(rejected > 0 && rejected < 32);
+
+    BOOST_MESSAGE("    testCompressedPoints finished");
+}
+
+BOOST_AUTO_TEST_CASE(testAes)
+{
+    BOOST_MESSAGE("Starting testAes...");
+
+    // FIPS 197 appendix C.1 and SP 800-38A F.1.1 and F.2.1
+    std::string fipsKey = FromHex("000102030405060708090a0b0c0d0e0f");
+    std::string key = FromHex("2b7e151628aed2a6abf7158809cf4f3c");
+    std::string iv = FromHex("000102030405060708090a0b0c0d0e0f");
+    std::string plain = FromHex("6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+        "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710");
+    const char *ecbCipher = "3ad77bb40d7a3660a89ecaf32466ef97f5d3d58503b9699de785895a96fdbaaf"
+        "43b1cd7f598ece23881b00e3ed0306887b0c785e27e8ad3f8223207104725dd4";
+    const char *cbcCipher = "7649abac8119b246cee98e9b12e9197d5086cb9b507219ee95db113a917678b2"
+        "73bed6b8e3c1743b7116e69e222295163ff1caa1681fac09120eca307586e1a7";
+
+    for(int pass = 0; pass < PASSES; ++pass)
+    {
+        LimitCpuFeatures(pass);
+        aes a;
+
+        std::string block = FromHex("00112233445566778899aabbccddeeff");
+        AES_init(&a, ECB, &fipsKey[0], NULL);
+        AES_ecb_encrypt(&a, (uchar *) &block[0]);
+        BOOST_CHECK_EQUAL(ToHex(block), "69c4e0d86a7b0430d8cdb78070b4c55a");
+        AES_ecb_decrypt(&a, (uchar *) &block[0]);
+        BOOST_CHECK_EQUAL(ToHex(block), "00112233445566778899aabbccddeeff");
+        AES_end(&a);
+
+        std::string data = plain;
+        AES_init(&a, ECB, &key[0], NULL);
+        for(size_t i = 0; i < data.size(); i += 16)
+        {
+            AES_encrypt(&a, &data[i]);
+        }
+        BOOST_CHECK_EQUAL(ToHex(data), ecbCipher);
+        for(size_t i = 0; i < data.size(); i += 16)
+        {
+            AES_decrypt(&a, &data[i]);
+        }
+        BOOST_CHECK_EQUAL(ToHex(data), ToHex(plain));
+
+        // The blocks at once, as the CTR_DRBG uses them
+        AES_ecb_encrypt_blocks(&a, (uchar *) &data[0], (int) data.size() / 16);
+        BOOST_CHECK_EQUAL(ToHex(data), ecbCipher);
+        AES_end(&a);
+
+        data = plain;
+        AES_init(&a, CBC, &key[0], &iv[0]);
+        for(size_t i = 0; i < data.size(); i += 16)
+        {
+            AES_encrypt(&a, &data[i]);
+        }
+        BOOST_CHECK_EQUAL(ToHex(data), cbcCipher);
+        AES_reset(&a, CBC, &iv[0]);
+        for(size_t i = 0; i < data.size(); i += 16)
+        {
+            AES_decrypt(&a, &data[i]);
+        }
+        BOOST_CHECK_EQUAL(ToHex(data), ToHex(plain));
+        AES_end(&a);
+    }
+    CPU_limit(-1);
+
+    BOOST_MESSAGE("    testAes finished");
+}
+
+// Encrypts or decrypts with AES-GCM and returns the output followed by the tag
+static std::string Gcm(bool encrypt, const std::string& key, const std::string& iv, const std::string& header, const std::string& input)
+{
+    gcm g;
+    std::string output(input.size(), '\0');
+    char tag[16];
+
+    GCM_init(&g, (char *) key.data(), (int) iv.size(), (char *) iv.data());
+    GCM_add_header(&g, (char *) header.data(), (int) header.size());
+    if(encrypt)
+    {
+        GCM_add_plain(&g, &output[0], (char *) input.data(), (int) input.size());
+    }
+    else
+    {
+        GCM_add_cipher(&g, &output[0], (char *) input.data(), (int) input.size());
+    }
+    GCM_finish(&g, tag);
+
+    return output + std::string(tag, sizeof(tag));
+}
+
+BOOST_AUTO_TEST_CASE(testGcm)
+{
+    BOOST_MESSAGE("Starting testGcm...");
+
+    // Test cases 2, 3, 4 and 6 of the GCM specification
+    std::string zero = FromHex("00000000000000000000000000000000");
+    std::string key = FromHex("feffe9928665731c6d6a8f9467308308");
+    std::string iv = FromHex("cafebabefacedbaddecaf888");
+    std::string longIv = FromHex("9313225df88406e555909c5aff5269aa6a7a9538534f7da1e4c303d2a318a728"
+        "c3c0c95156809539fcf0e2429a6b525416aedbf5a0de6a57a637b39b");
+    std::string header = FromHex("feedfacedeadbeeffeedfacedeadbeefabaddad2");
+    std::string plain = FromHex("d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+        "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255");
+    std::string plain60 = plain.substr(0, 60);
+
+    // A longer message, with a header and a length that are not whole blocks, to compare the code paths on
+    std::string longPlain(1000, '\0');
+    std::string longHeader(21, '\0');
+    TestData data(3);
+    data.Fill(&longPlain[0], (int) longPlain.size());
+    data.Fill(&longHeader[0], (int) longHeader.size());
+    std::string longResult;
+
+    for(int pass = 0; pass < PASSES; ++pass)
+    {
+        LimitCpuFeatures(pass);
+
+        BOOST_CHECK_EQUAL(ToHex(Gcm(true, zero, zero.substr(0, 12), "", zero)),
+            "0388dace60b6a392f328c2b971b2fe78ab6e47d42cec13bdf53a67b21257bddf");
+        BOOST_CHECK_EQUAL(ToHex(Gcm(true, key, iv, "", plain)),
+            "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+            "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091473f5985"
+            "4d5c2af327cd64a62cf35abd2ba6fab4");
+        BOOST_CHECK_EQUAL(ToHex(Gcm(true, key, iv, header, plain60)),
+            "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+            "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091"
+            "5bc94fbc3221a5db94fae95ae7121a47");
+        BOOST_CHECK_EQUAL(ToHex(Gcm(true, key, longIv, header, plain60)),
+            "8ce24998625615b603a033aca13fb894be9112a5c3a211a8ba262a3cca7e2ca7"
+            "01e4a9a4fba43c90ccdcb281d48c7c6fd62875d2aca417034c34aee5"
+            "619cc5aefffe0bfa462af43c1699d050");
+
+        // Decryption gives the plaintext back, with the same tag
+        std::string sealed = Gcm(true, key, iv, header, plain60);
+        std::string opened = Gcm(false, key, iv, header, sealed.substr(0, 60));
+        BOOST_CHECK_EQUAL(ToHex(opened), ToHex(plain60 + sealed.substr(60)));
+
+        std::string result = Gcm(true, key, iv, longHeader, longPlain);
+        if(pass == 0)
+        {
+            longResult = result;
+        }
+        BOOST_CHECK_EQUAL(ToHex(result), ToHex(longResult));
+        opened = Gcm(false, key, iv, longHeader, result.substr(0, longPlain.size()));
+        BOOST_CHECK_EQUAL(ToHex(opened), ToHex(longPlain + result.substr(longPlain.size())));
+    }
+    CPU_limit(-1);
+
+    BOOST_MESSAGE("    testGcm finished");
+}
@@ -76,6 +76,10 @@ bool CHttpRequest::Execute( MPinSDK::IHttpRequest::Method method, const String&
 		m_requestHeaders["X-MIRACL-OS-Class"] = "linux";
 	}
 	
+	// An empty Expect header stops curl from sending "Expect: 100-continue" with PUT requests and then
+	// waiting up to a second for a "100 Continue" that some servers never send, which skews the latencies
+	m_requestHeaders["Expect"] = "";
+	
 	m_request.SetHeaders( m_requestHeaders );
 
 	String fullUrl = url;
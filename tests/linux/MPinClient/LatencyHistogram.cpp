@@ -0,0 +1,137 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+#include "LatencyHistogram.h"
+
+#include <math.h>
+
+namespace
+{
+	const int		SUB_BUCKET_BITS = 7;
+	const uint64_t	SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+	const uint64_t	SUB_BUCKET_HALF = SUB_BUCKET_COUNT / 2;
+	// Values up to 2^40 usec (~12 days), longer ones are clamped
+	const int		MAX_VALUE_BITS = 40;
+	const uint64_t	MAX_VALUE = ((uint64_t)1 << MAX_VALUE_BITS) - 1;
+	const size_t	COUNTS_SIZE = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 2) * SUB_BUCKET_HALF;
+}
+
+CLatencyHistogram::CLatencyHistogram() :
+	m_counts(COUNTS_SIZE, 0), m_count(0), m_sum(0), m_min(0), m_max(0)
+{}
+
+size_t CLatencyHistogram::_GetIndex( uint64_t aValue )
+{
+	if ( aValue < SUB_BUCKET_COUNT )
+	{
+		return (size_t)aValue;
+	}
+
+	int msb = 63 - __builtin_clzll(aValue);
+	int bucket = msb - (SUB_BUCKET_BITS - 1);
+
+	return (size_t)( bucket * SUB_BUCKET_HALF + (aValue >> bucket) );
+}
+
+uint64_t CLatencyHistogram::_GetHighestValue( size_t aIndex )
+{
+	if ( aIndex < SUB_BUCKET_COUNT )
+	{
+		return aIndex;
+	}
+
+	int bucket = (int)( aIndex / SUB_BUCKET_HALF ) - 1;
+	uint64_t subBucket = aIndex % SUB_BUCKET_HALF + SUB_BUCKET_HALF;
+
+	return ( (subBucket + 1) << bucket ) - 1;
+}
+
+void CLatencyHistogram::Record( uint64_t aMicrosecs )
+{
+	if ( aMicrosecs > MAX_VALUE )
+	{
+		aMicrosecs = MAX_VALUE;
+	}
+
+	++m_counts[ _GetIndex(aMicrosecs) ];
+
+	if ( m_count == 0 || aMicrosecs < m_min )
+	{
+		m_min = aMicrosecs;
+	}
+	if ( aMicrosecs > m_max )
+	{
+		m_max = aMicrosecs;
+	}
+
+	++m_count;
+	m_sum += aMicrosecs;
+}
+
+void CLatencyHistogram::Add( const CLatencyHistogram& aOther )
+{
+	if ( aOther.m_count == 0 )
+	{
+		return;
+	}
+
+	for ( size_t i = 0; i < COUNTS_SIZE; ++i )
+	{
+		m_counts[i] += aOther.m_counts[i];
+	}
+
+	if ( m_count == 0 || aOther.m_min < m_min )
+	{
+		m_min = aOther.m_min;
+	}
+	if ( aOther.m_max > m_max )
+	{
+		m_max = aOther.m_max;
+	}
+
+	m_count += aOther.m_count;
+	m_sum += aOther.m_sum;
+}
+
+uint64_t CLatencyHistogram::GetValueAtPercentile( double aPercentile ) const
+{
+	if ( m_count == 0 )
+	{
+		return 0;
+	}
+
+	uint64_t rank = (uint64_t)ceil( aPercentile / 100.0 * m_count );
+	if ( rank < 1 )
+	{
+		rank = 1;
+	}
+
+	uint64_t seen = 0;
+	for ( size_t i = 0; i < COUNTS_SIZE; ++i )
+	{
+		seen += m_counts[i];
+		if ( seen >= rank )
+		{
+			uint64_t value = _GetHighestValue(i);
+			return ( value < m_max ) ? value : m_max;
+		}
+	}
+
+	return m_max;
+}
@@ -0,0 +1,61 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+#ifndef LATENCYHISTOGRAM_H
+#define	LATENCYHISTOGRAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////
+//	CLatencyHistogram
+/// @brief	Log-linear latency histogram in the spirit of HdrHistogram.
+///	Every power of 2 is split into 64 linear sub-buckets, so a recorded
+///	value is reported with less than 1% error from 1 usec up to days,
+///	at a fixed memory cost and without keeping the samples.
+////////////////////////////////////////////////////////////////////
+class CLatencyHistogram
+{
+public:
+	CLatencyHistogram();
+
+	void		Record( uint64_t aMicrosecs );
+	void		Add( const CLatencyHistogram& aOther );
+
+	uint64_t	GetCount() const	{ return m_count; }
+	uint64_t	GetMin() const		{ return m_count > 0 ? m_min : 0; }
+	uint64_t	GetMax() const		{ return m_max; }
+	double		GetMean() const		{ return m_count > 0 ? (double)m_sum / m_count : 0; }
+
+	/// Nearest-rank percentile, e.g. 99.9, reported as the highest value of its bucket
+	uint64_t	GetValueAtPercentile( double aPercentile ) const;
+
+private:
+	static size_t	_GetIndex( uint64_t aValue );
+	static uint64_t	_GetHighestValue( size_t aIndex );
+
+	std::vector<uint64_t>	m_counts;
+	uint64_t				m_count;
+	uint64_t				m_sum;
+	uint64_t				m_min;
+	uint64_t				m_max;
+};
+
+#endif	/* LATENCYHISTOGRAM_H */
@@ -0,0 +1,229 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+#include "LoadGenerator.h"
+
+#include "CvLogger.h"
+
+#include <cstdlib>
+#include <math.h>
+#include <time.h>
+
+using CvShared::CvMutexLock;
+using CvShared::LogMessage;
+using CvShared::enLogLevel_Info;
+using CvShared::enLogLevel_Error;
+
+static int64_t NowNs()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void SleepUntilNs( int64_t aTimeNs )
+{
+	struct timespec ts;
+	ts.tv_sec = aTimeNs / 1000000000;
+	ts.tv_nsec = aTimeNs % 1000000000;
+	while ( clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL ) != 0 )
+	{}
+}
+
+CLoadGenerator::CLoadGenerator( const std::vector<CMpinClient*>& aClients, uint32_t aNumOfThreads, double aRequestsPerSecond, enArrivals_t aArrivals ) :
+	m_requestsPerSecond(aRequestsPerSecond), m_arrivals(aArrivals),
+	m_queueArrivals("arrivals"), m_idleClients("idle-clients"), m_semCompleted("completed"),
+	m_mutexStats("load-stats"), m_numOfRequests(0), m_durationSec(0)
+{
+	m_semCompleted.Create(0);
+	m_mutexStats.Create();
+
+	for ( std::vector<CMpinClient*>::const_iterator itr = aClients.begin(); itr != aClients.end(); ++itr )
+	{
+		m_idleClients.Push(*itr);
+	}
+
+	for ( uint32_t i = 0; i < aNumOfThreads; ++i )
+	{
+		CWorker* pWorker = new CWorker();
+		pWorker->Create(this);
+		m_workers.push_back(pWorker);
+	}
+}
+
+CLoadGenerator::~CLoadGenerator()
+{
+	sArrival_t exit;
+	exit.m_phase = enPhase_Count;
+	exit.m_scheduledNs = 0;
+	exit.m_bExit = true;
+
+	for ( size_t i = 0; i < m_workers.size(); ++i )
+	{
+		m_queueArrivals.Push(exit);
+	}
+
+	// The worker threads are detached, each one reports its exit instead
+	for ( std::vector<CWorker*>::iterator itr = m_workers.begin(); itr != m_workers.end(); ++itr )
+	{
+		m_semCompleted.Pend();
+	}
+
+	for ( std::vector<CWorker*>::iterator itr = m_workers.begin(); itr != m_workers.end(); ++itr )
+	{
+		delete *itr;
+	}
+}
+
+const char* CLoadGenerator::GetPhaseName( enPhase_t aPhase )
+{
+	switch ( aPhase )
+	{
+		case enPhase_Register:			return "register";
+		case enPhase_AuthenticateGood:	return "auth-good";
+		case enPhase_AuthenticateBad:	return "auth-bad";
+		default:						return "unknown";
+	}
+}
+
+void CLoadGenerator::RunRegistration()
+{
+	// The idle clients queue is FIFO, so the first arrivals pick every client exactly once
+	_Run( m_idleClients.Size(), 0, true );
+}
+
+void CLoadGenerator::RunAuthentication( uint32_t aCount, uint32_t aBadPinPercent )
+{
+	_Run( aCount, aBadPinPercent, false );
+}
+
+int64_t CLoadGenerator::_NextArrivalNs( int64_t aStartNs, int64_t aPrevNs, uint32_t aIndex )
+{
+	if ( m_arrivals == enArrivals_Poisson )
+	{
+		// Exponentially distributed inter-arrival times
+		double u = ( rand() + 1.0 ) / ( RAND_MAX + 2.0 );
+		return aPrevNs + (int64_t)( -log(u) / m_requestsPerSecond * 1e9 );
+	}
+
+	// Computed from the start rather than accumulated, so the schedule does not drift
+	return aStartNs + (int64_t)( aIndex / m_requestsPerSecond * 1e9 );
+}
+
+void CLoadGenerator::_Run( uint32_t aCount, uint32_t aBadPinPercent, bool abRegister )
+{
+	LogMessage( enLogLevel_Info, "Scheduling %u %s requests at %.1f requests per second", aCount,
+			abRegister ? "registration" : "authentication", m_requestsPerSecond );
+
+	int64_t startNs = NowNs();
+	int64_t scheduledNs = startNs;
+
+	for ( uint32_t i = 0; i < aCount; ++i )
+	{
+		scheduledNs = _NextArrivalNs( startNs, scheduledNs, i );
+		SleepUntilNs( scheduledNs );
+
+		sArrival_t arrival;
+		arrival.m_bExit = false;
+		arrival.m_scheduledNs = scheduledNs;
+
+		if ( abRegister )
+		{
+			arrival.m_phase = enPhase_Register;
+		}
+		else
+		{
+			arrival.m_phase = ( (uint32_t)(rand() % 100) < aBadPinPercent ) ? enPhase_AuthenticateBad : enPhase_AuthenticateGood;
+		}
+
+		m_queueArrivals.Push(arrival);
+	}
+
+	for ( uint32_t i = 0; i < aCount; ++i )
+	{
+		m_semCompleted.Pend();
+	}
+
+	m_durationSec += ( NowNs() - startNs ) / 1e9;
+}
+
+void CLoadGenerator::_Serve( const sArrival_t& aArrival )
+{
+	CMpinClient* pClient = NULL;
+	m_idleClients.Pop(pClient);
+
+	bool bOk = false;
+	switch ( aArrival.m_phase )
+	{
+		case enPhase_Register:
+			bOk = pClient->Register();
+			break;
+		case enPhase_AuthenticateGood:
+			bOk = pClient->AuthenticateGood();
+			break;
+		case enPhase_AuthenticateBad:
+			bOk = pClient->AuthenticateBad();
+			break;
+		default:
+			break;
+	}
+
+	int64_t latencyNs = NowNs() - aArrival.m_scheduledNs;
+
+	m_idleClients.Push(pClient);
+
+	{
+		CvMutexLock lock(m_mutexStats);
+
+		sPhaseStats_t& stats = m_stats[aArrival.m_phase];
+		stats.m_latency.Record( (uint64_t)( latencyNs / 1000 ) );
+		if ( !bOk )
+		{
+			++stats.m_numOfErrors;
+		}
+		++m_numOfRequests;
+	}
+
+	m_semCompleted.Post();
+}
+
+long CLoadGenerator::CWorker::Body( void* apArgs )
+{
+	CLoadGenerator* pGenerator = (CLoadGenerator*)apArgs;
+
+	while ( true )
+	{
+		sArrival_t arrival;
+		if ( !pGenerator->m_queueArrivals.Pop(arrival) )
+		{
+			LogMessage( enLogLevel_Error, "Error popping from the arrivals queue. Thread [%s]", m_name.c_str() );
+			continue;
+		}
+
+		if ( arrival.m_bExit )
+		{
+			pGenerator->m_semCompleted.Post();
+			break;
+		}
+
+		pGenerator->_Serve(arrival);
+	}
+
+	return 0;
+}
@@ -0,0 +1,121 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+#ifndef LOADGENERATOR_H
+#define	LOADGENERATOR_H
+
+#include "MpinClient.h"
+#include "LatencyHistogram.h"
+
+#include "CvThread.h"
+#include "CvQueue.h"
+#include "CvMutex.h"
+#include "CvSemaphore.h"
+
+#include <vector>
+
+////////////////////////////////////////////////////////////////////
+//	CLoadGenerator
+/// @brief	Open-loop load generator over a set of M-Pin clients.
+///	Requests arrive at a fixed or Poisson rate that does not depend on
+///	how fast the backend answers. A few worker threads serve the arrivals
+///	with whichever client is idle, and the latency of every request is
+///	measured from the time it was scheduled to arrive, so waiting for a
+///	free worker or client is included (no coordinated omission).
+////////////////////////////////////////////////////////////////////
+class CLoadGenerator
+{
+public:
+	enum enPhase_t
+	{
+		enPhase_Register,
+		enPhase_AuthenticateGood,
+		enPhase_AuthenticateBad,
+		enPhase_Count
+	};
+
+	enum enArrivals_t
+	{
+		enArrivals_Fixed,
+		enArrivals_Poisson
+	};
+
+	struct sPhaseStats_t
+	{
+		sPhaseStats_t() : m_numOfErrors(0) {}
+
+		CLatencyHistogram	m_latency;		///< Microseconds from the scheduled arrival to the completion
+		uint32_t			m_numOfErrors;
+	};
+
+	CLoadGenerator( const std::vector<CMpinClient*>& aClients, uint32_t aNumOfThreads, double aRequestsPerSecond, enArrivals_t aArrivals );
+	~CLoadGenerator();
+
+	/// Registers every client once
+	void	RunRegistration();
+	/// Authenticates aCount times with randomly picked clients, aBadPinPercent of them with the wrong PIN
+	void	RunAuthentication( uint32_t aCount, uint32_t aBadPinPercent );
+
+	static const char*		GetPhaseName( enPhase_t aPhase );
+	const sPhaseStats_t&	GetStats( enPhase_t aPhase ) const	{ return m_stats[aPhase]; }
+	uint32_t				GetNumOfRequests() const			{ return m_numOfRequests; }
+	/// Wall time of all runs, in seconds
+	double					GetDuration() const					{ return m_durationSec; }
+
+private:
+	struct sArrival_t
+	{
+		enPhase_t	m_phase;
+		int64_t		m_scheduledNs;
+		bool		m_bExit;
+	};
+
+	typedef CvShared::CvThread					CvThread;
+	typedef CvShared::CvQueue<sArrival_t>		CQueueArrivals;
+	typedef CvShared::CvQueue<CMpinClient*>		CQueueClients;
+
+	class CWorker : public CvThread
+	{
+	public:
+		CWorker() : CvThread("load-worker") {}
+	private:
+		virtual long Body( void* apArgs );
+	};
+
+	CLoadGenerator(const CLoadGenerator& orig);
+
+	void		_Run( uint32_t aCount, uint32_t aBadPinPercent, bool abRegister );
+	void		_Serve( const sArrival_t& aArrival );
+	int64_t		_NextArrivalNs( int64_t aStartNs, int64_t aPrevNs, uint32_t aIndex );
+
+	double					m_requestsPerSecond;
+	enArrivals_t			m_arrivals;
+
+	std::vector<CWorker*>	m_workers;
+	CQueueArrivals			m_queueArrivals;
+	CQueueClients			m_idleClients;
+	CvShared::CvSemaphore	m_semCompleted;
+
+	CvShared::CvMutex		m_mutexStats;
+	sPhaseStats_t			m_stats[enPhase_Count];
+	uint32_t				m_numOfRequests;
+	double					m_durationSec;
+};
+
+#endif	/* LOADGENERATOR_H */
@@ -30,8 +30,6 @@ using namespace std;
 using CvShared::SleepFor;
 using CvShared::Millisecs;
 using CvShared::Seconds;
-using CvShared::TimeSpec;
-using CvShared::GetCurrentTime;
 using CvShared::LogMessage;
 using CvShared::enLogLevel_Info;
 using CvShared::enLogLevel_Error;
@@ -79,8 +77,7 @@ bool CMpinClient::CStorage::GetData(OUT String &data)
 CMpinClient::CMpinClient( int aClientId, const String& aBackendUrl, const String& aUserId ) :
 	m_bInitialized(false), m_id(aClientId), m_userId(aUserId),
 	m_storageSecure( String().Format("sec-%d", aClientId) ), m_storageNonSecure( String().Format("%d", aClientId) ),
-	m_context( String().Format("%d",aClientId), &m_storageSecure, &m_storageNonSecure ),
-	m_thread(aUserId), m_queue(aUserId.c_str()), m_bIdle(false), m_bStatsEnabled(true)
+	m_context( String().Format("%d",aClientId), &m_storageSecure, &m_storageNonSecure )
 {
 	std::ifstream filePin( String().Format("pin-%d", m_id).c_str() );
 	filePin >> m_pinGood;
@@ -92,8 +89,7 @@ CMpinClient::CMpinClient( int aClientId, const String& aBackendUrl, const String
 CMpinClient::CMpinClient( int aClientId, const String& aBackendUrl, const String& aUserId, const String& aPinGood, const String& aPinBad, const String& aRegOTC ) :
 	m_bInitialized(false), m_id(aClientId), m_userId(aUserId), m_pinGood(aPinGood), m_pinBad(aPinBad), m_regOTC(aRegOTC),
 	m_storageSecure( String().Format("sec-%d", aClientId) ), m_storageNonSecure( String().Format("%d", aClientId) ),
-	m_context( String().Format("%d",aClientId), &m_storageSecure, &m_storageNonSecure ),
-	m_thread(aUserId), m_queue(aUserId.c_str()), m_bIdle(false), m_bStatsEnabled(true)
+	m_context( String().Format("%d",aClientId), &m_storageSecure, &m_storageNonSecure )
 {
 	std::ofstream filePin( String().Format("pin-%d", m_id).c_str() );
 	filePin << m_pinGood << " " << m_pinBad;
@@ -102,11 +98,7 @@ CMpinClient::CMpinClient( int aClientId, const String& aBackendUrl, const String
 }
 
 CMpinClient::~CMpinClient()
-{
-	m_queue.PushFront(enEvent_Exit);
-	
-	SleepFor( Millisecs(100) );
-}
+{}
 
 bool CMpinClient::_Init(const String& aBackendUrl)
 {
@@ -120,33 +112,25 @@ bool CMpinClient::_Init(const String& aBackendUrl)
 	if ( status != MPinSDK::Status::OK )
 	{
 		LogMessage( enLogLevel_Error, "Client #%d for user [%s] couldn't be initialized: %s", m_id, m_userId.c_str(), status.GetErrorMessage().c_str() );
-		if ( m_bStatsEnabled )
-		{
-			++m_stats.m_numOfErrors;
-		}
-		m_bIdle = true;
-		
 		return false;
 	}
 	
-	m_thread.Create(this);
-	
 	m_bInitialized = true;
 	
 	return true;
 }
 	
-bool CMpinClient::_AuthenticateGood()
+bool CMpinClient::AuthenticateGood()
 {
 	return _Authenticate( m_pinGood );
 }
 
-bool CMpinClient::_AuthenticateBad()
+bool CMpinClient::AuthenticateBad()
 {
 	return _Authenticate( m_pinBad );
 }
 
-bool CMpinClient::_Register()
+bool CMpinClient::Register()
 {
 	if (!m_bInitialized)
 	{
@@ -171,19 +155,11 @@ bool CMpinClient::_Register()
 
 	MPinSDK::UserPtr user = m_sdk.MakeNewUser( m_userId, String().Format( "M-Pin Test Client #%d", m_id ) );
 	
-	TimeSpec now;
-	GetCurrentTime(now);
-	Millisecs startTime = now.ToMillisecs();
-
 	MPinSDK::Status status = m_sdk.StartRegistration( user, m_regOTC, "{ \"data\": \"test\" }" );
 	
 	if ( status != MPinSDK::Status::OK )
 	{
 		LogMessage( enLogLevel_Error, "Failed in StartRegistration(): %s [%d]", status.GetErrorMessage().c_str(), status.GetStatusCode() );
-		if ( m_bStatsEnabled )
-		{
-			++m_stats.m_numOfErrors;
-		}
 		return false;
 	}
 	
@@ -206,10 +182,6 @@ bool CMpinClient::_Register()
 			if ( status != MPinSDK::Status::IDENTITY_NOT_VERIFIED )
 			{
 				LogMessage( enLogLevel_Error, "Failed in ConfirmRegistration(): %s [%d]", status.GetErrorMessage().c_str(), status.GetStatusCode() );
-				if ( m_bStatsEnabled )
-				{
-					++m_stats.m_numOfErrors;
-				}
 				return false;
 			}
 		}
@@ -223,10 +195,6 @@ bool CMpinClient::_Register()
 		if ( status != MPinSDK::Status::OK )
 		{
 			LogMessage( enLogLevel_Error, "Failed in ConfirmRegistration(): %s [%d]", status.GetErrorMessage().c_str(), status.GetStatusCode() );
-			if ( m_bStatsEnabled )
-			{
-				++m_stats.m_numOfErrors;
-			}
 			return false;
 		}
 	}
@@ -236,31 +204,9 @@ bool CMpinClient::_Register()
 	if ( status != MPinSDK::Status::OK )
 	{
 		LogMessage( enLogLevel_Error, "Failed in FinishRegistration(): %s [%d]", status.GetErrorMessage().c_str(), status.GetStatusCode() );
-		if ( m_bStatsEnabled )
-		{
-			++m_stats.m_numOfErrors;
-		}
 		return false;
 	}
 	
-	GetCurrentTime(now);
-	
-	if ( m_bStatsEnabled )
-	{
-		uint32_t currMsec = now.ToMillisecs() - startTime.Value();
-		m_stats.m_avgRegMsec = ( m_stats.m_avgRegMsec*m_stats.m_numOfReg + currMsec ) / ( m_stats.m_numOfReg + 1 );
-		++m_stats.m_numOfReg;
-		
-		if ( currMsec < m_stats.m_minRegMsec || m_stats.m_minRegMsec == 0 )
-		{
-			m_stats.m_minRegMsec = currMsec;
-		}
-		if ( currMsec > m_stats.m_maxRegMsec )
-		{
-			m_stats.m_maxRegMsec = currMsec;
-		}
-	}
-	
 	return true;
 }
 
@@ -285,10 +231,6 @@ bool CMpinClient::_Authenticate( const String& aPin )
 	if ( itr == listUsers.end() )
 	{
 		LogMessage( enLogLevel_Warning, "User [%s] not found in the list", m_userId.c_str() );
-		if ( m_bStatsEnabled )
-		{
-			++m_stats.m_numOfErrors;
-		}
 		return false;
 	}
 	
@@ -303,19 +245,11 @@ bool CMpinClient::_Authenticate( const String& aPin )
 		LogMessage( enLogLevel_Info, "Authenticating user [%s] with incorrect PIN...", user->GetId().c_str() );		
 	}
 	
-	TimeSpec now;
-	GetCurrentTime(now);
-	Millisecs startTime = now.ToMillisecs();
-
 	MPinSDK::Status status = m_sdk.StartAuthentication( user );
 	
 	if ( status != MPinSDK::Status::OK )
 	{
 		LogMessage( enLogLevel_Error, "Failed in StartAuthentication(): %s [%d]", status.GetErrorMessage().c_str(), status.GetStatusCode() );
-		if ( m_bStatsEnabled )
-		{
-			++m_stats.m_numOfErrors;
-		}
 		return false;
 	}
 	
@@ -326,10 +260,6 @@ bool CMpinClient::_Authenticate( const String& aPin )
 		if ( status != MPinSDK::Status::OK && user->GetState() != MPinSDK::User::BLOCKED )
 		{
 			LogMessage( enLogLevel_Error, "ERROR: Authentication for user [%s] failed: %s [%d]", user->GetId().c_str(), status.GetErrorMessage().c_str(), status.GetStatusCode() );
-			if ( m_bStatsEnabled )
-			{
-				++m_stats.m_numOfErrors;
-			}
 			return false;
 		}
 
@@ -347,90 +277,16 @@ bool CMpinClient::_Authenticate( const String& aPin )
 		if ( status == MPinSDK::Status::OK )
 		{
 			LogMessage( enLogLevel_Error, "ERROR: Authentication for user [%s] succeeded ?!", user->GetId().c_str() );
-			if ( m_bStatsEnabled )
-			{
-				++m_stats.m_numOfErrors;
-			}
 			return false;
 		}
 		else if ( status != MPinSDK::Status::INCORRECT_PIN )
 		{
 			LogMessage( enLogLevel_Error, "ERROR: Authentication for user [%s] failed: %s [%d]", user->GetId().c_str(), status.GetErrorMessage().c_str(), status.GetStatusCode() );
-			if ( m_bStatsEnabled )
-			{
-				++m_stats.m_numOfErrors;
-			}
 			return false;
 		}
 		
 		LogMessage( enLogLevel_Info, "Authentication for user [%s] not successful (OK): %s [%d]", user->GetId().c_str(), status.GetErrorMessage().c_str(), status.GetStatusCode() );		
 	}
 
-	GetCurrentTime(now);
-	
-	if ( m_bStatsEnabled )
-	{
-		uint32_t currMsec = now.ToMillisecs() - startTime.Value();
-		m_stats.m_avgAuthMsec = ( m_stats.m_avgAuthMsec*m_stats.m_numOfAuth + currMsec ) / ( m_stats.m_numOfAuth + 1 );
-		++m_stats.m_numOfAuth;
-		
-		if ( currMsec < m_stats.m_minAuthMsec || m_stats.m_minAuthMsec == 0 )
-		{
-			m_stats.m_minAuthMsec = currMsec;
-		}
-		if ( currMsec > m_stats.m_maxAuthMsec )
-		{
-			m_stats.m_maxAuthMsec = currMsec;
-		}
-	}
-	
 	return true;
 }
-
-long CMpinClient::CThread::Body( void* apArgs )
-{
-	CMpinClient* pClient = (CMpinClient*)apArgs;
-	uint32_t id = pClient->m_id;
-	
-	bool bExit = false;
-	
-	while (!bExit)
-	{
-		enEvent_t event;
-			
-		if ( !pClient->m_queue.Pop( event, 0 ) )
-		{
-			pClient->m_bIdle = true;
-			
-			if ( !pClient->m_queue.Pop( event ) )
-			{
-				LogMessage( enLogLevel_Error, "Client #%d: Error popping from the event queue. Thread [%s]", pClient->m_id, m_name.c_str() );
-				SleepFor( Millisecs(500) );
-				continue;
-			}
-		}
-		
-		pClient->m_bIdle = false;
-		
-		switch (event)
-		{
-			case enEvent_Register:
-				pClient->_Register();
-				break;
-			case enEvent_AuthenticateGood:
-				pClient->_AuthenticateGood();
-				break;
-			case enEvent_AuthenticateBad:
-				pClient->_AuthenticateBad();
-				break;
-			case enEvent_Exit:
-				pClient->m_bIdle = true;				
-				bExit = true;
-				break;
-		}
-	}
-	
-	LogMessage( enLogLevel_Debug1, "Client thread #%d is exiting...", id );
-	
-	return 0;
-}
@@ -22,9 +22,6 @@ under the License.
 
 #include "mpin_sdk.h"
 
-#include "CvThread.h"
-#include "CvQueue.h"
-
 typedef MPinSDK::String String;
 typedef MPinSDK::StringMap StringMap;
 	
@@ -42,35 +39,14 @@ public:
 	
 	uint32_t		GetId() const { return m_id; }
 	const String&	GetUserId() const { return m_userId; }
+	bool			IsInitialized() const { return m_bInitialized; }
 	
-	void Register()			{ m_queue.Push( enEvent_Register ); }
-	void AuthenticateGood()	{ m_queue.Push( enEvent_AuthenticateGood ); }
-	void AuthenticateBad()	{ m_queue.Push( enEvent_AuthenticateBad ); }
-	bool Done() const		{ return m_bIdle; }
-	
-	struct sStats_t
-	{
-		sStats_t() :
-			m_numOfReg(0), m_minRegMsec(0), m_maxRegMsec(0), m_avgRegMsec(0),
-			m_numOfAuth(0), m_minAuthMsec(0), m_maxAuthMsec(0), m_avgAuthMsec(0),
-			m_numOfErrors(0) {}
-		
-		uint32_t	m_numOfAuth;
-		uint32_t	m_numOfReg;
-		uint32_t	m_minRegMsec;
-		uint32_t	m_maxRegMsec;
-		uint32_t	m_avgRegMsec;
-		uint32_t	m_minAuthMsec;
-		uint32_t	m_maxAuthMsec;
-		uint32_t	m_avgAuthMsec;
-		int			m_numOfErrors;
-	};
-	
-	void EnableStats(bool abEnable = true) { m_bStatsEnabled = abEnable; }
-	const sStats_t& GetStats() const	{ return m_stats; }
+	// Each call runs to completion on the calling thread. A client must not be used by two threads at a time.
+	bool Register();
+	bool AuthenticateGood();
+	bool AuthenticateBad();
 	
 private:
-	friend class CThread;
 	
 	class CStorage : public MPinSDK::IStorage
 	{
@@ -109,9 +85,6 @@ private:
 	CMpinClient(const CMpinClient& orig);
 	bool _Init(const String& aBackendUrl);
 	bool _Authenticate( const String& aPin );
-	bool _Register();
-	bool _AuthenticateGood();
-	bool _AuthenticateBad();
 	
 	uint32_t	m_id;
 	
@@ -127,32 +100,6 @@ private:
 	String		m_pinBad;
 	
 	String		m_regOTC;
-	
-	enum enEvent_t
-	{
-		enEvent_Register,
-		enEvent_AuthenticateGood,
-		enEvent_AuthenticateBad,
-		enEvent_Exit
-	};
-
-	typedef CvShared::CvThread				CvThread;
-	typedef CvShared::CvQueue<enEvent_t>	CQueueEvents;
-	
-	class CThread : public CvThread
-	{
-	public:
-		CThread( const String& aName ) : CvThread(aName.c_str()) {}
-	private:
-		virtual long Body( void* apArgs );
-	};
-		
-	CThread			m_thread;
-	CQueueEvents	m_queue;
-	bool			m_bIdle;
-	
-	sStats_t		m_stats;
-	bool			m_bStatsEnabled;
 };
 
 #endif	/* MPINCLIENT_H */
@@ -18,11 +18,12 @@ under the License.
 */
 
 #include "MpinClient.h"
+#include "LoadGenerator.h"
 #include "CvLogger.h"
-#include "CvThread.h"
 #include "CvTime.h"
 #include "CvHttpRequest.h"
 #include <cstdlib>
+#include <cstdio>
 #include <getopt.h>
 
 using namespace std;
@@ -40,7 +41,8 @@ void PrintUsage(const char* aExeName, const char* aMessage = NULL)
 	{
 		printf("%s\n", aMessage);
 	}
-	printf("Usage: %s --reg --auth -n <num-of-clients> -r <requests-per-second> [-u <user-id> -t <timeout-sec> -c <count> -o <reg-otc>] -b <backend-url>\n", aExeName);
+	printf("Usage: %s --reg --auth -n <num-of-clients> -r <requests-per-second> [-u <user-id> -t <timeout-sec> -c <count> -o <reg-otc>"
+			" -w <worker-threads> -p <bad-pin-percent> --poisson --json <file> --csv <file>] -b <backend-url>\n", aExeName);
 	printf("\n");
 }
 
@@ -48,7 +50,8 @@ struct sParams
 {
 	sParams() :
 		bRegister(false), bAuthenticate(false), numOfClients(0), requestsPerSecond(0),
-		count(1), userId("test%d@dispostable.com"), timeout(30)
+		count(1), userId("test%d@dispostable.com"), timeout(30), numOfThreads(8), badPinPercent(10),
+		arrivals(CLoadGenerator::enArrivals_Fixed)
 	{}
 
 	bool		bRegister;
@@ -60,6 +63,11 @@ struct sParams
 	::String	userId;
 	Seconds		timeout;
 	::String	regOTC;
+	uint32_t	numOfThreads;
+	uint32_t	badPinPercent;
+	CLoadGenerator::enArrivals_t	arrivals;
+	::String	jsonFile;
+	::String	csvFile;
 };
 
 bool doargs(int argc, char **argv, OUT sParams& aParams)
@@ -78,11 +86,14 @@ bool doargs(int argc, char **argv, OUT sParams& aParams)
 	static struct option long_options[] = {
 		{ "reg", no_argument, NULL, 1},
 		{ "auth", no_argument, NULL, 2},
+		{ "poisson", no_argument, NULL, 3},
+		{ "json", required_argument, NULL, 4},
+		{ "csv", required_argument, NULL, 5},
 		{ 0, 0, 0, 0}
 	};
 	int option_index = 0;
 
-	while ((ch = getopt_long(argc, argv, "n:r:b:u:t:c:o:", long_options, &option_index)) > 0)
+	while ((ch = getopt_long(argc, argv, "n:r:b:u:t:c:o:w:p:", long_options, &option_index)) > 0)
 	{
 		switch (ch)
 		{
@@ -104,59 +115,137 @@ bool doargs(int argc, char **argv, OUT sParams& aParams)
 				break;
 			case 'o': aParams.regOTC = optarg;
 				break;
+			case 'w': aParams.numOfThreads = atoi(optarg);
+				break;
+			case 'p': aParams.badPinPercent = atoi(optarg);
+				break;
+			case 3: aParams.arrivals = CLoadGenerator::enArrivals_Poisson;
+				break;
+			case 4: aParams.jsonFile = optarg;
+				break;
+			case 5: aParams.csvFile = optarg;
+				break;
 		}
 	}
 
 	return true;
 }
 
-bool SleepRandTime(uint32_t aRequestsPerSecond)
+// Latencies are kept in microseconds and reported in milliseconds
+static double ToMsec(uint64_t aMicrosecs)
 {
-	Millisecs time2wait(Seconds(1).ToMillisecs() / aRequestsPerSecond);
+	return aMicrosecs / 1000.0;
+}
+
+void PrintReport(const CLoadGenerator& aGenerator)
+{
+	printf("==============================================================================================\n");
+	printf(" Phase | # Requests | # Errors | Min | p50 | p90 | p99 | p99.9 | Max | Avg (all times are in msec, from the scheduled arrival)\n");
+	printf("----------------------------------------------------------------------------------------------\n");
 
-	int randFactor = (rand() * time2wait.Value()) / RAND_MAX - time2wait.Value() / 2; // -0.5*time2wait ... +0.5time2wait
+	for (int i = 0; i < CLoadGenerator::enPhase_Count; ++i)
+	{
+		CLoadGenerator::enPhase_t phase = (CLoadGenerator::enPhase_t) i;
+		const CLoadGenerator::sPhaseStats_t& stats = aGenerator.GetStats(phase);
+		const CLatencyHistogram& latency = stats.m_latency;
 
-	Millisecs randTime2wait(time2wait.Value() + randFactor);
+		if (latency.GetCount() == 0)
+		{
+			continue;
+		}
 
-	LogMessage(enLogLevel_Info, "Waiting [%ld msec] before next request", randTime2wait.Value());
+		printf(" %s | %llu | %u | %.3f | %.3f | %.3f | %.3f | %.3f | %.3f | %.3f\n",
+				CLoadGenerator::GetPhaseName(phase), (unsigned long long) latency.GetCount(), stats.m_numOfErrors,
+				ToMsec(latency.GetMin()), ToMsec(latency.GetValueAtPercentile(50)), ToMsec(latency.GetValueAtPercentile(90)),
+				ToMsec(latency.GetValueAtPercentile(99)), ToMsec(latency.GetValueAtPercentile(99.9)), ToMsec(latency.GetMax()),
+				latency.GetMean() / 1000.0);
+	}
 
-	return SleepFor(randTime2wait);
+	double duration = aGenerator.GetDuration();
+	printf("----------------------------------------------------------------------------------------------\n");
+	printf(" %u requests in %.3f sec (%.1f requests per second)\n", aGenerator.GetNumOfRequests(), duration,
+			(duration > 0) ? aGenerator.GetNumOfRequests() / duration : 0);
+	printf("==============================================================================================\n");
 }
 
-void WaitAllDone(std::list<CMpinClient*> aListClients, const Seconds aTimeout)
+bool WriteJson(const CLoadGenerator& aGenerator, const sParams& aParams, const ::String& aFileName)
 {
-	CvShared::TimeValue_t i = 0;
-	size_t notDone = aListClients.size();
-	CvShared::TimeValue_t limit = aTimeout.ToMillisecs();
-	while (notDone > 0 && i < limit)
+	FILE* pFile = fopen(aFileName.c_str(), "w");
+	if (pFile == NULL)
 	{
-		notDone = 0;
-		Millisecs time2wait = Seconds(1);
-		i += time2wait.Value();
+		printf("Failed to open [%s] for writing\n", aFileName.c_str());
+		return false;
+	}
 
-		std::list<CMpinClient*>::iterator itr = aListClients.begin();
-		for (; itr != aListClients.end(); ++itr)
-		{
-			CMpinClient* pClient = *itr;
+	double duration = aGenerator.GetDuration();
+	fprintf(pFile, "{\n");
+	fprintf(pFile, "  \"arrivals\": \"%s\",\n", (aParams.arrivals == CLoadGenerator::enArrivals_Poisson) ? "poisson" : "fixed");
+	fprintf(pFile, "  \"target_rps\": %u,\n", aParams.requestsPerSecond);
+	fprintf(pFile, "  \"achieved_rps\": %.3f,\n", (duration > 0) ? aGenerator.GetNumOfRequests() / duration : 0);
+	fprintf(pFile, "  \"clients\": %u,\n", aParams.numOfClients);
+	fprintf(pFile, "  \"threads\": %u,\n", aParams.numOfThreads);
+	fprintf(pFile, "  \"duration_sec\": %.3f,\n", duration);
+	fprintf(pFile, "  \"phases\": [");
+
+	bool bFirst = true;
+	for (int i = 0; i < CLoadGenerator::enPhase_Count; ++i)
+	{
+		CLoadGenerator::enPhase_t phase = (CLoadGenerator::enPhase_t) i;
+		const CLoadGenerator::sPhaseStats_t& stats = aGenerator.GetStats(phase);
+		const CLatencyHistogram& latency = stats.m_latency;
 
-			if (!pClient->Done())
-			{
-				++notDone;
-				if (i >= limit)
-				{
-					printf("Clients #%d for [%s] is not done yet. Tired waiting...\n", pClient->GetId(), pClient->GetUserId().c_str());
-					LogMessage(enLogLevel_Warning, "Clients #%d for [%s] is not done yet. Tired waiting...", pClient->GetId(), pClient->GetUserId().c_str());
-				}
-			}
+		if (latency.GetCount() == 0)
+		{
+			continue;
 		}
 
-		if (notDone > 0 && i < limit)
+		fprintf(pFile, "%s\n    { \"phase\": \"%s\", \"requests\": %llu, \"errors\": %u, \"min_ms\": %.3f, \"p50_ms\": %.3f, \"p90_ms\": %.3f,"
+				" \"p99_ms\": %.3f, \"p999_ms\": %.3f, \"max_ms\": %.3f, \"avg_ms\": %.3f }",
+				bFirst ? "" : ",", CLoadGenerator::GetPhaseName(phase), (unsigned long long) latency.GetCount(), stats.m_numOfErrors,
+				ToMsec(latency.GetMin()), ToMsec(latency.GetValueAtPercentile(50)), ToMsec(latency.GetValueAtPercentile(90)),
+				ToMsec(latency.GetValueAtPercentile(99)), ToMsec(latency.GetValueAtPercentile(99.9)), ToMsec(latency.GetMax()),
+				latency.GetMean() / 1000.0);
+		bFirst = false;
+	}
+
+	fprintf(pFile, "\n  ]\n}\n");
+	fclose(pFile);
+
+	return true;
+}
+
+bool WriteCsv(const CLoadGenerator& aGenerator, const ::String& aFileName)
+{
+	FILE* pFile = fopen(aFileName.c_str(), "w");
+	if (pFile == NULL)
+	{
+		printf("Failed to open [%s] for writing\n", aFileName.c_str());
+		return false;
+	}
+
+	fprintf(pFile, "phase,requests,errors,min_ms,p50_ms,p90_ms,p99_ms,p999_ms,max_ms,avg_ms\n");
+
+	for (int i = 0; i < CLoadGenerator::enPhase_Count; ++i)
+	{
+		CLoadGenerator::enPhase_t phase = (CLoadGenerator::enPhase_t) i;
+		const CLoadGenerator::sPhaseStats_t& stats = aGenerator.GetStats(phase);
+		const CLatencyHistogram& latency = stats.m_latency;
+
+		if (latency.GetCount() == 0)
 		{
-			printf("Waiting for clients to finish (%ld/%ld). %ld out of %ld not done yet...\n", Millisecs(i).ToSeconds(), Millisecs(limit).ToSeconds(),
-					notDone, aListClients.size());
-			SleepFor(time2wait);
+			continue;
 		}
+
+		fprintf(pFile, "%s,%llu,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+				CLoadGenerator::GetPhaseName(phase), (unsigned long long) latency.GetCount(), stats.m_numOfErrors,
+				ToMsec(latency.GetMin()), ToMsec(latency.GetValueAtPercentile(50)), ToMsec(latency.GetValueAtPercentile(90)),
+				ToMsec(latency.GetValueAtPercentile(99)), ToMsec(latency.GetValueAtPercentile(99.9)), ToMsec(latency.GetMax()),
+				latency.GetMean() / 1000.0);
 	}
+
+	fclose(pFile);
+
+	return true;
 }
 
 int main(int argc, char** argv)
@@ -189,13 +278,20 @@ int main(int argc, char** argv)
 		return -1;
 	}
 
+	if (params.numOfThreads == 0)
+	{
+		PrintUsage(argv[0], "Invalid parameter: -w <worker-threads> must be positive");
+		return -1;
+	}
+
 	CvHttpRequest::COpenSslMt sslMtLock;
 
 	srand(time(NULL));
 
-	std::list<CMpinClient*> listClients;
+	std::vector<CMpinClient*> listClients;
+	std::vector<CMpinClient*> listInitialized;
 
-	for (int i = 0; i < params.numOfClients; ++i)
+	for (uint32_t i = 0; i < params.numOfClients; ++i)
 	{
 		::String userId;
 		if ( params.userId.find("%d") != ::String::npos )
@@ -228,131 +324,63 @@ int main(int argc, char** argv)
 		}
 
 		listClients.push_back(pClient);
+
+		if (pClient->IsInitialized())
+		{
+			listInitialized.push_back(pClient);
+		}
 	}
 
-	std::list<CMpinClient*>::iterator itr;
+	int numOfErrors = listClients.size() - listInitialized.size();
 
-	for (int j = 0; j < params.count; ++j)
+	if (!listInitialized.empty())
 	{
-		if (params.bRegister)
+		// The clients are multiplexed over the worker threads, while arrivals keep coming at the requested rate
+		CLoadGenerator generator(listInitialized, params.numOfThreads, params.requestsPerSecond, params.arrivals);
+
+		for (uint32_t j = 0; j < params.count; ++j)
 		{
-			for (itr = listClients.begin(); itr != listClients.end(); ++itr)
+			if (params.bRegister)
 			{
-				CMpinClient* pClient = *itr;
-
-				if (itr != listClients.begin())
-				{
-					SleepRandTime(params.requestsPerSecond);
-				}
-
-				pClient->Register();
+				generator.RunRegistration();
 			}
-		}
 
-		//	SleepFor( Seconds(5) );
-		//	printf( "Hit any key to continue with authentication..." );
-		//	getchar();
-
-		if (params.bAuthenticate)
-		{
-			//First Authentication will retrieve Time Permits, while the second will work with cached ones.
-//			for (int i = 0; i < 2; ++i)
-//			{
-			for (itr = listClients.begin(); itr != listClients.end(); ++itr)
+			if (params.bAuthenticate)
 			{
-				CMpinClient* pClient = *itr;
-
-				//				pClient->EnableStats(i>0);
-
-				if (itr != listClients.begin())
-				{
-					SleepRandTime(params.requestsPerSecond);
-				}
-
-				bool bAuthBad = ((rand() % 10) == 0);
-
-				if (bAuthBad)
-					pClient->AuthenticateBad();
-				else
-					pClient->AuthenticateGood();
+				generator.RunAuthentication(listInitialized.size(), params.badPinPercent);
 			}
-
-//			if ( i == 0 )
-//			{
-//				WaitAllDone( listClients );
-//				printf( "Hit any key to continue with authentication..." );
-//
-//				getchar();
-//			}
-//		}
 		}
-	}
-
-	SleepFor(Seconds(5));
-	WaitAllDone(listClients, 30 + params.count * 10);
-
-	printf("==============================================================================================\n");
-	printf("Client ID | User ID | # Errors | # Regs | Min.Reg.Time | Max.Reg.Time | Avg.Reg.Time | # Auths | Min.Auth.Time | Max.Auth.Time | Avg.Auth.Time (all times in are in msec)\n");
-	printf("----------------------------------------------------------------------------------------------\n");
 
-	CMpinClient::sStats_t total;
+		PrintReport(generator);
 
-	for (itr = listClients.begin(); itr != listClients.end(); ++itr)
-	{
-		CMpinClient* pClient = *itr;
-		const CMpinClient::sStats_t& stats = pClient->GetStats();
-		printf(" #%d | %s | %d | %d | %d | %d | %d | %d | %d | %d | %d\n",
-				pClient->GetId(), pClient->GetUserId().c_str(), stats.m_numOfErrors,
-				stats.m_numOfReg, stats.m_minRegMsec, stats.m_maxRegMsec, stats.m_avgRegMsec,
-				stats.m_numOfAuth, stats.m_minAuthMsec, stats.m_maxAuthMsec, stats.m_avgAuthMsec);
-
-		total.m_numOfErrors += stats.m_numOfErrors;
-
-		if (stats.m_numOfErrors == 0)
+		if (!params.jsonFile.empty() && !WriteJson(generator, params, params.jsonFile))
 		{
-			if (stats.m_numOfReg > 0)
-			{
-				total.m_avgRegMsec = (total.m_avgRegMsec * total.m_numOfReg + stats.m_avgRegMsec * stats.m_numOfReg) / (total.m_numOfReg + stats.m_numOfReg);
-				total.m_numOfReg += stats.m_numOfReg;
-			}
+			++numOfErrors;
+		}
 
-			if (stats.m_numOfAuth > 0)
-			{
-				total.m_avgAuthMsec = (total.m_avgAuthMsec * total.m_numOfAuth + stats.m_avgAuthMsec * stats.m_numOfAuth) / (total.m_numOfAuth + stats.m_numOfAuth);
-				total.m_numOfAuth += stats.m_numOfAuth;
-			}
+		if (!params.csvFile.empty() && !WriteCsv(generator, params.csvFile))
+		{
+			++numOfErrors;
 		}
 
-		if (stats.m_minRegMsec < total.m_minRegMsec || total.m_minRegMsec == 0)
-			total.m_minRegMsec = stats.m_minRegMsec;
-		if (stats.m_maxRegMsec > total.m_maxRegMsec)
-			total.m_maxRegMsec = stats.m_maxRegMsec;
-		if (stats.m_minAuthMsec < total.m_minAuthMsec || total.m_minAuthMsec == 0)
-			total.m_minAuthMsec = stats.m_minAuthMsec;
-		if (stats.m_maxAuthMsec > total.m_maxAuthMsec)
-			total.m_maxAuthMsec = stats.m_maxAuthMsec;
+		for (int i = 0; i < CLoadGenerator::enPhase_Count; ++i)
+		{
+			numOfErrors += generator.GetStats((CLoadGenerator::enPhase_t) i).m_numOfErrors;
+		}
 	}
 
-	printf(" TOTAL: ======================================================================================\n");
-	printf(" # Errors | # Regs | Min.Reg.Time | Max.Reg.Time | Avg.Reg.Time | # Auths | Min.Auth.Time | Max.Auth.Time | Avg.Auth.Time (all times in are in msec)\n");
-	printf("----------------------------------------------------------------------------------------------\n");
-	printf("  %d | %d | %d | %d | %d | %d | %d | %d | %d\n", total.m_numOfErrors,
-			total.m_numOfReg, total.m_minRegMsec, total.m_maxRegMsec, total.m_avgRegMsec,
-			total.m_numOfAuth, total.m_minAuthMsec, total.m_maxAuthMsec, total.m_avgAuthMsec);
-	printf("==============================================================================================\n");
-
 	printf("Terminating clients...\n");
 
-	for (itr = listClients.begin(); itr != listClients.end(); ++itr)
+	for (std::vector<CMpinClient*>::iterator itr = listClients.begin(); itr != listClients.end(); ++itr)
 	{
 		CMpinClient* pClient = *itr;
 
 		delete pClient;
 	}
 
-	if (total.m_numOfErrors > 0)
+	if (numOfErrors > 0)
 	{
-		printf("Exiting with %d errors :(\n", total.m_numOfErrors);
+		printf("Exiting with %d errors :(\n", numOfErrors);
 	}
 	else
 	{
@@ -361,5 +389,5 @@ int main(int argc, char** argv)
 
 	LogMessage(enLogLevel_Info, "========== M-Pin Test Client Done ==========");
 
-	return ( total.m_numOfErrors > 0) ? -1 : 0;
+	return (numOfErrors > 0) ? -1 : 0;
 }
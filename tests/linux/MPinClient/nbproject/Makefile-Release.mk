@@ -44,6 +44,7 @@ OBJECTFILES= \
 	${OBJECTDIR}/_ext/580510450/CvThread.o \
 	${OBJECTDIR}/_ext/605162843/aes.o \
 	${OBJECTDIR}/_ext/605162843/big.o \
+	${OBJECTDIR}/_ext/605162843/cpu.o \
 	${OBJECTDIR}/_ext/605162843/ecp.o \
 	${OBJECTDIR}/_ext/605162843/ecp2.o \
 	${OBJECTDIR}/_ext/605162843/ff.o \
@@ -57,12 +58,16 @@ OBJECTFILES= \
 	${OBJECTDIR}/_ext/605162843/oct.o \
 	${OBJECTDIR}/_ext/605162843/pair.o \
 	${OBJECTDIR}/_ext/605162843/rand.o \
+	${OBJECTDIR}/_ext/605162843/rand_os.o \
 	${OBJECTDIR}/_ext/605162843/rom.o \
 	${OBJECTDIR}/_ext/605162843/version.o \
 	${OBJECTDIR}/_ext/1386528437/mpin_crypto_non_tee.o \
 	${OBJECTDIR}/_ext/1386528437/mpin_sdk.o \
+	${OBJECTDIR}/_ext/1386528437/secure_memory.o \
 	${OBJECTDIR}/_ext/1386528437/utils.o \
 	${OBJECTDIR}/HttpRequest.o \
+	${OBJECTDIR}/LatencyHistogram.o \
+	${OBJECTDIR}/LoadGenerator.o \
 	${OBJECTDIR}/MpinClient.o \
 	${OBJECTDIR}/main.o
 
@@ -136,6 +141,11 @@ ${OBJECTDIR}/_ext/605162843/big.o: ../../../src/crypto/big.c
 	${RM} "$@.d"
 	$(COMPILE.c) -O2 -I../../../src/crypto -I../../../src -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/605162843/big.o ../../../src/crypto/big.c
 
+${OBJECTDIR}/_ext/605162843/cpu.o: ../../../src/crypto/cpu.c 
+	${MKDIR} -p ${OBJECTDIR}/_ext/605162843
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -I../../../src/crypto -I../../../src -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/605162843/cpu.o ../../../src/crypto/cpu.c
+
 ${OBJECTDIR}/_ext/605162843/ecp.o: ../../../src/crypto/ecp.c 
 	${MKDIR} -p ${OBJECTDIR}/_ext/605162843
 	${RM} "$@.d"
@@ -201,6 +211,11 @@ ${OBJECTDIR}/_ext/605162843/rand.o: ../../../src/crypto/rand.c
 	${RM} "$@.d"
 	$(COMPILE.c) -O2 -I../../../src/crypto -I../../../src -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/605162843/rand.o ../../../src/crypto/rand.c
 
+${OBJECTDIR}/_ext/605162843/rand_os.o: ../../../src/crypto/rand_os.c 
+	${MKDIR} -p ${OBJECTDIR}/_ext/605162843
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -I../../../src/crypto -I../../../src -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/605162843/rand_os.o ../../../src/crypto/rand_os.c
+
 ${OBJECTDIR}/_ext/605162843/rom.o: ../../../src/crypto/rom.c 
 	${MKDIR} -p ${OBJECTDIR}/_ext/605162843
 	${RM} "$@.d"
@@ -221,6 +236,11 @@ ${OBJECTDIR}/_ext/1386528437/mpin_sdk.o: ../../../src/mpin_sdk.cpp
 	${RM} "$@.d"
 	$(COMPILE.cc) -O2 -I../../../src/crypto -I../../../src -I../../../ext/cvshared/cpp/include -I../../../src/json -I../../../src/utf8 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/1386528437/mpin_sdk.o ../../../src/mpin_sdk.cpp
 
+${OBJECTDIR}/_ext/1386528437/secure_memory.o: ../../../src/secure_memory.cpp 
+	${MKDIR} -p ${OBJECTDIR}/_ext/1386528437
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -I../../../src/crypto -I../../../src -I../../../ext/cvshared/cpp/include -I../../../src/json -I../../../src/utf8 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/1386528437/secure_memory.o ../../../src/secure_memory.cpp
+
 ${OBJECTDIR}/_ext/1386528437/utils.o: ../../../src/utils.cpp 
 	${MKDIR} -p ${OBJECTDIR}/_ext/1386528437
 	${RM} "$@.d"
@@ -231,6 +251,16 @@ ${OBJECTDIR}/HttpRequest.o: HttpRequest.cpp
 	${RM} "$@.d"
 	$(COMPILE.cc) -O2 -I../../../src/crypto -I../../../src -I../../../ext/cvshared/cpp/include -I../../../src/json -I../../../src/utf8 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/HttpRequest.o HttpRequest.cpp
 
+${OBJECTDIR}/LatencyHistogram.o: LatencyHistogram.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -I../../../src/crypto -I../../../src -I../../../ext/cvshared/cpp/include -I../../../src/json -I../../../src/utf8 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/LatencyHistogram.o LatencyHistogram.cpp
+
+${OBJECTDIR}/LoadGenerator.o: LoadGenerator.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -I../../../src/crypto -I../../../src -I../../../ext/cvshared/cpp/include -I../../../src/json -I../../../src/utf8 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/LoadGenerator.o LoadGenerator.cpp
+
 ${OBJECTDIR}/MpinClient.o: MpinClient.cpp 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
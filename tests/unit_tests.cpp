@@ -20,8 +20,15 @@ under the License.
 #include "common/test_mpin_sdk.h"
 #include "contexts/auto_context.h"
 #include "common/access_number_thread.h"
+#include "common/alloc_tracker.h"
+#include "mpin_metrics.h"
 #include "CvLogger.h"
 
+extern "C"
+{
+#include "crypto/mpin.h"
+}
+
 #define BOOST_TEST_MODULE Simple testcases
 #include "boost/test/included/unit_test.hpp"
 
@@ -656,3 +663,364 @@ BOOST_AUTO_TEST_CASE(testAuthenticateAN2)
 
     BOOST_MESSAGE("    testAuthenticateAN2 finished");
 }
+
+class RecordedTestName : public TestContext::AutoContextData
+{
+public:
+    virtual String Get() const
+    {
+        return m_name;
+    }
+
+    String m_name;
+};
+
+class MetricsContext : public AutoContext, public MPinSDK::IMetricsListener
+{
+public:
+    MetricsContext(const AutoContextData& autoContextData) : AutoContext(autoContextData) {}
+
+    virtual MPinSDK::IMetricsListener * GetMetricsListener() const
+    {
+        return const_cast<MetricsContext *>(this);
+    }
+
+    virtual void OnSpanBegin(const Span& span)
+    {
+        aggregator.OnSpanBegin(span);
+        trace.OnSpanBegin(span);
+    }
+
+    virtual void OnSpanEnd(const Span& span)
+    {
+        aggregator.OnSpanEnd(span);
+        trace.OnSpanEnd(span);
+    }
+
+    MetricsAggregator aggregator;
+    ChromeTraceRecorder trace;
+};
+
+static const MetricsAggregator::Stats * FindStats(const MetricsAggregator& aggregator, MPinSDK::IMetricsListener::SpanType type, const char *name)
+{
+    const MetricsAggregator::StatsList& stats = aggregator.GetStats();
+    for(MetricsAggregator::StatsList::const_iterator i = stats.begin(); i != stats.end(); ++i)
+    {
+        if(i->type == type && String(i->name) == name)
+        {
+            return &(*i);
+        }
+    }
+    return NULL;
+}
+
+BOOST_AUTO_TEST_CASE(testMetrics)
+{
+    BOOST_MESSAGE("Starting testMetrics...");
+
+    typedef MPinSDK::IMetricsListener IMetricsListener;
+
+    // Replays the requests recorded for testInit and testAuthenticate1
+    RecordedTestName testName;
+    MetricsContext metricsContext(testName);
+    MemBuf buf(RECORDED_DATA_JSON, sizeof(RECORDED_DATA_JSON));
+    std::istream recordedDataInputStream(&buf);
+    metricsContext.EnterRequestPlayerMode(recordedDataInputStream);
+    TestMPinSDK metricsSdk(metricsContext);
+
+    testName.m_name = "testInit";
+    Status s = metricsSdk.Init(config);
+    BOOST_CHECK_EQUAL(s, Status::OK);
+
+    testName.m_name = "testAuthenticate1";
+    UserPtr user = metricsSdk.MakeNewUser("testUser");
+    s = metricsSdk.StartRegistration(user);
+    BOOST_CHECK_EQUAL(s, Status::OK);
+    s = metricsSdk.ConfirmRegistration(user);
+    BOOST_CHECK_EQUAL(s, Status::OK);
+    s = metricsSdk.FinishRegistration(user, "1234");
+    BOOST_CHECK_EQUAL(s, Status::OK);
+    s = metricsSdk.StartAuthentication(user);
+    BOOST_CHECK_EQUAL(s, Status::OK);
+    s = metricsSdk.FinishAuthentication(user, "1234");
+    BOOST_CHECK_EQUAL(s, Status::OK);
+
+    const MetricsAggregator::Stats *stats = FindStats(metricsContext.aggregator, IMetricsListener::HTTP_REQUEST, "GET_CLIENT_SETTINGS");
+    BOOST_CHECK(stats != NULL && stats->count == 1 && stats->failures == 0 && stats->bytesReceived > 0);
+
+    stats = FindStats(metricsContext.aggregator, IMetricsListener::HTTP_REQUEST, "AUTHENTICATE_PASS1");
+    BOOST_CHECK(stats != NULL && stats->count == 1 && stats->bytesSent > 0 && stats->bytesReceived > 0);
+
+    stats = FindStats(metricsContext.aggregator, IMetricsListener::CRYPTO_CALL, "AuthenticatePass1");
+    BOOST_CHECK(stats != NULL && stats->count == 1 && stats->failures == 0);
+
+    stats = FindStats(metricsContext.aggregator, IMetricsListener::CRYPTO_CALL, "Register");
+    BOOST_CHECK(stats != NULL && stats->count == 1);
+
+    stats = FindStats(metricsContext.aggregator, IMetricsListener::STORAGE_ACCESS, "nonsecure/write");
+    BOOST_CHECK(stats != NULL && stats->count > 0 && stats->bytesSent > 0);
+
+    // Every span shows up in the trace as a begin and an end event
+    unsigned long spans = 0;
+    const MetricsAggregator::StatsList& allStats = metricsContext.aggregator.GetStats();
+    for(MetricsAggregator::StatsList::const_iterator i = allStats.begin(); i != allStats.end(); ++i)
+    {
+        spans += i->count;
+    }
+    util::JsonObject trace = metricsContext.trace.ToJson();
+    BOOST_CHECK_EQUAL(((const json::Array&) trace["traceEvents"]).Size(), 2 * spans);
+
+    metricsSdk.DeleteUser(user);
+
+    BOOST_MESSAGE("    testMetrics finished");
+}
+
+BOOST_AUTO_TEST_CASE(testInitStorageError)
+{
+    BOOST_MESSAGE("Starting testInitStorageError...");
+
+    // Users that cannot be loaded fail the initialization, which can be repeated once the storage is fixed
+    RecordedTestName testName;
+    MetricsContext metricsContext(testName);
+    TestMPinSDK metricsSdk(metricsContext);
+    MPinSDK::StringMap noBackendConfig;
+
+    MPinSDK::IStorage *storage = metricsContext.GetStorage(MPinSDK::IStorage::NONSECURE);
+    storage->SetData("{\"backend\":{\"7a\":{}}}");
+    Status s = metricsSdk.Init(noBackendConfig);
+    BOOST_CHECK_EQUAL(s, Status::STORAGE_ERROR);
+
+    storage->SetData("");
+    s = metricsSdk.Init(noBackendConfig);
+    BOOST_CHECK_EQUAL(s, Status::OK);
+
+    // Each attempt read the storage through metrics wrappers of its own
+    const MetricsAggregator::Stats *stats = FindStats(metricsContext.aggregator, MPinSDK::IMetricsListener::STORAGE_ACCESS, "nonsecure/read");
+    BOOST_CHECK(stats != NULL && stats->count == 2);
+
+    metricsSdk.Destroy();
+
+    BOOST_MESSAGE("    testInitStorageError finished");
+}
+
+BOOST_AUTO_TEST_CASE(testNetworkModel)
+{
+    BOOST_MESSAGE("Starting testNetworkModel...");
+
+    // Replays the requests recorded for testInit
+    RecordedTestName testName;
+    testName.m_name = "testInit";
+    AutoContext networkContext(testName);
+    MemBuf buf(RECORDED_DATA_JSON, sizeof(RECORDED_DATA_JSON));
+    std::istream recordedDataInputStream(&buf);
+    networkContext.EnterRequestPlayerMode(recordedDataInputStream);
+    TestMPinSDK networkSdk(networkContext);
+    NetworkModel& networkModel = networkContext.GetNetworkModel();
+
+    String error;
+    BOOST_CHECK(!networkModel.Parse("rtt=fast", error));
+    BOOST_CHECK(!networkModel.Parse("latency=10", error));
+
+    // The SDK stays initialized when the backend fails, so the later requests are made by SetBackend
+    BOOST_CHECK(networkModel.Parse("failures=1", error));
+    Status s = networkSdk.Init(config);
+    BOOST_CHECK_EQUAL(s, Status::NETWORK_ERROR);
+
+    BOOST_CHECK(networkModel.Parse("errors=1", error));
+    s = networkSdk.SetBackend(backend);
+    BOOST_CHECK_EQUAL(s, Status::HTTP_SERVER_ERROR);
+
+    // The connection setup and the request take a round trip each, other hosts are slower
+    BOOST_CHECK(networkModel.Parse("rtt=10,connect=1;m-pindemo.certivox.org@rtt=1000", error));
+    CvShared::TimeSpec start;
+    CvShared::GetCurrentTime(start);
+    s = networkSdk.SetBackend(backend);
+    CvShared::TimeSpec end;
+    CvShared::GetCurrentTime(end);
+    BOOST_CHECK_EQUAL(s, Status::OK);
+    BOOST_CHECK((end - start).ToMillisecs() >= 20);
+    BOOST_CHECK((end - start).ToMillisecs() < 1000);
+
+    BOOST_MESSAGE("    testNetworkModel finished");
+}
+
+BOOST_AUTO_TEST_CASE(testWireDecoding)
+{
+    BOOST_MESSAGE("Starting testWireDecoding...");
+
+    char buf[4];
+    BOOST_CHECK_EQUAL(util::HexDecode("01aB", buf, sizeof(buf)), 2u);
+    BOOST_CHECK_EQUAL(buf[0], 0x01);
+    BOOST_CHECK_EQUAL(buf[1], (char) 0xab);
+
+    // Corrupt data must fail instead of decoding into a wrong key
+    BOOST_CHECK_EQUAL(util::HexDecode("01a", buf, sizeof(buf)), 0u);
+    BOOST_CHECK_EQUAL(util::HexDecode("01zz", buf, sizeof(buf)), 0u);
+    BOOST_CHECK_EQUAL(util::HexDecode("0102030405", buf, sizeof(buf)), 0u);
+    BOOST_CHECK_EQUAL(util::Base64Decode("AQI=", buf, sizeof(buf)), 2u);
+    BOOST_CHECK_EQUAL(util::Base64Decode("AQ*=", buf, sizeof(buf)), 0u);
+
+    util::SecureBuffer decoded;
+    BOOST_CHECK(util::HexDecode("0102", decoded));
+    BOOST_CHECK_EQUAL(decoded.Size(), 2u);
+    BOOST_CHECK(!util::HexDecode("01g2", decoded));
+    BOOST_CHECK(decoded.Empty());
+    BOOST_CHECK(!util::Base64Decode("A-QI", decoded));
+
+    BOOST_MESSAGE("    testWireDecoding finished");
+}
+
+// Counts the allocations made by the AuthenticatePass1 and AuthenticatePass2 crypto calls
+class AllocationsContext : public AutoContext, public MPinSDK::IMetricsListener
+{
+public:
+    AllocationsContext(const AutoContextData& autoContextData) : AutoContext(autoContextData) {}
+
+    virtual MPinSDK::IMetricsListener * GetMetricsListener() const
+    {
+        return const_cast<AllocationsContext *>(this);
+    }
+
+    // Crypto calls do not nest and the storage spans inside them are not measured, so a single scope is enough
+    virtual void OnSpanBegin(const Span& span)
+    {
+        if(span.type == CRYPTO_CALL)
+        {
+            m_scope = AllocTracker::Scope();
+        }
+    }
+
+    virtual void OnSpanEnd(const Span& span)
+    {
+        if(span.type != CRYPTO_CALL)
+        {
+            return;
+        }
+        AllocTracker::Counts counts = m_scope.Get();
+        if(strcmp(span.name, "AuthenticatePass1") == 0)
+        {
+            pass1 = counts;
+        }
+        else if(strcmp(span.name, "AuthenticatePass2") == 0)
+        {
+            pass2 = counts;
+        }
+    }
+
+    AllocTracker::Counts pass1;
+    AllocTracker::Counts pass2;
+
+private:
+    AllocTracker::Scope m_scope;
+};
+
+// A fixed size octet, like the ones of MPinCryptoNonTee
+class TestOctet : public octet
+{
+public:
+    TestOctet()
+    {
+        len = 0;
+        max = sizeof(m_buf);
+        val = m_buf;
+    }
+
+private:
+    char m_buf[12 * PFS];
+};
+
+BOOST_AUTO_TEST_CASE(testAllocations)
+{
+    BOOST_MESSAGE("Starting testAllocations...");
+
+    // Upper bounds for the hot paths that cannot avoid allocations yet - lower them as the allocations are reduced
+    const unsigned long long PASS1_BUDGET = 12;
+    const unsigned long long PASS2_BUDGET = 4;
+
+    if(!AllocTracker::CountsMalloc())
+    {
+        BOOST_MESSAGE("    Only operator new is counted on this platform");
+    }
+
+    // Param lookups
+    util::JsonObject json;
+    json["clientSecretShare"] = json::String("0123456789abcdef0123456789abcdef");
+    json["ttl"] = json::Number(3600);
+    // The checks allocate themselves, so they come after the measured calls
+    AllocTracker::Scope paramsScope;
+    const char *share = json.GetStringParam("clientSecretShare");
+    const char *missing = json.GetStringParam("clientSecretShareMissing", "default");
+    int ttl = json.GetIntParam("ttl");
+    AllocTracker::Counts paramsCounts = paramsScope.Get();
+    BOOST_CHECK_EQUAL(strlen(share), 32);
+    BOOST_CHECK_EQUAL(String(missing), "default");
+    BOOST_CHECK_EQUAL(ttl, 3600);
+    BOOST_CHECK_EQUAL(paramsCounts.allocations, 0);
+    BOOST_CHECK_EQUAL(String(json.GetStringParam("ttl", "wrongType")), "wrongType");
+
+    // The M-Pin client and server passes work on caller provided octets only
+    csprng rng;
+    char seed[32] = { 1 };
+    RAND_seed(&rng, sizeof(seed), seed);
+    int date = today();
+    const int pin = 1234;
+    TestOctet S, SST, ID, HCID, TOKEN, PERMIT, X, Y, SEC, U, UT, HID, HTID, E, F;
+    MPIN_RANDOM_GENERATE(&rng, &S);
+    MPIN_GET_SERVER_SECRET(&S, &SST);
+    ID.len = sprintf(ID.val, "testUser");
+    MPIN_HASH_ID(&ID, &HCID);
+    MPIN_GET_CLIENT_SECRET(&S, &HCID, &TOKEN);
+    MPIN_EXTRACT_PIN(&ID, pin, &TOKEN);
+    MPIN_GET_CLIENT_PERMIT(date, &S, &HCID, &PERMIT);
+    MPIN_RANDOM_GENERATE(&rng, &Y);
+    MPIN_SERVER_1(date, &ID, &HID, &HTID);
+    AllocTracker::Scope client1Scope;
+    int res = MPIN_CLIENT_1(date, &ID, &rng, &X, pin, &TOKEN, &SEC, &U, &UT, &PERMIT);
+    AllocTracker::Counts client1Counts = client1Scope.Get();
+    BOOST_CHECK_EQUAL(res, 0);
+    BOOST_CHECK_EQUAL(client1Counts.allocations, 0);
+
+    res = MPIN_CLIENT_2(&X, &Y, &SEC);
+    BOOST_CHECK_EQUAL(res, 0);
+
+    AllocTracker::Scope server2Scope;
+    res = MPIN_SERVER_2(date, &HID, &HTID, &Y, &SST, &U, &UT, &SEC, &E, &F);
+    AllocTracker::Counts server2Counts = server2Scope.Get();
+    BOOST_CHECK_EQUAL(res, 0);
+    BOOST_CHECK_EQUAL(server2Counts.allocations, 0);
+
+    // The SDK crypto calls, replaying the requests recorded for testInit and testAuthenticate1
+    RecordedTestName testName;
+    AllocationsContext allocationsContext(testName);
+    MemBuf buf(RECORDED_DATA_JSON, sizeof(RECORDED_DATA_JSON));
+    std::istream recordedDataInputStream(&buf);
+    allocationsContext.EnterRequestPlayerMode(recordedDataInputStream);
+    TestMPinSDK allocationsSdk(allocationsContext);
+
+    testName.m_name = "testInit";
+    Status s = allocationsSdk.Init(config);
+    BOOST_CHECK_EQUAL(s, Status::OK);
+
+    testName.m_name = "testAuthenticate1";
+    UserPtr user = allocationsSdk.MakeNewUser("testUser");
+    s = allocationsSdk.StartRegistration(user);
+    BOOST_CHECK_EQUAL(s, Status::OK);
+    s = allocationsSdk.ConfirmRegistration(user);
+    BOOST_CHECK_EQUAL(s, Status::OK);
+    s = allocationsSdk.FinishRegistration(user, "1234");
+    BOOST_CHECK_EQUAL(s, Status::OK);
+    s = allocationsSdk.StartAuthentication(user);
+    BOOST_CHECK_EQUAL(s, Status::OK);
+    s = allocationsSdk.FinishAuthentication(user, "1234");
+    BOOST_CHECK_EQUAL(s, Status::OK);
+
+    BOOST_MESSAGE("    AuthenticatePass1 allocations: " << allocationsContext.pass1.allocations);
+    BOOST_MESSAGE("    AuthenticatePass2 allocations: " << allocationsContext.pass2.allocations);
+    BOOST_CHECK(allocationsContext.pass1.allocations > 0 || !AllocTracker::CountsMalloc());
+    BOOST_CHECK_LE(allocationsContext.pass1.allocations, PASS1_BUDGET);
+    BOOST_CHECK_LE(allocationsContext.pass2.allocations, PASS2_BUDGET);
+
+    allocationsSdk.DeleteUser(user);
+
+    BOOST_MESSAGE("    testAllocations finished");
+}